@@ -32,8 +32,12 @@
 #ifdef _WIN32
 #include <io.h>
 #include <fcntl.h>
+#include <direct.h>
+#include <process.h>
 #else
 #include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #endif
 #include "compiler.h"
 #include "types.h"
@@ -43,10 +47,141 @@
 #define PARSE_ERROR 2
 #define CONTEXT_ERROR 3
 
+/****************************
+ * Appends a file to a build key,
+ * false if it can't be read
+ ****************************/
+static bool AppendBuildInput(const std::wstring& file_name, std::string& key)
+{
+  std::ifstream in(UnicodeToBytes(file_name).c_str(), std::ifstream::binary);
+  if(!in.good()) {
+    return false;
+  }
+
+  key += UnicodeToBytes(file_name);
+  key += '\0';
+  key.append(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  key += '\0';
+
+  return true;
+}
+
+/****************************
+ * Hashes the compiler build, options, sources
+ * and linked libraries of a compilation. Empty
+ * if an input can't be read.
+ ****************************/
+static std::wstring GetBuildKey(const std::wstring& src_files, const std::wstring& opt, std::vector<std::pair<std::wstring, std::wstring> >& programs,
+                                const std::wstring& sys_lib_path, const std::wstring& target, bool alt_syntax, bool is_debug, bool is_mapped)
+{
+  std::string key = std::to_string(VER_NUM) + ' ' + __DATE__ + ' ' + __TIME__ + '\0';
+  key += UnicodeToBytes(opt + L'|' + target + L'|' + sys_lib_path);
+  key += alt_syntax ? 'a' : '-';
+  key += is_debug ? 'd' : '-';
+  key += is_mapped ? 'm' : '-';
+  key += '\0';
+
+  // source files
+  size_t offset = 0;
+  while(offset < src_files.size()) {
+    size_t index = src_files.find(L',', offset);
+    if(index == std::wstring::npos) {
+      index = src_files.size();
+    }
+
+    const std::wstring file_name = src_files.substr(offset, index - offset);
+    if(!file_name.empty() && !AppendBuildInput(file_name, key)) {
+      return L"";
+    }
+    offset = index + 1;
+  }
+
+  // inline sources
+  for(size_t i = 0; i < programs.size(); ++i) {
+    key += UnicodeToBytes(programs[i].second);
+    key += '\0';
+  }
+
+  // linked libraries, located as the linker does
+  const std::wstring lib_path = GetLibraryPath();
+  offset = 0;
+  while(offset < sys_lib_path.size()) {
+    size_t index = sys_lib_path.find(L',', offset);
+    if(index == std::wstring::npos) {
+      index = sys_lib_path.size();
+    }
+
+    const std::wstring file_name = sys_lib_path.substr(offset, index - offset);
+    if(!file_name.empty()) {
+      std::wstring file_path = lib_path + file_name;
+      if(!frontend::EndsWith(file_path, L".obl")) {
+        file_path += L".obl";
+      }
+
+      if(!AppendBuildInput(file_path, key)) {
+        return L"";
+      }
+    }
+    offset = index + 1;
+  }
+
+  wchar_t buffer[32];
+  swprintf(buffer, 32, L"%016llx", (unsigned long long)HashBytes(key.c_str(), key.size()));
+  return buffer;
+}
+
+/****************************
+ * Copies a file by way of a temporary
+ * file, so readers never see a partial copy
+ ****************************/
+static bool CopyBuildFile(const std::wstring& from, const std::wstring& to)
+{
+  std::ifstream in(UnicodeToBytes(from).c_str(), std::ifstream::binary);
+  if(!in.good()) {
+    return false;
+  }
+
+#ifdef _WIN32
+  const std::string temp_name = UnicodeToBytes(to) + '.' + std::to_string(_getpid());
+#else
+  const std::string temp_name = UnicodeToBytes(to) + '.' + std::to_string(getpid());
+#endif
+  std::ofstream out(temp_name.c_str(), std::ofstream::binary);
+  if(!out.good()) {
+    return false;
+  }
+  out << in.rdbuf();
+  out.close();
+
+  const std::string to_name = UnicodeToBytes(to);
+#ifdef _WIN32
+  remove(to_name.c_str());
+#endif
+  if(!out.good() || rename(temp_name.c_str(), to_name.c_str())) {
+    remove(temp_name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
 /****************************
  * Starts the compilation process
  ****************************/
-int Compile(const std::wstring& src_files, const std::wstring& opt, const std::wstring& dest_file, std::vector<std::pair<std::wstring, std::wstring> > &programs, const std::wstring &sys_lib_path, std::wstring &target, bool alt_syntax, bool is_debug, bool show_asm) {
+int Compile(const std::wstring& src_files, const std::wstring& opt, const std::wstring& dest_file, std::vector<std::pair<std::wstring, std::wstring> > &programs, const std::wstring &sys_lib_path, std::wstring &target, bool alt_syntax, bool is_debug, bool show_asm, bool is_mapped, const std::wstring &cache_dir) {
+  // reuse the output of an identical compilation
+  std::wstring cache_file;
+  if(!cache_dir.empty() && !show_asm) {
+    const std::wstring build_key = GetBuildKey(src_files, opt, programs, sys_lib_path, target, alt_syntax, is_debug, is_mapped);
+    if(!build_key.empty()) {
+      cache_file = cache_dir + L'/' + build_key + (target == L"lib" ? L".obl" : L".obe");
+      if(CopyBuildFile(cache_file, dest_file)) {
+        std::wcout << L"Wrote target file: '" << dest_file << L"' from build cache.\n---" << std::endl;
+        return SUCCESS;
+      }
+    }
+  }
+
   // parse source code
   Parser parser(src_files, alt_syntax, programs);
   if(parser.Parse()) {
@@ -63,9 +198,13 @@ int Compile(const std::wstring& src_files, const std::wstring& opt, const std::w
       ItermediateOptimizer optimizer(intermediate.GetProgram(), intermediate.GetUnconditionalLabel(), opt, is_lib, is_debug);
       optimizer.Optimize();
       // emit target code
-      FileEmitter target(optimizer.GetProgram(), is_lib, is_debug, show_asm, dest_file);
+      FileEmitter target(optimizer.GetProgram(), is_lib, is_debug, show_asm, dest_file, is_mapped);
       target.Emit();
 
+      if(!cache_file.empty()) {
+        CopyBuildFile(dest_file, cache_file);
+      }
+
       return SUCCESS;
     }
     else {
@@ -251,7 +390,7 @@ int OptionsCompile(std::map<const std::wstring, std::wstring>& arguments, std::l
   result = arguments.find(L"opt");
   if(result != arguments.end()) {
     optimize = result->second;
-    if(optimize != L"s0" && optimize != L"s1" && optimize != L"s2" && optimize != L"s3") {
+    if(optimize != L"s0" && optimize != L"s1" && optimize != L"s2" && optimize != L"s3" && optimize != L"s4") {
       std::wcerr << usage << std::endl;
       return COMMAND_ERROR;
     }
@@ -282,6 +421,31 @@ int OptionsCompile(std::map<const std::wstring, std::wstring>& arguments, std::l
     argument_options.remove(L"asm");
   }
 
+  // check for build cache directory
+  std::wstring cache_dir;
+  result = arguments.find(L"cache");
+  if(result != arguments.end()) {
+    cache_dir = result->second;
+    if(cache_dir.empty()) {
+      std::wcerr << usage << std::endl;
+      return COMMAND_ERROR;
+    }
+#ifdef _WIN32
+    _mkdir(UnicodeToBytes(cache_dir).c_str());
+#else
+    mkdir(UnicodeToBytes(cache_dir).c_str(), 0755);
+#endif
+    argument_options.remove(L"cache");
+  }
+
+  // check for memory mapped executable flag
+  bool is_mapped = false;
+  result = arguments.find(L"map");
+  if(result != arguments.end()) {
+    is_mapped = true;
+    argument_options.remove(L"map");
+  }
+
   if(argument_options.size() != 0) {
     std::wcerr << usage << std::endl;
     return COMMAND_ERROR;
@@ -290,7 +454,7 @@ int OptionsCompile(std::map<const std::wstring, std::wstring>& arguments, std::l
   std::vector<std::pair<std::wstring, std::wstring> > programs;
   programs.push_back(make_pair(L"blob://program.obs", program));
 
-  return Compile(src_files, optimize, dest_file, programs, sys_lib_path, target, alt_syntax, is_debug, show_asm);
+  return Compile(src_files, optimize, dest_file, programs, sys_lib_path, target, alt_syntax, is_debug, show_asm, is_mapped, cache_dir);
 }
 
 #ifdef _WIN32
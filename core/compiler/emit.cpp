@@ -88,8 +88,8 @@ void FileEmitter::Emit()
   }
   
   OutputStream out_stream(file_name);
-  program->Write(emit_lib, is_debug, out_stream, false);
-  if(out_stream.WriteFile()) {
+  program->Write(emit_lib, is_debug, out_stream, false, is_mapped);
+  if(out_stream.WriteFile(!is_mapped)) {
     std::wcout << L"Wrote target file: '" << file_name << L"'";
     
     if(show_asm) {
@@ -124,18 +124,29 @@ char* FileEmitter::GetBinary()
  ****************************/
 IntermediateProgram* IntermediateProgram::instance;
 
-void IntermediateProgram::Write(bool emit_lib, bool is_debug, OutputStream& out_stream, bool mute) {
+void IntermediateProgram::Write(bool emit_lib, bool is_debug, OutputStream& out_stream, bool mute, bool is_mapped) {
   // version
   WriteInt(VER_NUM, out_stream);
 
-  // magic number
+  // magic number, libraries and mapped executables index method code
+  const bool has_code_section = emit_lib || is_mapped;
   if(emit_lib) {
-    WriteInt(MAGIC_NUM_LIB, out_stream);
+    WriteInt(MAGIC_NUM_LIB_INDEX, out_stream);
+  }
+  else if(is_mapped) {
+    WriteInt(MAGIC_NUM_EXE_MAP, out_stream);
   }
   else {
     WriteInt(MAGIC_NUM_EXE, out_stream);
   }
 
+  // offset of the method code section, set once known
+  size_t code_offset_pos = 0;
+  if(has_code_section) {
+    code_offset_pos = out_stream.Size();
+    WriteInt(0, out_stream);
+  }
+
   // write string id
   if(!emit_lib) {
 #ifdef _DEBUG
@@ -198,7 +209,8 @@ void IntermediateProgram::Write(bool emit_lib, bool is_debug, OutputStream& out_
     }
   }
   
-  // program classes
+  // program classes, mapped executables write method code into a trailing section
+  OutputStream code_stream;
   WriteInt((int)classes.size(), out_stream);
   for(size_t i = 0; i < classes.size(); ++i) {
     if(classes[i]->IsLibrary()) {
@@ -207,7 +219,13 @@ void IntermediateProgram::Write(bool emit_lib, bool is_debug, OutputStream& out_
     else {
       num_src_classes++;
     }
-    classes[i]->Write(emit_lib, out_stream);
+    classes[i]->Write(emit_lib, out_stream, has_code_section ? &code_stream : nullptr);
+  }
+
+  if(has_code_section) {
+    out_stream.Align(sizeof(INT64_VALUE));
+    out_stream.SetInt(code_offset_pos, (int32_t)out_stream.Size());
+    out_stream.Append(code_stream);
   }
   
   if(!mute) {
@@ -226,7 +244,7 @@ void IntermediateProgram::Write(bool emit_lib, bool is_debug, OutputStream& out_
 /****************************
  * Class class
  ****************************/
-void IntermediateClass::Write(bool emit_lib, OutputStream& out_stream) {
+void IntermediateClass::Write(bool emit_lib, OutputStream& out_stream, OutputStream* code_stream) {
   // write id and name
   WriteInt(id, out_stream);
   WriteString(name, out_stream);
@@ -287,14 +305,14 @@ void IntermediateClass::Write(bool emit_lib, OutputStream& out_stream) {
   // write methods
   WriteInt((int)methods.size(), out_stream);
   for(size_t i = 0; i < methods.size(); ++i) {
-    methods[i]->Write(emit_lib, is_debug, out_stream);
+    methods[i]->Write(emit_lib, is_debug, out_stream, code_stream);
   }
 }
 
 /****************************
  * Method class
  **************************/
-void IntermediateMethod::Write(bool emit_lib, bool is_debug, OutputStream& out_stream) {
+void IntermediateMethod::Write(bool emit_lib, bool is_debug, OutputStream& out_stream, OutputStream* code_stream) {
   // write attributes
   WriteInt(id, out_stream);
   
@@ -319,15 +337,21 @@ void IntermediateMethod::Write(bool emit_lib, bool is_debug, OutputStream& out_s
   WriteInt(space, out_stream);
   entries->Write(is_debug, out_stream);
 
-  // write statements
+  // write statements, or their aligned offset into the code section
+  if(code_stream) {
+    code_stream->Align(sizeof(INT64_VALUE));
+    WriteUnsigned((unsigned long)code_stream->Size(), out_stream);
+  }
+  OutputStream& stmt_stream = code_stream ? *code_stream : out_stream;
+
   unsigned long num_instrs = 0;
   for(size_t i = 0; i < blocks.size(); ++i) {
     num_instrs += (int)blocks[i]->GetInstructions().size();
   }
-  WriteUnsigned(num_instrs, out_stream);
+  WriteUnsigned(num_instrs, stmt_stream);
 
   for(size_t i = 0; i < blocks.size(); ++i) {
-    blocks[i]->Write(is_debug, out_stream);
+    blocks[i]->Write(is_debug, stmt_stream);
   }
 }
 
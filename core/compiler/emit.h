@@ -613,7 +613,7 @@ namespace backend {
       blocks = std::move(b);
     }
 
-    void Write(bool emit_lib, bool is_debug, OutputStream &out_stream);
+    void Write(bool emit_lib, bool is_debug, OutputStream &out_stream, OutputStream* code_stream = nullptr);
 
     void Debug();
   };
@@ -791,7 +791,7 @@ namespace backend {
       closure_entries[dclrs] = std::pair<std::wstring, int>(mthd_name, mthd_id);
     }
 
-    void Write(bool emit_lib, OutputStream& out_stream);
+    void Write(bool emit_lib, OutputStream& out_stream, OutputStream* code_stream = nullptr);
     
     void Debug() {
       GetLogger() << L"=========================================================" << std::endl;
@@ -1041,7 +1041,7 @@ namespace backend {
       return aliases_str;
     }
 
-    void Write(bool emit_lib, bool is_debug, OutputStream& out_stream, bool mute);
+    void Write(bool emit_lib, bool is_debug, OutputStream& out_stream, bool mute, bool is_mapped = false);
 
     void Debug() {
       GetLogger() << L"Program: enums=" << enums.size() << L", classes=" << classes.size() << L"; start_ids=" << class_id << L"," << method_id << std::endl;
@@ -1071,6 +1071,7 @@ namespace backend {
     bool emit_lib;
     bool is_debug;
     bool show_asm;
+    bool is_mapped;
 
     std::string ReplaceExt(const std::string &org, const std::string &ext) {
       std::string str(org);
@@ -1084,12 +1085,13 @@ namespace backend {
     }
 
   public:
-    FileEmitter(IntermediateProgram* p, bool l, bool d, bool s, const std::wstring &n) {
+    FileEmitter(IntermediateProgram* p, bool l, bool d, bool s, const std::wstring &n, bool m = false) {
       program = p;
       emit_lib = l;
       is_debug = d;
       show_asm = s;
       file_name = n;
+      is_mapped = m && !l;
 
       if(show_asm) {
         OpenLogger(ReplaceExt(UnicodeToBytes(file_name), "obm"));
@@ -101,6 +101,11 @@ void Linker::ResolveExternalMethodCalls()
     // all classes
     std::vector<LibraryClass*> classes = lib_iter->second->GetClasses();
     for(size_t i = 0; i < classes.size(); ++i) {
+      // only called classes are emitted
+      if(!classes[i]->GetCalled()) {
+        continue;
+      }
+
       // all methods
       std::map<const std::wstring, LibraryMethod*> methods = classes[i]->GetMethods();
       std::map<const std::wstring, LibraryMethod*>::iterator mthd_iter;
@@ -207,7 +212,7 @@ void Linker::ResolveExternalMethodCalls()
   }
 }
 
-std::unordered_map<std::wstring, LibraryAlias*> Linker::GetAllAliasesMap()
+const std::unordered_map<std::wstring, LibraryAlias*> &Linker::GetAllAliasesMap()
 {
   if(all_aliases_map.empty()) {
     std::vector<LibraryAlias*> aliases = GetAllAliases();
@@ -259,7 +264,7 @@ std::vector<LibraryAlias*> Linker::GetAllAliases()
   return all_aliases;
 }
 
-std::unordered_map<std::wstring, LibraryClass*> Linker::GetAllClassesMap()
+const std::unordered_map<std::wstring, LibraryClass*> &Linker::GetAllClassesMap()
 {
   if(all_classes_map.empty()) {
     std::vector<LibraryClass*> klasses = GetAllClasses();
@@ -287,7 +292,7 @@ std::vector<LibraryClass*> Linker::GetAllClasses()
   return all_classes;
 }
 
-std::unordered_map<std::wstring, LibraryEnum*> Linker::GetAllEnumsMap()
+const std::unordered_map<std::wstring, LibraryEnum*> &Linker::GetAllEnumsMap()
 {
   if(all_enums_map.empty()) {
     std::vector<LibraryEnum*> enums = GetAllEnums();
@@ -315,36 +320,36 @@ std::vector<LibraryEnum*> Linker::GetAllEnums()
   return all_enums;
 }
 
-LibraryAlias* Linker::SearchAliasLibraries(const std::wstring& name, std::vector<std::wstring> uses)
+LibraryAlias* Linker::SearchAliasLibraries(const std::wstring& name, const std::vector<std::wstring> &uses)
 {
-  std::unordered_map<std::wstring, LibraryAlias*> alias_map = GetAllAliasesMap();
-  LibraryAlias* alias = alias_map[name];
-  if(alias) {
-    return alias;
+  const std::unordered_map<std::wstring, LibraryAlias*> &alias_map = GetAllAliasesMap();
+  std::unordered_map<std::wstring, LibraryAlias*>::const_iterator result = alias_map.find(name);
+  if(result != alias_map.end()) {
+    return result->second;
   }
 
   for(size_t i = 0; i < uses.size(); ++i) {
-    alias = alias_map[uses[i] + L"." + name];
-    if(alias) {
-      return alias;
+    result = alias_map.find(uses[i] + L"." + name);
+    if(result != alias_map.end()) {
+      return result->second;
     }
   }
 
   return nullptr;
 }
 
-LibraryClass* Linker::SearchClassLibraries(const std::wstring& name, std::vector<std::wstring> uses)
+LibraryClass* Linker::SearchClassLibraries(const std::wstring& name, const std::vector<std::wstring> &uses)
 {
-  std::unordered_map<std::wstring, LibraryClass*> klass_map = GetAllClassesMap();
-  LibraryClass* klass = klass_map[name];
-  if(klass) {
-    return klass;
+  const std::unordered_map<std::wstring, LibraryClass*> &klass_map = GetAllClassesMap();
+  std::unordered_map<std::wstring, LibraryClass*>::const_iterator result = klass_map.find(name);
+  if(result != klass_map.end()) {
+    return result->second;
   }
 
   for(size_t i = 0; i < uses.size(); ++i) {
-    klass = klass_map[uses[i] + L"." + name];
-    if(klass) {
-      return klass;
+    result = klass_map.find(uses[i] + L"." + name);
+    if(result != klass_map.end()) {
+      return result->second;
     }
   }
 
@@ -363,18 +368,18 @@ bool Linker::HasBundleName(const std::wstring& name)
   return false;
 }
 
-LibraryEnum* Linker::SearchEnumLibraries(const std::wstring& name, std::vector<std::wstring> uses)
+LibraryEnum* Linker::SearchEnumLibraries(const std::wstring& name, const std::vector<std::wstring> &uses)
 {
-  std::unordered_map<std::wstring, LibraryEnum*> enum_map = GetAllEnumsMap();
-  LibraryEnum* eenum = enum_map[name];
-  if(eenum) {
-    return eenum;
+  const std::unordered_map<std::wstring, LibraryEnum*> &enum_map = GetAllEnumsMap();
+  std::unordered_map<std::wstring, LibraryEnum*>::const_iterator result = enum_map.find(name);
+  if(result != enum_map.end()) {
+    return result->second;
   }
 
   for(size_t i = 0; i < uses.size(); ++i) {
-    eenum = enum_map[uses[i] + L"." + name];
-    if(eenum) {
-      return eenum;
+    result = enum_map.find(uses[i] + L"." + name);
+    if(result != enum_map.end()) {
+      return result->second;
     }
   }
 
@@ -492,8 +497,8 @@ LibraryClass::LibraryClass(const std::wstring& n, const std::wstring& p, const s
 std::vector<LibraryClass*> LibraryClass::GetLibraryChildren()
 {
   if(!lib_children.size()) {
-    std::map<const std::wstring, const std::wstring> hierarchies = library->GetHierarchies();
-    std::map<const std::wstring, const std::wstring>::iterator iter;
+    const std::map<const std::wstring, const std::wstring> &hierarchies = library->GetHierarchies();
+    std::map<const std::wstring, const std::wstring>::const_iterator iter;
     for(iter = hierarchies.begin(); iter != hierarchies.end(); ++iter) {
       if(iter->second == name) {
         lib_children.push_back(library->GetClass(iter->first));
@@ -628,6 +633,10 @@ void Library::LoadFile(const std::wstring &file_name)
       std::wcerr << L"Unable to use executable '" << file_name << L"' as linked library." << std::endl;
       exit(1);
     }
+    else if(magic_num == MAGIC_NUM_LIB_INDEX) {
+      // method code is decoded when first requested
+      code_buffer = alloc_buffer + ReadUnsigned();
+    }
     else if(magic_num != MAGIC_NUM_LIB) {
       std::wcerr << L"Unable to link invalid library file '" << file_name << L"'." << std::endl;
       exit(1);
@@ -895,13 +904,29 @@ void Library::LoadMethods(LibraryClass* cls, bool is_debug)
     LibraryMethod* mthd = new LibraryMethod(id, name, rtrn_name, type, is_virtual, has_and_or,
                                             is_native, is_static, is_lambda, params, mem_size, cls, entries);
     // load statements
-    LoadStatements(mthd, is_debug);
+    if(code_buffer) {
+      mthd->SetLazyCode(code_buffer + ReadUnsigned(), is_debug);
+    }
+    else {
+      LoadStatements(mthd, is_debug);
+    }
 
     // add method
     cls->AddMethod(mthd);
   }
 }
 
+/****************************
+ * Reads indexed statements
+ ****************************/
+void Library::LoadLazyStatements(LibraryMethod* method, char* code, bool is_debug)
+{
+  char* saved_buffer = buffer;
+  buffer = code;
+  LoadStatements(method, is_debug);
+  buffer = saved_buffer;
+}
+
 /****************************
  * Reads statements
  ****************************/
@@ -1583,6 +1608,17 @@ void Library::LoadStatements(LibraryMethod* method, bool is_debug)
 /******************************
  * LibraryMethod class
  ****************************/
+std::vector<LibraryInstr*> LibraryMethod::GetInstructions()
+{
+  if(lazy_code) {
+    char* code = lazy_code;
+    lazy_code = nullptr;
+    lib_cls->GetLibrary()->LoadLazyStatements(this, code, lazy_debug);
+  }
+
+  return instrs;
+}
+
 void LibraryMethod::ParseDeclarations()
 {
   const std::wstring method_name = name;
@@ -206,6 +206,9 @@ class LibraryMethod {
   int mem_size;
   std::vector<frontend::Type*> declarations;
   backend::IntermediateDeclarations* entries;
+  // indexed instructions, decoded on first request
+  char* lazy_code;
+  bool lazy_debug;
   
   void ParseDeclarations();
   
@@ -243,6 +246,8 @@ class LibraryMethod {
     lib_cls = c;
     entries = e;
     rtrn_type = nullptr;
+    lazy_code = nullptr;
+    lazy_debug = false;
 
     ParseDeclarations();
     ParseReturn();
@@ -332,13 +337,16 @@ class LibraryMethod {
     instrs = is;
   }
 
+  void SetLazyCode(char* c, bool d) {
+    lazy_code = c;
+    lazy_debug = d;
+  }
+
   frontend::Type* GetReturn() {
     return rtrn_type;
   }
 
-  std::vector<LibraryInstr*> GetInstructions() {
-    return instrs;
-  }
+  std::vector<LibraryInstr*> GetInstructions();
 };
 
 /****************************
@@ -510,6 +518,10 @@ class LibraryClass {
     id = i;
   }
 
+  Library* GetLibrary() {
+    return library;
+  }
+
   void SetCalled(bool c) {
     was_called = c;
   }
@@ -714,6 +726,8 @@ class Library {
   std::wstring lib_path;
   char* buffer;
   char* alloc_buffer;
+  // method code section of an indexed library
+  char* code_buffer;
   size_t buffer_size;
   long buffer_pos;
   std::map<const std::wstring, LibraryAlias*> aliases;
@@ -852,7 +866,7 @@ class Library {
  public:
   Library(const std::wstring &p) {
     lib_path = p;
-    alloc_buffer = nullptr;
+    alloc_buffer = code_buffer = nullptr;
   }
 
   ~Library() {
@@ -958,7 +972,7 @@ class Library {
     return class_list;
   }
 
-  std::map<const std::wstring, const std::wstring> GetHierarchies() {
+  const std::map<const std::wstring, const std::wstring> &GetHierarchies() {
     return hierarchies;
   }
 
@@ -974,6 +988,8 @@ class Library {
     return float_strings;
   }
 
+  void LoadLazyStatements(LibraryMethod* mthd, char* code, bool is_debug);
+
   void Load();
 };
 
@@ -1052,39 +1068,44 @@ class Linker {
   std::vector<Library*> GetAllUsedLibraries();
 
   // returns all aliases including duplicates
-  std::unordered_map<std::wstring, LibraryAlias*> GetAllAliasesMap();
+  const std::unordered_map<std::wstring, LibraryAlias*> &GetAllAliasesMap();
 
   // returns all aliases including duplicates
   std::vector<LibraryAlias*> GetAllAliases();
 
   // returns all classes including duplicates
-  std::unordered_map<std::wstring, LibraryClass*> GetAllClassesMap();
+  const std::unordered_map<std::wstring, LibraryClass*> &GetAllClassesMap();
 
   // returns all classes including duplicates
   std::vector<LibraryClass*> GetAllClasses();
 
   // returns all enums including duplicates
-  std::unordered_map<std::wstring, LibraryEnum*> GetAllEnumsMap();
+  const std::unordered_map<std::wstring, LibraryEnum*> &GetAllEnumsMap();
 
   // returns all enums including duplicates
   std::vector<LibraryEnum*> GetAllEnums();
 
   LibraryClass* SearchClassLibraries(const std::wstring &name) {
-    std::unordered_map<std::wstring, LibraryClass*> klass_map = GetAllClassesMap();
-    return klass_map[name];
+    const std::unordered_map<std::wstring, LibraryClass*> &klass_map = GetAllClassesMap();
+    std::unordered_map<std::wstring, LibraryClass*>::const_iterator result = klass_map.find(name);
+    if(result != klass_map.end()) {
+      return result->second;
+    }
+
+    return nullptr;
   }
 
   // check to see if bundle name exists
   bool HasBundleName(const std::wstring &name);
 
   // finds the first alias match; note multiple matches may exist
-  LibraryAlias* SearchAliasLibraries(const std::wstring& name, std::vector<std::wstring> uses);
+  LibraryAlias* SearchAliasLibraries(const std::wstring& name, const std::vector<std::wstring> &uses);
 
   // finds the first class match; note multiple matches may exist
-  LibraryClass* SearchClassLibraries(const std::wstring& name, std::vector<std::wstring> uses);
+  LibraryClass* SearchClassLibraries(const std::wstring& name, const std::vector<std::wstring> &uses);
 
   // finds the first enum match; note multiple matches may exist
-  LibraryEnum* SearchEnumLibraries(const std::wstring& name, std::vector<std::wstring> uses);
+  LibraryEnum* SearchEnumLibraries(const std::wstring& name, const std::vector<std::wstring> &uses);
 
   void Load();
 };
@@ -1,4 +1,4 @@
-ARGS=-O3 -Wall -D_MODULE -std=c++17 -Wno-unused-function
+ARGS=-O3 -Wall -pthread -D_MODULE -std=c++17 -Wno-unused-function
 SRC=types.o tree.o scanner.o parser.o linker.o context.o intermediate.o optimization.o emit.o compiler.o 
 OBJ_LIBS=sys.a
 LOGGER_PATH=../shared
@@ -1,4 +1,4 @@
-ARGS=-O3 -Wall -std=c++17 -D_MODULE -D_ARM64 -Wno-unused-function -Wno-maybe-uninitialized
+ARGS=-O3 -Wall -pthread -std=c++17 -D_MODULE -D_ARM64 -Wno-unused-function -Wno-maybe-uninitialized
 SRC=types.o tree.o scanner.o parser.o linker.o context.o intermediate.o optimization.o emit.o compiler.o 
 LOGGER_PATH=../shared
 OBJ_LIBS=sys.a
@@ -57,6 +57,9 @@ ItermediateOptimizer::ItermediateOptimizer(IntermediateProgram* p, int u, std::w
     else if(o == L"s3") {
       optimization_level = 3;
     }
+    else if(o == L"s4") {
+      optimization_level = 4;
+    }
     else {
       optimization_level = 3;
     }
@@ -364,8 +367,27 @@ std::vector<IntermediateBlock*> ItermediateOptimizer::OptimizeMethod(std::vector
   else {
     return strength_reduced_blocks;
   }
+
+  std::vector<IntermediateBlock*> global_blocks;
+  if(optimization_level > 3) {
+    // global optimizations
+#ifdef _DEBUG
+    GetLogger() << L"  Global optimizations..." << std::endl;
+#endif
+    while(!instruction_replaced_blocks.empty()) {
+      IntermediateBlock* tmp = instruction_replaced_blocks.front();
+      global_blocks.push_back(GlobalOptimize(tmp));
+      // delete old block
+      instruction_replaced_blocks.erase(instruction_replaced_blocks.begin());
+      delete tmp;
+      tmp = nullptr;
+    }
+  }
+  else {
+    return instruction_replaced_blocks;
+  }
   
-  return instruction_replaced_blocks;
+  return global_blocks;
 }
 
 IntermediateBlock* ItermediateOptimizer::RemoveUselessInstructions(IntermediateBlock* inputs)
@@ -1484,6 +1506,18 @@ void ItermediateOptimizer::CalculateIntFold(IntermediateInstruction* instr, std:
     IntermediateInstruction* right = working_stack.front();
     working_stack.pop_front();
 
+    // leave division by zero to the runtime
+    if((instr->GetType() == DIV_INT || instr->GetType() == MOD_INT) && !right->GetOperand7()) {
+      while(!working_stack.empty()) {
+        outputs->AddInstruction(working_stack.back());
+        working_stack.pop_back();
+      }
+      outputs->AddInstruction(right);
+      outputs->AddInstruction(left);
+      outputs->AddInstruction(instr);
+      return;
+    }
+
     switch(instr->GetType()) {
     case ADD_INT: {
       const INT64_VALUE value = left->GetOperand7() + right->GetOperand7();
@@ -1629,3 +1663,656 @@ void ItermediateOptimizer::CalculateFloatFold(IntermediateInstruction* instr, st
     outputs->AddInstruction(instr);
   }
 }
+
+//
+// ------------------- Start: GLOBAL OPTIMIZATIONS -------------------
+//
+
+/****************************
+ * Meets the facts flowing out of
+ * visited predecessors, false if
+ * none have been visited
+ ****************************/
+template<class T> static bool MeetFlow(FlowBlock &block, std::vector<std::map<long, T> > &block_outs,
+                                       std::vector<bool> &visited, std::map<long, T> &facts)
+{
+  bool found = false;
+  for(size_t i = 0; i < block.preds.size(); ++i) {
+    const size_t pred = block.preds[i];
+    if(visited[pred]) {
+      if(!found) {
+        facts = block_outs[pred];
+        found = true;
+      }
+      else {
+        std::map<long, T> &pred_facts = block_outs[pred];
+        typename std::map<long, T>::iterator iter = facts.begin();
+        while(iter != facts.end()) {
+          typename std::map<long, T>::iterator result = pred_facts.find(iter->first);
+          if(result == pred_facts.end() || !(result->second == iter->second)) {
+            iter = facts.erase(iter);
+          }
+          else {
+            ++iter;
+          }
+        }
+      }
+    }
+  }
+
+  return found;
+}
+
+IntermediateBlock* ItermediateOptimizer::GlobalOptimize(IntermediateBlock* inputs)
+{
+  std::vector<IntermediateInstruction*> input_instrs = inputs->GetInstructions();
+
+  // function references span two slots and locals accessed as both
+  // integers and floats are not tracked
+  pinned_locals.clear();
+  std::set<long> int_locals;
+  std::set<long> float_locals;
+  for(size_t i = 0; i < input_instrs.size(); ++i) {
+    IntermediateInstruction* instr = input_instrs[i];
+    if(instr->GetOperand2() == LOCL) {
+      switch(instr->GetType()) {
+      case LOAD_INT_VAR:
+      case STOR_INT_VAR:
+      case COPY_INT_VAR:
+        int_locals.insert(instr->GetOperand());
+        break;
+
+      case LOAD_FLOAT_VAR:
+      case STOR_FLOAT_VAR:
+      case COPY_FLOAT_VAR:
+        float_locals.insert(instr->GetOperand());
+        break;
+
+      case LOAD_FUNC_VAR:
+      case STOR_FUNC_VAR:
+      case COPY_FUNC_VAR:
+        pinned_locals.insert(instr->GetOperand());
+        pinned_locals.insert(instr->GetOperand() + 1);
+        break;
+
+      default:
+        break;
+      }
+    }
+  }
+  for(std::set<long>::iterator iter = float_locals.begin(); iter != float_locals.end(); ++iter) {
+    if(int_locals.find(*iter) != int_locals.end()) {
+      pinned_locals.insert(*iter);
+    }
+  }
+
+  IntermediateBlock* outputs = new IntermediateBlock;
+  outputs->AddInstructions(input_instrs);
+
+  // propagate and fold constants until branches settle
+  for(int i = 0; i < GLOBAL_OPT_PASSES; ++i) {
+    const std::vector<IntermediateInstruction*> prev_instrs = outputs->GetInstructions();
+
+    IntermediateBlock* tmp = outputs;
+    outputs = GlobalConstantProp(tmp);
+    delete tmp;
+
+    tmp = outputs;
+    outputs = FoldIntConstants(tmp);
+    delete tmp;
+
+    tmp = outputs;
+    outputs = FoldFloatConstants(tmp);
+    delete tmp;
+
+    tmp = outputs;
+    outputs = FoldBranches(tmp);
+    delete tmp;
+
+    tmp = outputs;
+    outputs = RemoveUnreachable(tmp);
+    delete tmp;
+
+    if(outputs->GetInstructions() == prev_instrs) {
+      break;
+    }
+  }
+
+  // copies, then stores nothing reads
+  IntermediateBlock* tmp = outputs;
+  outputs = GlobalCopyProp(tmp);
+  delete tmp;
+
+  tmp = outputs;
+  outputs = GlobalDeadStore(tmp);
+  delete tmp;
+
+  tmp = outputs;
+  outputs = CleanJumps(tmp);
+  delete tmp;
+
+  return outputs;
+}
+
+/****************************
+ * Splits a method into basic blocks,
+ * false if a jump target is missing
+ ****************************/
+bool ItermediateOptimizer::BuildFlowGraph(std::vector<IntermediateInstruction*> &instrs, std::vector<FlowBlock> &blocks)
+{
+  std::unordered_map<long, size_t> label_blocks;
+
+  size_t start = 0;
+  for(size_t i = 0; i < instrs.size(); ++i) {
+    IntermediateInstruction* instr = instrs[i];
+    switch(instr->GetType()) {
+    case LBL:
+      if(i > start) {
+        blocks.push_back(FlowBlock(start, i));
+        start = i;
+      }
+      label_blocks[instr->GetOperand()] = blocks.size();
+      break;
+
+    case JMP:
+    case RTRN:
+      blocks.push_back(FlowBlock(start, i + 1));
+      start = i + 1;
+      break;
+
+    default:
+      break;
+    }
+  }
+  if(start < instrs.size()) {
+    blocks.push_back(FlowBlock(start, instrs.size()));
+  }
+
+  // edges
+  for(size_t i = 0; i < blocks.size(); ++i) {
+    IntermediateInstruction* last_instr = instrs[blocks[i].end - 1];
+    bool fall_through = true;
+    if(last_instr->GetType() == JMP) {
+      std::unordered_map<long, size_t>::iterator result = label_blocks.find(last_instr->GetOperand());
+      if(result == label_blocks.end()) {
+        return false;
+      }
+      blocks[i].succs.push_back(result->second);
+      fall_through = last_instr->GetOperand2() > -1;
+    }
+    else if(last_instr->GetType() == RTRN) {
+      fall_through = false;
+    }
+
+    if(fall_through && i + 1 < blocks.size()) {
+      blocks[i].succs.push_back(i + 1);
+    }
+  }
+
+  for(size_t i = 0; i < blocks.size(); ++i) {
+    for(size_t j = 0; j < blocks[i].succs.size(); ++j) {
+      blocks[blocks[i].succs[j]].preds.push_back(i);
+    }
+  }
+
+  return true;
+}
+
+/****************************
+ * True if a local variable that
+ * global optimizations may track
+ ****************************/
+bool ItermediateOptimizer::IsGlobalLocal(IntermediateInstruction* instr)
+{
+  return instr->GetOperand2() == LOCL && pinned_locals.find(instr->GetOperand()) == pinned_locals.end();
+}
+
+/****************************
+ * Replaces loads of locals with
+ * constants that hold on every path
+ ****************************/
+IntermediateBlock* ItermediateOptimizer::GlobalConstantProp(IntermediateBlock* inputs)
+{
+  IntermediateBlock* outputs = new IntermediateBlock;
+
+  std::vector<IntermediateInstruction*> input_instrs = inputs->GetInstructions();
+  std::vector<FlowBlock> blocks;
+  if(!BuildFlowGraph(input_instrs, blocks)) {
+    outputs->AddInstructions(input_instrs);
+    return outputs;
+  }
+
+  // solve, the entry block knows nothing
+  std::vector<std::map<long, GlobalValue> > block_outs(blocks.size());
+  std::vector<bool> visited(blocks.size(), false);
+  bool changed = true;
+  while(changed) {
+    changed = false;
+    for(size_t i = 0; i < blocks.size(); ++i) {
+      std::map<long, GlobalValue> values;
+      if(i > 0 && !MeetFlow(blocks[i], block_outs, visited, values)) {
+        continue;
+      }
+
+      GlobalConstantPropBlock(input_instrs, blocks[i], values, nullptr);
+      if(!visited[i] || !(values == block_outs[i])) {
+        visited[i] = true;
+        block_outs[i] = values;
+        changed = true;
+      }
+    }
+  }
+
+  // rewrite
+  for(size_t i = 0; i < blocks.size(); ++i) {
+    std::map<long, GlobalValue> values;
+    if(i > 0) {
+      MeetFlow(blocks[i], block_outs, visited, values);
+    }
+    GlobalConstantPropBlock(input_instrs, blocks[i], values, outputs);
+  }
+
+  return outputs;
+}
+
+void ItermediateOptimizer::GlobalConstantPropBlock(std::vector<IntermediateInstruction*> &instrs, FlowBlock &block,
+                                                   std::map<long, GlobalValue> &values, IntermediateBlock* outputs)
+{
+  // constant on top of the stack
+  bool is_top = false;
+  GlobalValue top;
+  top.is_float = false;
+  top.value.int_value = 0;
+
+  for(size_t i = block.start; i < block.end; ++i) {
+    IntermediateInstruction* instr = instrs[i];
+
+    switch(instr->GetType()) {
+    case LOAD_INT_LIT:
+      top.is_float = false;
+      top.value.int_value = instr->GetOperand7();
+      is_top = true;
+      break;
+
+    case LOAD_FLOAT_LIT:
+      top.is_float = true;
+      top.value.float_value = instr->GetOperand4();
+      is_top = true;
+      break;
+
+    case LOAD_INT_VAR:
+    case LOAD_FLOAT_VAR: {
+      is_top = false;
+      if(IsGlobalLocal(instr)) {
+        std::map<long, GlobalValue>::iterator result = values.find(instr->GetOperand());
+        if(result != values.end() && result->second.is_float == (instr->GetType() == LOAD_FLOAT_VAR)) {
+          top = result->second;
+          is_top = true;
+          if(outputs) {
+            if(top.is_float) {
+              outputs->AddInstruction(IntermediateFactory::Instance()->MakeInstruction(cur_line_num, LOAD_FLOAT_LIT, top.value.float_value));
+            }
+            else {
+              outputs->AddInstruction(IntermediateFactory::Instance()->MakeIntLitInstruction(cur_line_num, top.value.int_value));
+            }
+          }
+          continue;
+        }
+      }
+    }
+      break;
+
+    case STOR_INT_VAR:
+    case STOR_FLOAT_VAR:
+    case COPY_INT_VAR:
+    case COPY_FLOAT_VAR:
+      if(IsGlobalLocal(instr)) {
+        const bool is_float = instr->GetType() == STOR_FLOAT_VAR || instr->GetType() == COPY_FLOAT_VAR;
+        if(is_top && top.is_float == is_float) {
+          values[instr->GetOperand()] = top;
+        }
+        else {
+          values.erase(instr->GetOperand());
+        }
+      }
+      // copies leave the value on the stack
+      if(instr->GetType() == STOR_INT_VAR || instr->GetType() == STOR_FLOAT_VAR) {
+        is_top = false;
+      }
+      break;
+
+    default:
+      is_top = false;
+      break;
+    }
+
+    if(outputs) {
+      outputs->AddInstruction(instr);
+    }
+  }
+}
+
+/****************************
+ * Resolves conditional jumps
+ * on constants
+ ****************************/
+IntermediateBlock* ItermediateOptimizer::FoldBranches(IntermediateBlock* inputs)
+{
+  std::vector<IntermediateInstruction*> output_instrs;
+
+  std::vector<IntermediateInstruction*> input_instrs = inputs->GetInstructions();
+  for(size_t i = 0; i < input_instrs.size(); ++i) {
+    IntermediateInstruction* instr = input_instrs[i];
+    if(instr->GetType() == JMP && instr->GetOperand2() > -1 &&
+       !output_instrs.empty() && output_instrs.back()->GetType() == LOAD_INT_LIT) {
+      const INT64_VALUE value = output_instrs.back()->GetOperand7();
+      output_instrs.pop_back();
+      // always taken, otherwise never taken
+      if(value == instr->GetOperand2()) {
+        output_instrs.push_back(IntermediateFactory::Instance()->MakeInstruction(cur_line_num, JMP, instr->GetOperand(), -1));
+      }
+    }
+    else {
+      output_instrs.push_back(instr);
+    }
+  }
+
+  IntermediateBlock* outputs = new IntermediateBlock;
+  outputs->AddInstructions(output_instrs);
+  return outputs;
+}
+
+/****************************
+ * Removes basic blocks that can't
+ * be reached from the method entry
+ ****************************/
+IntermediateBlock* ItermediateOptimizer::RemoveUnreachable(IntermediateBlock* inputs)
+{
+  IntermediateBlock* outputs = new IntermediateBlock;
+
+  std::vector<IntermediateInstruction*> input_instrs = inputs->GetInstructions();
+  std::vector<FlowBlock> blocks;
+  if(!BuildFlowGraph(input_instrs, blocks) || blocks.empty()) {
+    outputs->AddInstructions(input_instrs);
+    return outputs;
+  }
+
+  std::vector<bool> reachable(blocks.size(), false);
+  std::vector<size_t> work_list;
+  work_list.push_back(0);
+  reachable[0] = true;
+  while(!work_list.empty()) {
+    FlowBlock &block = blocks[work_list.back()];
+    work_list.pop_back();
+    for(size_t i = 0; i < block.succs.size(); ++i) {
+      if(!reachable[block.succs[i]]) {
+        reachable[block.succs[i]] = true;
+        work_list.push_back(block.succs[i]);
+      }
+    }
+  }
+
+  for(size_t i = 0; i < blocks.size(); ++i) {
+    if(reachable[i]) {
+      for(size_t j = blocks[i].start; j < blocks[i].end; ++j) {
+        outputs->AddInstruction(input_instrs[j]);
+      }
+    }
+  }
+
+  // methods still end with a return
+  std::vector<IntermediateInstruction*> output_instrs = outputs->GetInstructions();
+  if(input_instrs.back()->GetType() == RTRN && (output_instrs.empty() || output_instrs.back()->GetType() != RTRN)) {
+    outputs->AddInstruction(input_instrs.back());
+  }
+
+  return outputs;
+}
+
+/****************************
+ * Replaces loads of locals with loads
+ * of the locals they were copied from
+ ****************************/
+IntermediateBlock* ItermediateOptimizer::GlobalCopyProp(IntermediateBlock* inputs)
+{
+  IntermediateBlock* outputs = new IntermediateBlock;
+
+  std::vector<IntermediateInstruction*> input_instrs = inputs->GetInstructions();
+  std::vector<FlowBlock> blocks;
+  if(!BuildFlowGraph(input_instrs, blocks)) {
+    outputs->AddInstructions(input_instrs);
+    return outputs;
+  }
+
+  // solve, maps a copy to its source
+  std::vector<std::map<long, long> > block_outs(blocks.size());
+  std::vector<bool> visited(blocks.size(), false);
+  bool changed = true;
+  while(changed) {
+    changed = false;
+    for(size_t i = 0; i < blocks.size(); ++i) {
+      std::map<long, long> copies;
+      if(i > 0 && !MeetFlow(blocks[i], block_outs, visited, copies)) {
+        continue;
+      }
+
+      GlobalCopyPropBlock(input_instrs, blocks[i], copies, nullptr);
+      if(!visited[i] || copies != block_outs[i]) {
+        visited[i] = true;
+        block_outs[i] = copies;
+        changed = true;
+      }
+    }
+  }
+
+  // rewrite
+  for(size_t i = 0; i < blocks.size(); ++i) {
+    std::map<long, long> copies;
+    if(i > 0) {
+      MeetFlow(blocks[i], block_outs, visited, copies);
+    }
+    GlobalCopyPropBlock(input_instrs, blocks[i], copies, outputs);
+  }
+
+  return outputs;
+}
+
+void ItermediateOptimizer::GlobalCopyPropBlock(std::vector<IntermediateInstruction*> &instrs, FlowBlock &block,
+                                               std::map<long, long> &copies, IntermediateBlock* outputs)
+{
+  // local loaded on top of the stack
+  long top_local = -1;
+  InstructionType top_type = LOAD_INT_VAR;
+
+  for(size_t i = block.start; i < block.end; ++i) {
+    IntermediateInstruction* instr = instrs[i];
+
+    switch(instr->GetType()) {
+    case LOAD_INT_VAR:
+    case LOAD_FLOAT_VAR:
+      top_local = -1;
+      if(IsGlobalLocal(instr)) {
+        top_local = instr->GetOperand();
+        top_type = instr->GetType();
+        std::map<long, long>::iterator result = copies.find(top_local);
+        if(result != copies.end()) {
+          top_local = result->second;
+          if(outputs) {
+            outputs->AddInstruction(IntermediateFactory::Instance()->MakeInstruction(cur_line_num, top_type, top_local, LOCL));
+          }
+          continue;
+        }
+      }
+      break;
+
+    case STOR_INT_VAR:
+    case STOR_FLOAT_VAR:
+    case COPY_INT_VAR:
+    case COPY_FLOAT_VAR:
+      if(IsGlobalLocal(instr)) {
+        const long local = instr->GetOperand();
+        
+        // kill copies of and from the local
+        copies.erase(local);
+        std::map<long, long>::iterator iter = copies.begin();
+        while(iter != copies.end()) {
+          if(iter->second == local) {
+            iter = copies.erase(iter);
+          }
+          else {
+            ++iter;
+          }
+        }
+
+        const bool is_float = instr->GetType() == STOR_FLOAT_VAR || instr->GetType() == COPY_FLOAT_VAR;
+        if(top_local > -1 && top_local != local && (top_type == LOAD_FLOAT_VAR) == is_float) {
+          copies[local] = top_local;
+        }
+      }
+      // copies leave the value on the stack
+      if(instr->GetType() == STOR_INT_VAR || instr->GetType() == STOR_FLOAT_VAR) {
+        top_local = -1;
+      }
+      break;
+
+    default:
+      top_local = -1;
+      break;
+    }
+
+    if(outputs) {
+      outputs->AddInstruction(instr);
+    }
+  }
+}
+
+/****************************
+ * Removes stores to locals that
+ * are not read on any later path
+ ****************************/
+IntermediateBlock* ItermediateOptimizer::GlobalDeadStore(IntermediateBlock* inputs)
+{
+  IntermediateBlock* outputs = new IntermediateBlock;
+
+  std::vector<IntermediateInstruction*> input_instrs = inputs->GetInstructions();
+  std::vector<FlowBlock> blocks;
+  if(!BuildFlowGraph(input_instrs, blocks)) {
+    outputs->AddInstructions(input_instrs);
+    return outputs;
+  }
+
+  // solve liveness, backwards
+  std::vector<std::set<long> > live_ins(blocks.size());
+  bool changed = true;
+  while(changed) {
+    changed = false;
+    for(int i = (int)blocks.size() - 1; i > -1; --i) {
+      std::set<long> live;
+      for(size_t j = 0; j < blocks[i].succs.size(); ++j) {
+        std::set<long> &succ_live = live_ins[blocks[i].succs[j]];
+        live.insert(succ_live.begin(), succ_live.end());
+      }
+
+      for(size_t j = blocks[i].end; j > blocks[i].start; --j) {
+        UpdateLiveness(input_instrs[j - 1], live);
+      }
+
+      if(live != live_ins[i]) {
+        live_ins[i] = live;
+        changed = true;
+      }
+    }
+  }
+
+  // parameter stores lead the method and are expected by the JIT
+  size_t param_end = 0;
+  while(param_end < input_instrs.size() && input_instrs[param_end]->GetOperand2() == LOCL &&
+        (input_instrs[param_end]->GetType() == STOR_INT_VAR || input_instrs[param_end]->GetType() == STOR_FLOAT_VAR ||
+         input_instrs[param_end]->GetType() == STOR_FUNC_VAR)) {
+    param_end++;
+  }
+
+  // replace dead stores with pops
+  std::vector<IntermediateInstruction*> kept_instrs(input_instrs);
+  for(size_t i = 0; i < blocks.size(); ++i) {
+    std::set<long> live;
+    for(size_t j = 0; j < blocks[i].succs.size(); ++j) {
+      std::set<long> &succ_live = live_ins[blocks[i].succs[j]];
+      live.insert(succ_live.begin(), succ_live.end());
+    }
+
+    for(size_t j = blocks[i].end; j > blocks[i].start; --j) {
+      IntermediateInstruction* instr = input_instrs[j - 1];
+      if(j > param_end && IsGlobalLocal(instr) && live.find(instr->GetOperand()) == live.end()) {
+        switch(instr->GetType()) {
+        case STOR_INT_VAR:
+          kept_instrs[j - 1] = IntermediateFactory::Instance()->MakeInstruction(cur_line_num, POP_INT);
+          break;
+
+        case STOR_FLOAT_VAR:
+          kept_instrs[j - 1] = IntermediateFactory::Instance()->MakeInstruction(cur_line_num, POP_FLOAT);
+          break;
+
+        case COPY_INT_VAR:
+        case COPY_FLOAT_VAR:
+          kept_instrs[j - 1] = nullptr;
+          break;
+
+        default:
+          break;
+        }
+      }
+      UpdateLiveness(instr, live);
+    }
+  }
+
+  // drop loads that are popped right away
+  std::vector<IntermediateInstruction*> output_instrs;
+  for(size_t i = 0; i < kept_instrs.size(); ++i) {
+    IntermediateInstruction* instr = kept_instrs[i];
+    if(!instr) {
+      continue;
+    }
+
+    if(!output_instrs.empty()) {
+      IntermediateInstruction* prev_instr = output_instrs.back();
+      const InstructionType prev_type = prev_instr->GetType();
+      if(instr->GetType() == POP_INT && (prev_type == LOAD_INT_LIT || prev_type == LOAD_CHAR_LIT ||
+                                         (prev_type == LOAD_INT_VAR && prev_instr->GetOperand2() == LOCL))) {
+        output_instrs.pop_back();
+        continue;
+      }
+      else if(instr->GetType() == POP_FLOAT && (prev_type == LOAD_FLOAT_LIT ||
+                                                (prev_type == LOAD_FLOAT_VAR && prev_instr->GetOperand2() == LOCL))) {
+        output_instrs.pop_back();
+        continue;
+      }
+    }
+    output_instrs.push_back(instr);
+  }
+
+  outputs->AddInstructions(output_instrs);
+  return outputs;
+}
+
+void ItermediateOptimizer::UpdateLiveness(IntermediateInstruction* instr, std::set<long> &live)
+{
+  if(IsGlobalLocal(instr)) {
+    switch(instr->GetType()) {
+    case LOAD_INT_VAR:
+    case LOAD_FLOAT_VAR:
+      live.insert(instr->GetOperand());
+      break;
+
+    case STOR_INT_VAR:
+    case STOR_FLOAT_VAR:
+    case COPY_INT_VAR:
+    case COPY_FLOAT_VAR:
+      live.erase(instr->GetOperand());
+      break;
+
+    default:
+      break;
+    }
+  }
+}
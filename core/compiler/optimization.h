@@ -39,6 +39,7 @@ using namespace backend;
 
 #define LOCL_INLINE_MEM_MAX 128
 #define JUMP_OFF_INC 257
+#define GLOBAL_OPT_PASSES 4
 
 /****************************
  * Performs optimizations on
@@ -53,6 +54,10 @@ using namespace backend;
  * 1.5 - constant folding
  * 2.1 - strength reduction
  * 3.1 - replace store+load with copy
+ * 4.1 - global constant propagation and branch folding
+ * 4.2 - unreachable code removal
+ * 4.3 - global copy propagation
+ * 4.4 - global dead store removal
  ****************************/
 
 union PropValue {
@@ -60,6 +65,35 @@ union PropValue {
   double float_value;
 };
 
+/****************************
+ * Constant value of a local
+ * across basic blocks
+ ****************************/
+struct GlobalValue {
+  bool is_float;
+  PropValue value;
+
+  bool operator==(const GlobalValue &rhs) const {
+    return is_float == rhs.is_float && !memcmp(&value, &rhs.value, sizeof(PropValue));
+  }
+};
+
+/****************************
+ * Basic block of a method, as
+ * a range of instructions
+ ****************************/
+struct FlowBlock {
+  size_t start;
+  size_t end;
+  std::vector<size_t> succs;
+  std::vector<size_t> preds;
+
+  FlowBlock(size_t s, size_t e) {
+    start = s;
+    end = e;
+  }
+};
+
 class ItermediateOptimizer {
   IntermediateProgram* program;
   std::set<std::wstring> can_inline;
@@ -70,6 +104,7 @@ class ItermediateOptimizer {
   int cur_line_num;
   bool is_lib;
   int jump_offset;
+  std::set<long> pinned_locals;
   
   std::vector<IntermediateBlock*> OptimizeMethod(std::vector<IntermediateBlock*> input);
   std::vector<IntermediateBlock*> InlineMethod(std::vector<IntermediateBlock*> inputs);
@@ -119,6 +154,21 @@ class ItermediateOptimizer {
   IntermediateBlock* InstructionReplacement(IntermediateBlock* inputs);
   void ReplacementInstruction(IntermediateInstruction* instr, std::deque<IntermediateInstruction*> &calc_stack, IntermediateBlock* outputs);
 
+  // global optimizations
+  IntermediateBlock* GlobalOptimize(IntermediateBlock* inputs);
+  bool BuildFlowGraph(std::vector<IntermediateInstruction*> &instrs, std::vector<FlowBlock> &blocks);
+  bool IsGlobalLocal(IntermediateInstruction* instr);
+  IntermediateBlock* GlobalConstantProp(IntermediateBlock* inputs);
+  void GlobalConstantPropBlock(std::vector<IntermediateInstruction*> &instrs, FlowBlock &block, 
+                               std::map<long, GlobalValue> &values, IntermediateBlock* outputs);
+  IntermediateBlock* FoldBranches(IntermediateBlock* inputs);
+  IntermediateBlock* RemoveUnreachable(IntermediateBlock* inputs);
+  IntermediateBlock* GlobalCopyProp(IntermediateBlock* inputs);
+  void GlobalCopyPropBlock(std::vector<IntermediateInstruction*> &instrs, FlowBlock &block, 
+                           std::map<long, long> &copies, IntermediateBlock* outputs);
+  IntermediateBlock* GlobalDeadStore(IntermediateBlock* inputs);
+  void UpdateLiveness(IntermediateInstruction* instr, std::set<long> &live);
+
   bool CanInlineMethod(IntermediateMethod* mthd_called, std::set<IntermediateMethod*> &inlined_mthds, std::set<int> &lbl_jmp_offsets);
   
   int CanInlineSetterGetter(IntermediateMethod* mthd_called);
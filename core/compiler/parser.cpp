@@ -241,48 +241,75 @@ bool Parser::Parse()
   GetLogger() << L"\n---------- Scanning/Parsing ---------" << std::endl;
 #endif
 
+  // scan inputs concurrently, parse in order
+  std::vector<Scanner*> scanners = ScanInputs();
+  for(size_t i = 0; i < scanners.size(); ++i) {
+    ParseScanner(scanners[i]);
+  }
+
+  return CheckErrors();
+}
+
+/****************************
+ * Scans source files or text
+ * on a pool of threads
+ ****************************/
+std::vector<Scanner*> Parser::ScanInputs()
+{
+  std::vector<std::pair<std::wstring, std::wstring> > inputs;
+
   // parses source path
   if(src_path.size() > 0) {
     size_t offset = 0;
     size_t index = src_path.find(',');
     while(index != std::wstring::npos) {
       const std::wstring &file_name = src_path.substr(offset, index - offset);
-      ParseFile(file_name);
+      inputs.push_back(std::pair<std::wstring, std::wstring>(file_name, L""));
       // update
       offset = index + 1;
       index = src_path.find(',', offset);
     }
     const std::wstring &file_name = src_path.substr(offset, src_path.size());
-    ParseFile(file_name);
+    inputs.push_back(std::pair<std::wstring, std::wstring>(file_name, L""));
+  }
+  else {
+    inputs = programs;
   }
-  else if(programs.size() > 0) {
-    for(size_t i = 0; i < programs.size(); ++i) {
-      ParseText(programs[i]);
+
+  std::vector<Scanner*> scanners(inputs.size());
+  std::atomic<size_t> next_input(0);
+  auto scan = [&]() {
+    for(size_t i = next_input++; i < inputs.size(); i = next_input++) {
+      scanners[i] = new Scanner(inputs[i].first, alt_syntax, inputs[i].second);
     }
+  };
+
+  // debug logging is not thread safe
+#ifdef _DEBUG
+  size_t thread_count = 1;
+#else
+  size_t thread_count = std::min((size_t)std::thread::hardware_concurrency(), inputs.size());
+#endif
+
+  std::vector<std::thread> workers;
+  for(size_t i = 1; i < thread_count; ++i) {
+    workers.push_back(std::thread(scan));
   }
+  scan();
 
-  return CheckErrors();
-}
+  for(size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
 
-/****************************
- * Parses a file.
- ****************************/
-void Parser::ParseFile(const std::wstring &file_name)
-{
-  scanner = new Scanner(file_name, alt_syntax);
-  NextToken();
-  ParseBundle(0);
-  // clean up
-  delete scanner;
-  scanner = nullptr;
+  return scanners;
 }
 
 /****************************
- * Parses std::string
+ * Parses a scanned input
  ****************************/
-void Parser::ParseText(std::pair<std::wstring, std::wstring> &progam)
+void Parser::ParseScanner(Scanner* s)
 {
-  scanner = new Scanner(progam.first, alt_syntax, progam.second);
+  scanner = s;
   NextToken();
   ParseBundle(0);
   // clean up
@@ -2071,6 +2098,12 @@ Statement* Parser::ParseStatement(int depth, bool semi_colon)
       NextToken();
       break;
 
+    case GC_STAT:
+      statement = TreeFactory::Instance()->MakeSystemStatement(file_name, line_num, line_pos, GetLineNumber(), GetLinePosition(),
+                                                               instructions::GC_STAT);
+      NextToken();
+      break;
+
     case EXIT:
       statement = TreeFactory::Instance()->MakeSystemStatement(file_name, line_num, line_pos, GetLineNumber(), GetLinePosition(),
                                                                instructions::EXIT);
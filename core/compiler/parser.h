@@ -33,6 +33,8 @@
 #define __PARSER_H__
 
 #include "scanner.h"
+#include <thread>
+#include <atomic>
 
 using namespace frontend;
 
@@ -163,8 +165,8 @@ class Parser {
   bool CheckErrors();
 
   // parsing operations
-  void ParseFile(const std::wstring &file_name);
-  void ParseText(std::pair<std::wstring, std::wstring>& progam);
+  std::vector<Scanner*> ScanInputs();
+  void ParseScanner(Scanner* s);
   void ParseBundle(int depth);
   Class* ParseClass(const std::wstring& bundle_id, int depth);
   Class* ParseInterface(const std::wstring &bundle_id, int depth);
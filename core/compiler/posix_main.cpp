@@ -56,9 +56,11 @@ int main(int argc, char* argv[])
   usage += L"  -tar:    [output] target type 'lib' for linkable library or 'exe' for executable (the default)\n";
   usage += L"  -dest:   [output] output file name\n";
   usage += L"  -asm:    [output] emits a human readable debug byte assembly file\n";
-  usage += L"  -opt:    [optional] compiler optimizations s0-s3 (s3 being the most aggressive and default)\n";
+  usage += L"  -map:    [output] emits an uncompressed executable that is memory mapped and loaded on demand\n";
+  usage += L"  -opt:    [optional] compiler optimizations s0-s4 (s3 being the default, s4 adds global control flow optimizations)\n";
   usage += L"  -alt:    [optional] use alternative C like syntax\n";
   usage += L"  -debug:  [optional] compile with debug symbols\n";
+  usage += L"  -cache:  [optional] build cache directory, unchanged sources and libraries reuse the prior output\n";
   usage += L"  -strict: [input] exclude default system libraries and specify them manually\n";
   usage += L"\nExample: \"obc hello.obs\"\n\nVersion: ";
   usage += VERSION_STRING;
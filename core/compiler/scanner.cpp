@@ -44,11 +44,6 @@ Scanner::Scanner(std::wstring f, bool a, const std::wstring c)
   alt_syntax = a;
   cur_char = L'\0';
 
-  // create tokens
-  for(int i = 0; i < LOOK_AHEAD; ++i) {
-    tokens[i] = new Token;
-  }
-  
   // load identifiers into map
   LoadKeywords();
   
@@ -77,6 +72,9 @@ Scanner::Scanner(std::wstring f, bool a, const std::wstring c)
   // set line number to 1
   line_nbr = 1;
   line_pos = 1;
+
+  // tokenize input
+  Scan();
 }
 
 /****************************
@@ -89,11 +87,6 @@ Scanner::~Scanner()
     delete[] buffer;
     buffer = nullptr;
   }
-  // delete token array
-  for(int i = 0; i < LOOK_AHEAD; ++i) {
-    delete tokens[i];
-    tokens[i] = nullptr;
-  }
 }
 
 /****************************
@@ -325,6 +318,7 @@ void Scanner::LoadKeywords()
   ident_map[L"SYS_CMD_OUT"] = SYS_CMD_OUT;
   ident_map[L"SET_SIGNAL"] = SET_SIGNAL;
   ident_map[L"RAISE_SIGNAL"] = RAISE_SIGNAL;
+  ident_map[L"GC_STAT"] = GC_STAT;
   ident_map[L"EXIT"] = EXIT;
   ident_map[L"TIMER_START"] = TIMER_START;
   ident_map[L"TIMER_END"] =  TIMER_END;
@@ -615,6 +609,7 @@ void Scanner::CheckIdentifier(int index)
     case SYS_CMD_OUT:
     case SET_SIGNAL:
     case RAISE_SIGNAL:
+    case GC_STAT:
     case EXIT:
     case TIMER_START:
     case TIMER_END:
@@ -672,24 +667,24 @@ void Scanner::CheckIdentifier(int index)
     case DESERL_OBJ_ARY:      
     case DESERL_FLOAT_ARY:
 #endif
-      tokens[index]->SetType(ident_type);
+      tokens[index].SetType(ident_type);
       break;
 
     default:
-      tokens[index]->SetType(TOKEN_IDENT);
-      tokens[index]->SetIdentifier(ident);
+      tokens[index].SetType(TOKEN_IDENT);
+      tokens[index].SetIdentifier(ident);
       break;
     }
     
-    tokens[index]->SetLineNbr(line_nbr);
-	  tokens[index]->SetLinePos((int)(line_pos - length - 1));
-    tokens[index]->SetFileName(filename);
+    tokens[index].SetLineNbr(line_nbr);
+	  tokens[index].SetLinePos((int)(line_pos - length - 1));
+    tokens[index].SetFileName(filename);
   }
   catch(const std::out_of_range&) {
-    tokens[index]->SetType(TOKEN_UNKNOWN);
-    tokens[index]->SetLineNbr(line_nbr);
-    tokens[index]->SetLinePos((int)(line_pos - 1));
-    tokens[index]->SetFileName(filename);
+    tokens[index].SetType(TOKEN_UNKNOWN);
+    tokens[index].SetLineNbr(line_nbr);
+    tokens[index].SetLinePos((int)(line_pos - 1));
+    tokens[index].SetFileName(filename);
   }
 }
 
@@ -700,15 +695,15 @@ void Scanner::CheckString(int index, bool is_valid)
   std::wstring char_string(buffer, start_pos, length);
   // set string
   if(is_valid) {
-    tokens[index]->SetType(TOKEN_CHAR_STRING_LIT);
+    tokens[index].SetType(TOKEN_CHAR_STRING_LIT);
   }
   else {
-    tokens[index]->SetType(TOKEN_BAD_CHAR_STRING_LIT);
+    tokens[index].SetType(TOKEN_BAD_CHAR_STRING_LIT);
   }
-  tokens[index]->SetIdentifier(char_string);
-  tokens[index]->SetLineNbr(line_nbr);
-	tokens[index]->SetLinePos((int)(line_pos - length - 2));
-  tokens[index]->SetFileName(filename);
+  tokens[index].SetIdentifier(char_string);
+  tokens[index].SetLineNbr(line_nbr);
+	tokens[index].SetLinePos((int)(line_pos - length - 2));
+  tokens[index].SetFileName(filename);
 }
 
 void Scanner::ParseInteger(int index, int base /*= 0*/)
@@ -720,22 +715,22 @@ void Scanner::ParseInteger(int index, int base /*= 0*/)
   // parse and check for errors
   wchar_t* ending = nullptr;
   if(base == 2) {
-    tokens[index]->SetInt64Lit(wcstoll(ident.c_str() + 2, &ending, 2));
+    tokens[index].SetInt64Lit(wcstoll(ident.c_str() + 2, &ending, 2));
   }
   else {
-    tokens[index]->SetInt64Lit(wcstoll(ident.c_str(), &ending, base));
+    tokens[index].SetInt64Lit(wcstoll(ident.c_str(), &ending, base));
   }
 
   // set token
   if(wcslen(ending) > 0) {
-    tokens[index]->SetType(TOKEN_UNKNOWN);
+    tokens[index].SetType(TOKEN_UNKNOWN);
   }
   else {
-    tokens[index]->SetType(TOKEN_INT_LIT);
+    tokens[index].SetType(TOKEN_INT_LIT);
   }
-  tokens[index]->SetLineNbr(line_nbr);
-  tokens[index]->SetLinePos((int)(line_pos - length - 1));
-  tokens[index]->SetFileName(filename);
+  tokens[index].SetLineNbr(line_nbr);
+  tokens[index].SetLinePos((int)(line_pos - length - 1));
+  tokens[index].SetFileName(filename);
 }
 
 void Scanner::ParseDouble(int index)
@@ -744,11 +739,11 @@ void Scanner::ParseDouble(int index)
   const size_t length = end_pos - start_pos;
   std::wstring ident(buffer, start_pos, length);
   // set token
-  tokens[index]->SetType(TOKEN_FLOAT_LIT);
-  tokens[index]->SetFloatLit(wcstod(ident.c_str(), nullptr));
-  tokens[index]->SetLineNbr(line_nbr);
-	tokens[index]->SetLinePos((int)(line_pos - length - 1));
-  tokens[index]->SetFileName(filename);
+  tokens[index].SetType(TOKEN_FLOAT_LIT);
+  tokens[index].SetFloatLit(wcstod(ident.c_str(), nullptr));
+  tokens[index].SetLineNbr(line_nbr);
+	tokens[index].SetLinePos((int)(line_pos - length - 1));
+  tokens[index].SetFileName(filename);
 }
 
 void Scanner::ParseUnicodeChar(int index)
@@ -758,17 +753,17 @@ void Scanner::ParseUnicodeChar(int index)
   if(length < 5) {
     std::wstring ident(buffer, start_pos, length);
     // set token
-    tokens[index]->SetType(TOKEN_CHAR_LIT);
-    tokens[index]->SetCharLit((wchar_t)wcstol(ident.c_str(), nullptr, 16));
-    tokens[index]->SetLineNbr(line_nbr);
-    tokens[index]->SetLinePos((int)(line_pos - length - 1));
-    tokens[index]->SetFileName(filename);
+    tokens[index].SetType(TOKEN_CHAR_LIT);
+    tokens[index].SetCharLit((wchar_t)wcstol(ident.c_str(), nullptr, 16));
+    tokens[index].SetLineNbr(line_nbr);
+    tokens[index].SetLinePos((int)(line_pos - length - 1));
+    tokens[index].SetFileName(filename);
   }
   else {
-    tokens[index]->SetType(TOKEN_UNKNOWN);
-    tokens[index]->SetLineNbr(line_nbr);
-    tokens[index]->SetLinePos((int)(line_pos - length - 1));
-    tokens[index]->SetFileName(filename);
+    tokens[index].SetType(TOKEN_UNKNOWN);
+    tokens[index].SetLineNbr(line_nbr);
+    tokens[index].SetLinePos((int)(line_pos - length - 1));
+    tokens[index].SetFileName(filename);
   }
 }
 
@@ -787,31 +782,51 @@ void Scanner::ReadFile()
 }
 
 /****************************
- * Processes the next token
+ * Scans the entire input, so that
+ * files may be tokenized concurrently
  ****************************/
-void Scanner::NextToken()
+void Scanner::Scan()
 {
+  token_pos = 0;
+
   if(!buffer) {
+    tokens.resize(LOOK_AHEAD);
     for(int i = 0; i < LOOK_AHEAD; ++i) {
-      tokens[i]->SetType(TOKEN_END_OF_STREAM);
-      tokens[i]->SetFileName(filename);
-      tokens[i]->SetLineNbr(0);
-      tokens[i]->SetLinePos(0);
-    };
+      tokens[i].SetType(TOKEN_END_OF_STREAM);
+      tokens[i].SetFileName(filename);
+      tokens[i].SetLineNbr(0);
+      tokens[i].SetLinePos(0);
+    }
+    return;
   }
-  else if(is_first_token) {
-    NextChar();
-    for(int i = 0; i < LOOK_AHEAD; ++i) {
-      ParseToken(i);
+
+  // end of stream repeats, so pad the lookahead with it
+  NextChar();
+  int end_count = 0;
+  while(end_count < LOOK_AHEAD) {
+    tokens.push_back(Token());
+    const int index = (int)tokens.size() - 1;
+    ParseToken(index);
+    if(tokens[index].GetType() == TOKEN_END_OF_STREAM) {
+      end_count++;
     }
+  }
+
+  // source no longer needed
+  delete[] buffer;
+  buffer = nullptr;
+}
+
+/****************************
+ * Processes the next token
+ ****************************/
+void Scanner::NextToken()
+{
+  if(is_first_token) {
     is_first_token = false;
   } 
-  else {
-    int i = 1;
-    for(; i < LOOK_AHEAD; ++i) {
-      tokens[i - 1]->Copy(tokens[i]);
-    }
-    ParseToken(i - 1);
+  else if(token_pos + LOOK_AHEAD < tokens.size()) {
+    token_pos++;
   }
 }
 
@@ -821,7 +836,7 @@ void Scanner::NextToken()
 Token* Scanner::GetToken(int index)
 {
   if(index < LOOK_AHEAD) {
-    return tokens[index];
+    return &tokens[token_pos + index];
   }
 
   return nullptr;
@@ -930,7 +945,7 @@ void Scanner::ParseToken(int index)
 {
   // unable to load buffer
   if(!buffer) {
-    tokens[index]->SetType(TOKEN_NO_INPUT);
+    tokens[index].SetType(TOKEN_NO_INPUT);
     return;
   }
   
@@ -1008,7 +1023,7 @@ void Scanner::ParseToken(int index)
         end_pos = buffer_pos - 1;
         ParseUnicodeChar(index);
         if(cur_char != L'\'') {
-          tokens[index]->SetType(TOKEN_UNKNOWN);
+          tokens[index].SetType(TOKEN_UNKNOWN);
         }
         NextChar();
         return;
@@ -1017,78 +1032,78 @@ void Scanner::ParseToken(int index)
       else if(nxt_char == L'\'') {
         switch(cur_char) {
         case L'n':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\n');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\n');
           NextChar();
           NextChar();
           return;
 
         case L'r':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\r');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\r');
           NextChar();
           NextChar();
           return;
 
         case L't':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\t');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\t');
           NextChar();
           NextChar();
           return;
 
         case L'e':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(0x1b);
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(0x1b);
           NextChar();
           NextChar();
           return;
 
         case L'a':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\a');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\a');
           NextChar();
           NextChar();
           return;
 
         case L'b':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\b');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\b');
           NextChar();
           NextChar();
           return;
 
         case L'f':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\f');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\f');
           NextChar();
           NextChar();
           return;
 
         case L'v':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\v');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\v');
           NextChar();
           NextChar();
           return;
 
         case L'\\':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\\');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\\');
           NextChar();
           NextChar();
           return;
 
         case L'\'':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\'');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\'');
           NextChar();
           NextChar();
           return;
 
         case L'0':
-          tokens[index]->SetType(TOKEN_CHAR_LIT);
-          tokens[index]->SetCharLit(L'\0');
+          tokens[index].SetType(TOKEN_CHAR_LIT);
+          tokens[index].SetCharLit(L'\0');
           NextChar();
           NextChar();
           return;
@@ -1096,19 +1111,19 @@ void Scanner::ParseToken(int index)
       }
       // error
       else {
-        tokens[index]->SetType(TOKEN_UNKNOWN);
+        tokens[index].SetType(TOKEN_UNKNOWN);
         NextChar();
         return;
       }
     } else {
       // error
       if(nxt_char != L'\'') {
-        tokens[index]->SetType(TOKEN_UNKNOWN);
+        tokens[index].SetType(TOKEN_UNKNOWN);
         NextChar();
         return;
       } else {
-        tokens[index]->SetType(TOKEN_CHAR_LIT);
-        tokens[index]->SetCharLit(cur_char);
+        tokens[index].SetType(TOKEN_CHAR_LIT);
+        tokens[index].SetCharLit(cur_char);
         NextChar();
         NextChar();
         return;
@@ -1169,7 +1184,7 @@ void Scanner::ParseToken(int index)
       if(cur_char == L'.') {
         // error
         if(double_state || hex_state || bin_state) {
-          tokens[index]->SetType(TOKEN_UNKNOWN);
+          tokens[index].SetType(TOKEN_UNKNOWN);
           NextChar();
           break;
         }
@@ -1178,7 +1193,7 @@ void Scanner::ParseToken(int index)
       else if(!hex_state && !bin_state && (cur_char == L'e' || cur_char == L'E')) {
         // error
         if(double_state != 1) {
-          tokens[index]->SetType(TOKEN_UNKNOWN);
+          tokens[index].SetType(TOKEN_UNKNOWN);
           NextChar();
           break;
         }
@@ -1191,7 +1206,7 @@ void Scanner::ParseToken(int index)
       else if(cur_char == L'x' || cur_char == L'X') {
         // error
         if(double_state) {
-          tokens[index]->SetType(TOKEN_UNKNOWN);
+          tokens[index].SetType(TOKEN_UNKNOWN);
           NextChar();
           break;
         }
@@ -1207,7 +1222,7 @@ void Scanner::ParseToken(int index)
       else if(cur_char == L'b' || cur_char == L'B') {
         // error
         if(double_state) {
-          tokens[index]->SetType(TOKEN_UNKNOWN);
+          tokens[index].SetType(TOKEN_UNKNOWN);
           NextChar();
           break;
         }
@@ -1236,7 +1251,7 @@ void Scanner::ParseToken(int index)
       ParseInteger(index, 2);
     }
     else if(hex_state || bin_state || double_state) {
-      tokens[index]->SetType(TOKEN_UNKNOWN);
+      tokens[index].SetType(TOKEN_UNKNOWN);
     }
     else {
       ParseInteger(index);
@@ -1245,19 +1260,19 @@ void Scanner::ParseToken(int index)
   }
   // other
   else {
-    tokens[index]->SetFileName(filename);
-    tokens[index]->SetLineNbr(line_nbr);
-    tokens[index]->SetLinePos((int)(line_pos - 1));
+    tokens[index].SetFileName(filename);
+    tokens[index].SetLineNbr(line_nbr);
+    tokens[index].SetLinePos((int)(line_pos - 1));
       
     switch(cur_char) {
     case L':':
       if(nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_ASSIGN);
+        tokens[index].SetType(TOKEN_ASSIGN);
         NextChar();
       } 
       else {
-        tokens[index]->SetType(TOKEN_COLON);
+        tokens[index].SetType(TOKEN_COLON);
         NextChar();
       }
       break;
@@ -1265,21 +1280,21 @@ void Scanner::ParseToken(int index)
     case L'-':
       if(nxt_char == L'>') {
         NextChar();
-        tokens[index]->SetType(TOKEN_ASSESSOR);
+        tokens[index].SetType(TOKEN_ASSESSOR);
         NextChar();
       } 
       else if(nxt_char == L'-') {
         NextChar();
-        tokens[index]->SetType(TOKEN_SUB_SUB);
+        tokens[index].SetType(TOKEN_SUB_SUB);
         NextChar();
       }
       else if(nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_SUB_ASSIGN);
+        tokens[index].SetType(TOKEN_SUB_ASSIGN);
         NextChar();
       } 
       else {
-        tokens[index]->SetType(TOKEN_SUB);
+        tokens[index].SetType(TOKEN_SUB);
         NextChar();
       }
       break;
@@ -1287,87 +1302,87 @@ void Scanner::ParseToken(int index)
     case L'!':
       if(alt_syntax && nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_NEQL);
+        tokens[index].SetType(TOKEN_NEQL);
         NextChar();
       }
       else if(alt_syntax) {
-        tokens[index]->SetType(TOKEN_NOT);
+        tokens[index].SetType(TOKEN_NOT);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_UNKNOWN);
+        tokens[index].SetType(TOKEN_UNKNOWN);
         NextChar();
       }
       break;
         
     case L'{':
-      tokens[index]->SetType(TOKEN_OPEN_BRACE);
+      tokens[index].SetType(TOKEN_OPEN_BRACE);
       NextChar();
       break;
 
     case L'.':
-      tokens[index]->SetType(TOKEN_PERIOD);
+      tokens[index].SetType(TOKEN_PERIOD);
       NextChar();
       break;
 
     case L'~':
-      tokens[index]->SetType(TOKEN_TILDE);
+      tokens[index].SetType(TOKEN_TILDE);
       NextChar();
       break;
 
     case L'\\':
-      tokens[index]->SetType(TOKEN_BACK_SLASH);
+      tokens[index].SetType(TOKEN_BACK_SLASH);
       NextChar();
       break;
 
     case L'}':
-      tokens[index]->SetType(TOKEN_CLOSED_BRACE);
+      tokens[index].SetType(TOKEN_CLOSED_BRACE);
       NextChar();
       break;
 
     case L'[':
-      tokens[index]->SetType(TOKEN_OPEN_BRACKET);
+      tokens[index].SetType(TOKEN_OPEN_BRACKET);
       NextChar();
       break;
 
     case L']':
-      tokens[index]->SetType(TOKEN_CLOSED_BRACKET);
+      tokens[index].SetType(TOKEN_CLOSED_BRACKET);
       NextChar();
       break;
 
     case L'(':
-      tokens[index]->SetType(TOKEN_OPEN_PAREN);
+      tokens[index].SetType(TOKEN_OPEN_PAREN);
       NextChar();
       break;
 
     case L')':
-      tokens[index]->SetType(TOKEN_CLOSED_PAREN);
+      tokens[index].SetType(TOKEN_CLOSED_PAREN);
       NextChar();
       break;
 
     case L',':
-      tokens[index]->SetType(TOKEN_COMMA);
+      tokens[index].SetType(TOKEN_COMMA);
       NextChar();
       break;
 
     case L';':
-      tokens[index]->SetType(TOKEN_SEMI_COLON);
+      tokens[index].SetType(TOKEN_SEMI_COLON);
       NextChar();
       break;
 
     case L'^':
-      tokens[index]->SetType(TOKEN_HAT);
+      tokens[index].SetType(TOKEN_HAT);
       NextChar();
       break;
 
     case L'&':
       if(alt_syntax && nxt_char == L'&') {
         NextChar();
-        tokens[index]->SetType(TOKEN_AND);
+        tokens[index].SetType(TOKEN_AND);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_AND);
+        tokens[index].SetType(TOKEN_AND);
         NextChar();
       }
       break;
@@ -1375,17 +1390,17 @@ void Scanner::ParseToken(int index)
     case L'|':
       if(alt_syntax && nxt_char == L'|') {
         NextChar();
-        tokens[index]->SetType(TOKEN_OR);
+        tokens[index].SetType(TOKEN_OR);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_OR);
+        tokens[index].SetType(TOKEN_OR);
         NextChar();
       }
       break;
 
     case L'?':
-      tokens[index]->SetType(TOKEN_QUESTION);
+      tokens[index].SetType(TOKEN_QUESTION);
       NextChar();
       break;
 
@@ -1393,21 +1408,21 @@ void Scanner::ParseToken(int index)
       if(alt_syntax) {
         if(nxt_char == L'=') {
           NextChar();
-          tokens[index]->SetType(TOKEN_EQL);
+          tokens[index].SetType(TOKEN_EQL);
           NextChar();
         }
         else {
-          tokens[index]->SetType(TOKEN_ASSIGN);
+          tokens[index].SetType(TOKEN_ASSIGN);
           NextChar();
         }
       }
       else if(nxt_char == L'>') {
         NextChar();
-        tokens[index]->SetType(TOKEN_LAMBDA);
+        tokens[index].SetType(TOKEN_LAMBDA);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_EQL);
+        tokens[index].SetType(TOKEN_EQL);
         NextChar();
       }
       break;
@@ -1416,26 +1431,26 @@ void Scanner::ParseToken(int index)
       if(nxt_char == L'>') {
         NextChar();
         if(alt_syntax) {
-          tokens[index]->SetType(TOKEN_UNKNOWN);
+          tokens[index].SetType(TOKEN_UNKNOWN);
           NextChar();
         }
         else {
-          tokens[index]->SetType(TOKEN_NEQL);
+          tokens[index].SetType(TOKEN_NEQL);
           NextChar();
         }
       } 
       else if(nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_LEQL);
+        tokens[index].SetType(TOKEN_LEQL);
         NextChar();
       } 
       else if(nxt_char == L'<') {
         NextChar();          
-        tokens[index]->SetType(TOKEN_SHL);
+        tokens[index].SetType(TOKEN_SHL);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_LES);
+        tokens[index].SetType(TOKEN_LES);
         NextChar();
       }
       break;
@@ -1443,16 +1458,16 @@ void Scanner::ParseToken(int index)
     case L'>':
       if(nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_GEQL);
+        tokens[index].SetType(TOKEN_GEQL);
         NextChar();
       }
       else if(nxt_char == L'>') {
         NextChar();
-        tokens[index]->SetType(TOKEN_SHR);
+        tokens[index].SetType(TOKEN_SHR);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_GTR);
+        tokens[index].SetType(TOKEN_GTR);
         NextChar();
       }
       break;
@@ -1460,16 +1475,16 @@ void Scanner::ParseToken(int index)
     case L'+':
       if(nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_ADD_ASSIGN);
+        tokens[index].SetType(TOKEN_ADD_ASSIGN);
         NextChar();
       }
       else if(nxt_char == L'+') {
         NextChar();
-        tokens[index]->SetType(TOKEN_ADD_ADD);
+        tokens[index].SetType(TOKEN_ADD_ADD);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_ADD);
+        tokens[index].SetType(TOKEN_ADD);
         NextChar();
       }
       break;
@@ -1477,11 +1492,11 @@ void Scanner::ParseToken(int index)
     case L'*':
       if(nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_MUL_ASSIGN);
+        tokens[index].SetType(TOKEN_MUL_ASSIGN);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_MUL);
+        tokens[index].SetType(TOKEN_MUL);
         NextChar();
       }
       break;
@@ -1489,57 +1504,57 @@ void Scanner::ParseToken(int index)
     case L'/':
       if(nxt_char == L'=') {
         NextChar();
-        tokens[index]->SetType(TOKEN_DIV_ASSIGN);
+        tokens[index].SetType(TOKEN_DIV_ASSIGN);
         NextChar();
       }
       else {
-        tokens[index]->SetType(TOKEN_DIV);
+        tokens[index].SetType(TOKEN_DIV);
         NextChar();
       }
       break;
 
     case L'%':
-      tokens[index]->SetType(TOKEN_MOD);
+      tokens[index].SetType(TOKEN_MOD);
       NextChar();
       break;
         
       // L'≠':
     case 0x2260:
-      tokens[index]->SetType(TOKEN_NEQL);
+      tokens[index].SetType(TOKEN_NEQL);
       NextChar();
       break;
 
       // L'←':
     case 0x2190:
-      tokens[index]->SetType(TOKEN_ASSIGN);
+      tokens[index].SetType(TOKEN_ASSIGN);
       NextChar();
       break;
 
     // L'→':
     case 0x2192:
-      tokens[index]->SetType(TOKEN_ASSESSOR);
+      tokens[index].SetType(TOKEN_ASSESSOR);
       NextChar();
       break;
 
       // L'≤':
     case 0x2264:
-      tokens[index]->SetType(TOKEN_LEQL);
+      tokens[index].SetType(TOKEN_LEQL);
       NextChar();
       break;
 
       // L'≥':
     case 0x2265:
-      tokens[index]->SetType(TOKEN_GEQL);
+      tokens[index].SetType(TOKEN_GEQL);
       NextChar();
       break;
 
     case EOB:
     case 0xfffd:
-      tokens[index]->SetType(TOKEN_END_OF_STREAM);
+      tokens[index].SetType(TOKEN_END_OF_STREAM);
       break;
 
     default:
-      tokens[index]->SetType(TOKEN_UNKNOWN);
+      tokens[index].SetType(TOKEN_UNKNOWN);
       NextChar();
       break;
     }
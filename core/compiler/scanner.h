@@ -409,6 +409,7 @@ enum ScannerTokenType {
   SYS_CMD_OUT,
   SET_SIGNAL,
   RAISE_SIGNAL,
+  GC_STAT,
   EXIT
 #endif
 };
@@ -542,8 +543,10 @@ class Scanner {
   wchar_t cur_char, nxt_char, nxt_nxt_char;
   // map of reserved identifiers
   std::map<const std::wstring, ScannerTokenType> ident_map;
-  // array of tokens for lookahead
-  Token* tokens[LOOK_AHEAD];
+  // scanned tokens, the last LOOK_AHEAD are end of stream
+  std::vector<Token> tokens;
+  // current token position
+  size_t token_pos;
   // line number
   int line_nbr;
   size_t line_pos;
@@ -568,6 +571,8 @@ class Scanner {
   void LoadKeywords();
   // parses a new token
   void ParseToken(int index);
+  // scans the input buffer into tokens
+  void Scan();
   // check identifier
   void CheckIdentifier(int index);
   // create a random string
@@ -333,7 +333,9 @@ void Runtime::Debugger::ProcessRun() {
     long start = clock();
 #endif
     interpreter = new Runtime::StackInterpreter(cur_program, this);
+    MemoryManager::AddMutator(op_stack, stack_pos, CALC_STACK_SIZE);
     interpreter->Execute(op_stack, stack_pos, 0, cur_program->GetInitializationMethod(), nullptr, false);
+    MemoryManager::RemoveMutator();
 #ifdef _TIMING
     std::wcout << L"# final stack: pos=" << (*stack_pos) << L" #" << std::endl;
     std::wcout << L"---------------------------" << std::endl;
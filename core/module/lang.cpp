@@ -137,7 +137,9 @@ void ObjeckLang::Execute(const std::wstring cmd_args)
   // execute
   Runtime::StackInterpreter* intpr = new Runtime::StackInterpreter(Loader::GetProgram());
   Runtime::StackInterpreter::AddThread(intpr);
+  MemoryManager::AddMutator(op_stack, stack_pos, OP_STACK_SIZE);
   intpr->Execute(op_stack, stack_pos, 0, loader.GetProgram()->GetInitializationMethod(), nullptr, false);
+  MemoryManager::RemoveMutator();
 
 #ifdef _DEBUG
   std::wcout << L"# final std::stack: pos=" << (*stack_pos) << L" #" << std::endl;
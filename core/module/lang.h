@@ -51,7 +51,7 @@ public:
   ~ObjeckLang();
 
   // compile code, 'file_source' are pairs of filename/source instances. this is done bacuase 
-  // source code stored as a string still needs a filename. the 'opt_levl' are "s0" to "s3"
+  // source code stored as a string still needs a filename. the 'opt_levl' are "s0" to "s4"
   bool Compile(std::vector<std::pair<std::wstring, std::wstring>>& file_source, const std::wstring opt_level);
 
   // gets compiler errors
@@ -673,12 +673,12 @@ void Editor::DoOptLevel(std::wstring& in)
 {
   if(in.size() == 2) {
     std::wcout << L"=> Currently optimization level: " << compiler_opt_level << std::endl;
-    std::wcout << L"New level (s0, s1, s2, s3): ";
+    std::wcout << L"New level (s0, s1, s2, s3, s4): ";
     std::getline(std::wcin, in);
 
     in.erase(std::remove_if(in.begin(), in.end(), isspace), in.end());
     if(!in.empty()) {
-      if(in == L"s0" || in == L"s1" || in == L"s2" || in == L"s3") {
+      if(in == L"s0" || in == L"s1" || in == L"s2" || in == L"s3" || in == L"s4") {
         compiler_opt_level = in;
       }
       else {
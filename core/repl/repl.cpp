@@ -114,7 +114,7 @@ void Usage()
   std::wcerr << L"  -file: [optional] source file" << std::endl;
   std::wcerr << L"  -inline: [optional] inline source code" << std::endl;
   std::wcerr << L"  -lib: [optional] list of linked libraries (separated by commas)" << std::endl;
-  std::wcerr << L"  -opt: [optional] compiler optimizations s0-s3 (s3 being the most aggressive and default)" << std::endl;
+  std::wcerr << L"  -opt: [optional] compiler optimizations s0-s4 (s3 being the default, s4 adds global control flow optimizations)" << std::endl;
   std::wcerr << L"  -help: [optional] comand line options" << std::endl;
   std::wcerr << L"  -exit: [optional] shell will exit after command-line execution" << std::endl;
 
@@ -188,6 +188,10 @@ namespace instructions {
     LIB_MTHD_CALL,
     LIB_OBJ_INST_CAST,
     LIB_FUNC_DEF,
+    // superinstructions, only used by the VM
+    INC_LOCL_INT_VAR,
+    CMP_JMP_LOCL_INT_VAR,
+    LOAD_SELF_INT_VAR,
     // system directives
     END_STMTS
   };
@@ -261,6 +261,19 @@ static bool CharacterToBytes(wchar_t in, std::string &out) {
   return true;
 }
 
+/**
+ * 64-bit FNV-1a hash of a byte buffer
+ */
+static uint64_t HashBytes(const char* buffer, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for(size_t i = 0; i < size; ++i) {
+    hash ^= (unsigned char)buffer[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
 /**
  * Byte output stream buffer
  */
@@ -276,7 +289,7 @@ public:
   ~OutputStream() {
   }
 
-  bool WriteFile() {
+  bool WriteFile(bool is_compressed = true) {
     const std::string open_filename = UnicodeToBytes(file_name);
     std::ofstream file_out(open_filename.c_str(), std::ofstream::binary);
     if(!file_out.is_open()) {
@@ -284,6 +297,12 @@ public:
       return false;
     }
 
+    if(!is_compressed) {
+      file_out.write(out_buffer.data(), out_buffer.size());
+      file_out.close();
+      return true;
+    }
+
     unsigned long dest_len;
     char* compressed = CompressZlib(out_buffer.data(), (unsigned long)out_buffer.size(), dest_len);
     if(!compressed) {
@@ -326,6 +345,26 @@ public:
     }
   }
 
+  inline size_t Size() const {
+    return out_buffer.size();
+  }
+
+  // pads with zeros to a multiple of 'size' bytes
+  inline void Align(size_t size) {
+    while(out_buffer.size() % size) {
+      out_buffer.push_back(0);
+    }
+  }
+
+  inline void Append(const OutputStream &in) {
+    out_buffer.insert(out_buffer.end(), in.out_buffer.begin(), in.out_buffer.end());
+  }
+
+  // overwrites a previously written value
+  inline void SetInt(size_t pos, int32_t value) {
+    memcpy(out_buffer.data() + pos, &value, sizeof(value));
+  }
+
   inline void WriteByte(uint8_t value) {
     out_buffer.push_back(value);
   }
@@ -392,39 +431,61 @@ public:
   }
 
   static char* UncompressZlib(const char* src, unsigned long src_len, unsigned long &out_len) {
+    // setup stream
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
 
-    unsigned long buffer_max = src_len << 2;
+    // input
+    stream.next_in = (Bytef*)src;
+    stream.avail_in = (uInt)src_len;
+
+    unsigned long buffer_max = src_len << 3;
     if(buffer_max > COMPRESS_BUFFER_LIMIT) {
       buffer_max = COMPRESS_BUFFER_LIMIT;
     }
     char* buffer = (char*)calloc(buffer_max, sizeof(char));
 
+    if(inflateInit(&stream) != Z_OK) {
+      free(buffer);
+      buffer = nullptr;
+      return nullptr;
+    }
+
+    // grow the output buffer and continue, rather than inflating again from the start
     bool success = false;
     do {
-      out_len = buffer_max;
-      const int status = uncompress((Bytef*)buffer, &out_len, (Bytef*)src, src_len);
-      switch(status) {
-      case Z_OK: // caller frees buffer
-        return buffer;
-
-      case Z_BUF_ERROR:
-        free(buffer);
+      if(stream.total_out >= buffer_max) {
+        char* temp = (char*)realloc(buffer, static_cast<size_t>(buffer_max) << 1);
+        if(!temp) {
+          break;
+        }
+        buffer = temp;
         buffer_max <<= 1;
-        buffer = (char*)calloc(buffer_max, sizeof(char));
-        break;
+      }
 
-      case Z_MEM_ERROR:
-      case Z_DATA_ERROR:
-        free(buffer);
-        buffer = nullptr;
-        return nullptr;
+      stream.next_out = (Bytef*)(buffer + stream.total_out);
+      stream.avail_out = (uInt)(buffer_max - stream.total_out);
+
+      const int status = inflate(&stream, Z_SYNC_FLUSH);
+      if(status == Z_STREAM_END) {
+        success = true;
       }
-    } 
+      else if(status != Z_OK) {
+        break;
+      }
+    }
     while(buffer_max < COMPRESS_BUFFER_LIMIT && !success);
 
-    free(buffer);
-    buffer = nullptr;
-    return nullptr;
+    inflateEnd(&stream);
+    if(!success) {
+      free(buffer);
+      buffer = nullptr;
+      return nullptr;
+    }
+
+    // caller frees buffer
+    out_len = stream.total_out;
+    return buffer;
   }
 
   //
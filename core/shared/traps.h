@@ -226,6 +226,7 @@ namespace instructions {
     SYS_CMD,
     SYS_CMD_OUT,
     ASSERT_TRUE,
+    GC_STAT,
     // end
     EXIT
   };
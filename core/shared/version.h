@@ -37,6 +37,8 @@
 
 #define MAGIC_NUM_EXE 0xffbe // bitmask 'e'
 #define MAGIC_NUM_LIB 0xffb6 // bitmask 'k'
+#define MAGIC_NUM_LIB_INDEX 0xffb7 // library with indexed method code, decoded on use
+#define MAGIC_NUM_EXE_MAP 0xffbd // uncompressed executable, method code decoded on first use
 
 #define VER_NUM 2023100
 #define VERSION_STRING L"2023.10.0"
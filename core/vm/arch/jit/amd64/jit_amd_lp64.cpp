@@ -35,10 +35,19 @@
 using namespace Runtime;
 
 PageManager* JitAmd64::page_manager;
+bool JitAmd64::local_registers;
+std::string JitAmd64::cache_dir;
 
 void JitAmd64::Initialize(StackProgram* p) {
   JitCompiler::Initialize(p);
   page_manager = new PageManager;
+  local_registers = p->GetProperty(L"jit-registers") != L"false";
+#ifndef _WIN64
+  cache_dir = UnicodeToBytes(p->GetProperty(L"jit-cache"));
+  if(!cache_dir.empty()) {
+    mkdir(cache_dir.c_str(), 0755);
+  }
+#endif
 }
 
 void JitAmd64::Prolog() {
@@ -184,6 +193,113 @@ void JitAmd64::RegisterRoot() {
   ReleaseRegister(holder);
 }
 
+void JitAmd64::ProcessMethodInfo() {
+#ifdef _WIN64    
+  move_reg_mem(RCX, CLS_ID, RBP);
+  move_reg_mem(RDX, MTHD_ID, RBP);
+  move_reg_mem(R8, CLASS_MEM, RBP);
+  move_reg_mem(R9, INSTANCE_MEM, RBP);
+#else
+  move_reg_mem(RDI, CLS_ID, RBP);
+  move_reg_mem(RSI, MTHD_ID, RBP);
+  move_reg_mem(RDX, CLASS_MEM, RBP);
+  move_reg_mem(RCX, INSTANCE_MEM, RBP);
+  move_reg_mem(R8, OP_STACK, RBP);
+  move_reg_mem(R9, STACK_POS, RBP);
+#endif
+}
+
+/**
+ * Adds an entry for each loop header, used to move an interpreted
+ * method into JIT code while it loops (on-stack replacement). An entry
+ * sets up the frame like a call, copies the interpreter's locals to
+ * the native stack and jumps to the loop header.
+ */
+void JitAmd64::ProcessOsrEntries() {
+  // loop headers are the targets of backward jumps
+  std::set<long> headers;
+  for(long i = 0; i < method->GetInstructionCount(); ++i) {
+    StackInstr* instr = method->GetInstruction(i);
+    if(instr->GetType() == JMP && instr->GetOperand() < i) {
+      headers.insert(instr->GetOperand());
+    }
+  }
+  
+  if(headers.empty()) {
+    return;
+  }
+
+  // native stack offsets of locals, function variables use two slots
+  std::map<long, std::pair<long, bool> > locals;
+  for(long i = 0; i < method->GetInstructionCount(); ++i) {
+    StackInstr* instr = method->GetInstruction(i);
+    switch(instr->GetType()) {
+    case LOAD_LOCL_INT_VAR:
+    case INC_LOCL_INT_VAR:
+    case CMP_JMP_LOCL_INT_VAR:
+    case STOR_LOCL_INT_VAR:
+    case COPY_LOCL_INT_VAR:
+    case LOAD_FLOAT_VAR:
+    case STOR_FLOAT_VAR:
+    case COPY_FLOAT_VAR:
+    case LOAD_FUNC_VAR:
+    case STOR_FUNC_VAR:
+      if(instr->GetOperand2() == LOCL) {
+        const bool is_func = instr->GetType() == LOAD_FUNC_VAR || instr->GetType() == STOR_FUNC_VAR;
+        locals[instr->GetOperand()] = std::pair<long, bool>(instr->GetOperand3(), is_func);
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  const long frame_space = local_space;
+  for(std::set<long>::iterator header = headers.begin(); header != headers.end(); ++header) {
+#ifdef _DEBUG_JIT
+    std::wcout << L"OSR entry: index=" << (*header) << L"; offset=" << code_index << std::endl;
+#endif
+    osr_entries[*header] = code_index;
+
+    // same frame as a call
+    local_space = org_local_space;
+    Prolog();
+    ProcessMethodInfo();
+    // the root is cleared in a loop counted by RCX, allocate it last
+    std::stable_partition(aval_regs.begin(), aval_regs.end(), 
+                          [](RegisterHolder* h) { return h->GetRegister() == RCX; });
+    RegisterRoot();
+
+    // interpreter locals follow the instance in the frame that holds the JIT memory
+    RegisterHolder* mem_holder = GetRegister();
+    move_mem_reg(JIT_MEM, RBP, mem_holder->GetRegister());
+    move_mem_reg((long)offsetof(StackFrame, mem) - (long)offsetof(StackFrame, jit_mem),
+                 mem_holder->GetRegister(), mem_holder->GetRegister());
+
+    RegisterHolder* value_holder = GetRegister();
+    for(std::map<long, std::pair<long, bool> >::iterator local = locals.begin(); local != locals.end(); ++local) {
+      const long mem_offset = (local->first + 1) * sizeof(size_t);
+      const long jit_offset = local->second.first;
+      move_mem_reg(mem_offset, mem_holder->GetRegister(), value_holder->GetRegister());
+      move_reg_mem(value_holder->GetRegister(), jit_offset, RBP);
+      if(local->second.second) {
+        move_mem_reg(mem_offset + sizeof(size_t), mem_holder->GetRegister(), value_holder->GetRegister());
+        move_reg_mem(value_holder->GetRegister(), jit_offset + sizeof(size_t), RBP);
+      }
+    }
+    ReleaseRegister(value_holder);
+    ReleaseRegister(mem_holder);
+    LoadLocals(*header, true);
+
+    // continue in the loop
+    AddMachineCode(0xe9);
+    const long offset = method->GetInstruction(*header)->GetOffset() - (code_index + 4);
+    AddImm(offset);
+  }
+  local_space = frame_space;
+}
+
 void JitAmd64::ProcessParameters(long params) {
 #ifdef _DEBUG_JIT
   std::wcout << L"CALLED_PARMS: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
@@ -195,6 +311,8 @@ void JitAmd64::ProcessParameters(long params) {
 
     StackInstr* instr = method->GetInstruction(instr_index++);
     instr->SetOffset(code_index);  
+    local_index = instr_index - 1;
+    LoadLocals(local_index, false);
 
     RegisterHolder* stack_pos_holder = GetRegister();
     move_mem_reg(STACK_POS, RBP, stack_pos_holder->GetRegister());
@@ -348,6 +466,8 @@ void JitAmd64::ProcessInstructions() {
   while(instr_index < method->GetInstructionCount() && compile_success) {
     StackInstr* instr = method->GetInstruction(instr_index++);
     instr->SetOffset(code_index);
+    local_index = instr_index - 1;
+    LoadLocals(local_index, false);
     
     switch(instr->GetType()) {
       // load literal
@@ -370,8 +490,9 @@ void JitAmd64::ProcessInstructions() {
       working_stack.push_front(new RegInstr(&float_consts[floats_index++]));
       break;
       
-      // load self
-    case LOAD_INST_MEM: {
+      // load self, superinstruction is compiled as its first instruction
+    case LOAD_INST_MEM:
+    case LOAD_SELF_INT_VAR: {
 #ifdef _DEBUG_JIT
       std::wcout << L"LOAD_INST_MEM; regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
@@ -388,9 +509,11 @@ void JitAmd64::ProcessInstructions() {
     }
       break;
       
-      // load variable
+      // load variable, superinstructions are compiled as their first instruction
     case LOAD_LOCL_INT_VAR:
-    case LOAD_CLS_INST_INT_VAR:   
+    case INC_LOCL_INT_VAR:
+    case CMP_JMP_LOCL_INT_VAR:
+    case LOAD_CLS_INST_INT_VAR:
     case LOAD_FLOAT_VAR:
     case LOAD_FUNC_VAR:
 #ifdef _DEBUG_JIT
@@ -571,8 +694,8 @@ void JitAmd64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"DYN_MTHD_CALL: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif  
-      // passing instance variable
-      ProcessStackCallback(DYN_MTHD_CALL, instr, instr_index, instr->GetOperand() + 3);
+      // passing instance and packed class/method ids
+      ProcessStackCallback(DYN_MTHD_CALL, instr, instr_index, instr->GetOperand() + 2);
       ProcessReturnParameters((MemoryType)instr->GetOperand2());
     }
       break;
@@ -693,7 +816,7 @@ void JitAmd64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_BYTE_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_BYTE_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_BYTE_ARY, instr, instr_index, 1);
     }
       break;
 
@@ -701,7 +824,7 @@ void JitAmd64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_CHAR_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_CHAR_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_CHAR_ARY, instr, instr_index, 1);
     }
       break;
 
@@ -709,7 +832,7 @@ void JitAmd64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_INT_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_INT_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_INT_ARY, instr, instr_index, 1);
     }
       break;
 
@@ -717,7 +840,7 @@ void JitAmd64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_FLOAT_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_FLOAT_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_FLOAT_ARY, instr, instr_index, 1);
     }
       break;
 
@@ -847,7 +970,7 @@ void JitAmd64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"S2F: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(S2F, instr, instr_index, 2);
+      ProcessStackCallback(S2F, instr, instr_index, 1);
       ProcessReturnParameters(FLOAT_TYPE);
       break;
       
@@ -873,8 +996,7 @@ void JitAmd64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"LOAD_ARY_SIZE: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(LOAD_ARY_SIZE, instr, instr_index, 1);
-      ProcessReturnParameters(INT_TYPE);
+      ProcessArraySize(instr);
     }
       break;
       
@@ -918,14 +1040,18 @@ void JitAmd64::ProcessInstructions() {
 #endif
       break;
       
+      // unsupported, method is interpreted
     default: {
+#ifdef _DEBUG_JIT
       InstructionType error = (InstructionType)instr->GetType();
-      std::wcerr << L"Unknown instruction: " << error << L"!" << std::endl;
-      exit(1);
+      std::wcerr << L"Unsupported instruction: " << error << L"!" << std::endl;
+#endif
+      compile_success = false;
     }
       break;
     }
   }
+  local_index = -1;
 }
 
 void JitAmd64::ProcessLoad(StackInstr* instr) {
@@ -949,6 +1075,26 @@ void JitAmd64::ProcessLoad(StackInstr* instr) {
     RegInstr* left = working_stack.front();
     working_stack.pop_front();
 
+    // field loaded before the loop
+    Register load_reg;
+    if(left->GetType() == MEM_INT && (left->GetOperand() == CLASS_MEM || left->GetOperand() == INSTANCE_MEM) &&
+       instr->GetType() != LOAD_FUNC_VAR && GetLoadRegister((long)left->GetOperand(), instr->GetOperand3(), load_reg)) {
+      if(instr->GetType() == LOAD_FLOAT_VAR) {
+        RegisterHolder* xmm_holder = GetXmmRegister();
+        move_xreg_xreg(load_reg, xmm_holder->GetRegister());
+        working_stack.push_front(new RegInstr(xmm_holder));
+      }
+      else {
+        RegisterHolder* holder = GetRegister();
+        move_reg_reg(load_reg, holder->GetRegister());
+        working_stack.push_front(new RegInstr(holder));
+      }
+
+      delete left;
+      left = nullptr;
+      return;
+    }
+
     RegisterHolder* holder;
     if(left->GetType() == REG_INT) {
       holder = left->GetRegister();
@@ -987,12 +1133,61 @@ void JitAmd64::ProcessLoad(StackInstr* instr) {
   }
 }
 
+void JitAmd64::ProcessArraySize(StackInstr* instr) {
+  RegInstr* left = working_stack.front();
+  working_stack.pop_front();
+
+  // size loaded before the loop
+  Register load_reg;
+  std::unordered_map<long, long>::iterator size_load = size_loads.find(local_index);
+  if(size_load != size_loads.end() && GetLoadRegister(size_load->second, 2 * sizeof(size_t), load_reg)) {
+    if(left->GetType() == REG_INT) {
+      ReleaseRegister(left->GetRegister());
+    }
+    RegisterHolder* holder = GetRegister();
+    move_reg_reg(load_reg, holder->GetRegister());
+    working_stack.push_front(new RegInstr(holder));
+  }
+  else {
+    RegisterHolder* holder;
+    switch(left->GetType()) {
+    case REG_INT:
+      holder = left->GetRegister();
+      break;
+
+    case MEM_INT:
+      holder = GetRegister();
+      move_mem_reg((long)left->GetOperand(), RBP, holder->GetRegister());
+      break;
+
+    default:
+      working_stack.push_front(left);
+      ProcessStackCallback(LOAD_ARY_SIZE, instr, instr_index, 1);
+      ProcessReturnParameters(INT_TYPE);
+      return;
+    }
+
+    // size of the first dimension
+    CheckNilDereference(holder->GetRegister());
+    move_mem_reg(2 * sizeof(size_t), holder->GetRegister(), holder->GetRegister());
+    working_stack.push_front(new RegInstr(holder));
+  }
+
+  delete left;
+  left = nullptr;
+}
+
 void JitAmd64::ProcessJump(StackInstr* instr) {
   if(!skip_jump) {
 #ifdef _DEBUG_JIT
     std::wcout << L"JMP: id=" << instr->GetOperand() << L", regs=" << aval_regs.size() 
           << L"," << aux_regs.size() << std::endl;
 #endif
+    // poll on backward jumps
+    if(instr->GetOperand() < instr_index) {
+      ProcessSafepoint();
+    }
+
     if(instr->GetOperand2() < 0) {
       AddMachineCode(0xe9);
     }
@@ -1060,6 +1255,100 @@ void JitAmd64::ProcessJump(StackInstr* instr) {
   }
 }
 
+/**
+ * Safepoint poll, parks the thread while memory is collected. Live
+ * registers are saved to the temporary slots, which are checked as
+ * roots, before calling the memory manager.
+ */
+void JitAmd64::ProcessSafepoint() {
+  RegisterHolder* flag_holder = GetRegister();
+  move_runtime_reg((size_t)MemoryManager::GetSafepointFlag(), flag_holder->GetRegister());
+  move_mem8_reg(0, flag_holder->GetRegister(), flag_holder->GetRegister());
+  cmp_imm_reg(0, flag_holder->GetRegister());
+  ReleaseRegister(flag_holder);
+
+#ifdef _DEBUG_JIT
+  std::wcout << L"  " << (++instr_count) << L": [je <safepoint>]" << std::endl;
+#endif
+  // skip if not requested
+  AddMachineCode(0x0f);
+  AddMachineCode(0x84);
+  const long skip_index = code_index;
+  AddImm(0);
+
+  std::stack<RegInstr*> regs;
+  std::stack<long> dirty_regs;
+  long reg_offset = TMP_REG_0;
+
+  std::stack<RegInstr*> xmms;
+  std::stack<long> dirty_xmms;
+  long xmm_offset = TMP_XMM_0;
+
+  for(std::deque<RegInstr*>::iterator iter = working_stack.begin(); iter != working_stack.end(); ++iter) {
+    RegInstr* left = (*iter);
+    switch(left->GetType()) {
+    case REG_INT:
+      move_reg_mem(left->GetRegister()->GetRegister(), reg_offset, RBP);
+      dirty_regs.push(reg_offset);
+      regs.push(left);
+      reg_offset -= sizeof(size_t);
+      break;
+
+    case REG_FLOAT:
+      move_xreg_mem(left->GetRegister()->GetRegister(), xmm_offset, RBP);
+      dirty_xmms.push(xmm_offset);
+      xmms.push(left);
+      xmm_offset -= sizeof(double);
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  if(dirty_regs.size() > 6 || dirty_xmms.size() > 3 ) {
+    compile_success = false;
+  }
+
+#ifdef _WIN64
+  sub_imm_reg(32, RSP);
+  move_runtime_reg((size_t)MemoryManager::Safepoint, R10);
+  call_reg(R10);
+  add_imm_reg(32, RSP);
+#else
+  push_reg(R15);
+  push_reg(R14);
+  push_reg(R13);
+  push_reg(R8);
+  move_runtime_reg((size_t)MemoryManager::Safepoint, R15);
+  call_reg(R15);
+  pop_reg(R8);
+  pop_reg(R13);
+  pop_reg(R14);
+  pop_reg(R15);
+#endif
+
+  // restore register values
+  while(!dirty_regs.empty()) {
+    RegInstr* left = regs.top();
+    move_mem_reg(dirty_regs.top(), RBP, left->GetRegister()->GetRegister());
+    regs.pop();
+    dirty_regs.pop();
+  }
+
+  while(!dirty_xmms.empty()) {
+    RegInstr* left = xmms.top();
+    move_mem_xreg(dirty_xmms.top(), RBP, left->GetRegister()->GetRegister());
+    xmms.pop();
+    dirty_xmms.pop();
+  }
+  LoadLocals(local_index, true);
+
+  // update skip offset
+  const int32_t skip_offset = (int32_t)(code_index - skip_index - 4);
+  memcpy(&code[skip_index], &skip_offset, 4);
+}
+
 void JitAmd64::ProcessReturnParameters(MemoryType type) {
   switch(type) {
   case INT_TYPE:
@@ -1238,6 +1527,7 @@ void JitAmd64::ProcessStoreCharElement(StackInstr* instr) {
 
 void JitAmd64::ProcessStoreIntElement(StackInstr* instr) {
   RegisterHolder* elem_holder = ArrayIndex(instr, INT_TYPE);
+  SatbBarrier(elem_holder->GetRegister(), 0);
   RegInstr* left = working_stack.front();
   working_stack.pop_front();
   
@@ -1264,6 +1554,11 @@ void JitAmd64::ProcessStoreIntElement(StackInstr* instr) {
   default:
     break;
   }
+
+  // reference stored into an array
+  if(left->GetType() == MEM_INT || left->GetType() == REG_INT) {
+    MarkCard(elem_holder->GetRegister(), 0);
+  }
   ReleaseRegister(elem_holder);
   
   delete left;
@@ -1390,6 +1685,16 @@ void JitAmd64::ProcessStore(StackInstr* instr) {
     left = nullptr;
   }
   
+  // references overwritten in class or instance memory
+  if(addr_holder && instr->GetType() != STOR_FLOAT_VAR) {
+    if(instr->GetType() == STOR_FUNC_VAR) {
+      SatbBarrier(dest, instr->GetOperand3() + sizeof(size_t));
+    }
+    else {
+      SatbBarrier(dest, instr->GetOperand3());
+    }
+  }
+  
   RegInstr* left = working_stack.front();
   working_stack.pop_front();
   
@@ -1474,6 +1779,16 @@ void JitAmd64::ProcessStore(StackInstr* instr) {
     break;
   }
 
+  // reference stored into an instance
+  if(instr->GetOperand2() == INST && (left->GetType() == MEM_INT || left->GetType() == REG_INT)) {
+    if(instr->GetType() == STOR_FUNC_VAR) {
+      MarkCard(dest, instr->GetOperand3() + sizeof(size_t));
+    }
+    else {
+      MarkCard(dest, instr->GetOperand3());
+    }
+  }
+
   if(addr_holder) {
     ReleaseRegister(addr_holder);
   }
@@ -1482,8 +1797,100 @@ void JitAmd64::ProcessStore(StackInstr* instr) {
   left = nullptr;
 }
 
+/**
+ * Snapshot barrier, records the value about to be overwritten while
+ * memory is concurrently marked. Integer registers are saved on the
+ * stack and float registers in the temporary slots.
+ */
+void JitAmd64::SatbBarrier(Register reg, long offset) {
+  if(!MemoryManager::IsConcurrent()) {
+    return;
+  }
+
+  RegisterHolder* flag_holder = GetRegister();
+  move_runtime_reg((size_t)MemoryManager::GetMarkingFlag(), flag_holder->GetRegister());
+  move_mem8_reg(0, flag_holder->GetRegister(), flag_holder->GetRegister());
+  cmp_imm_reg(0, flag_holder->GetRegister());
+  ReleaseRegister(flag_holder);
+
+#ifdef _DEBUG_JIT
+  std::wcout << L"  " << (++instr_count) << L": [je <satb>]" << std::endl;
+#endif
+  // skip if not marking
+  AddMachineCode(0x0f);
+  AddMachineCode(0x84);
+  const long skip_index = code_index;
+  AddImm(0);
+
+  std::stack<RegInstr*> xmms;
+  std::stack<long> dirty_xmms;
+  long xmm_offset = TMP_XMM_0;
+  for(std::deque<RegInstr*>::iterator iter = working_stack.begin(); iter != working_stack.end(); ++iter) {
+    RegInstr* left = (*iter);
+    if(left->GetType() == REG_FLOAT) {
+      move_xreg_mem(left->GetRegister()->GetRegister(), xmm_offset, RBP);
+      dirty_xmms.push(xmm_offset);
+      xmms.push(left);
+      xmm_offset -= sizeof(double);
+    }
+  }
+
+  if(dirty_xmms.size() > 3) {
+    compile_success = false;
+  }
+
+  // caller saved registers, padded to keep the stack aligned
+  push_reg(RAX);
+  push_reg(RCX);
+  push_reg(RDX);
+  push_reg(RSI);
+  push_reg(RDI);
+  push_reg(R8);
+  push_reg(R9);
+  push_reg(R10);
+  push_reg(R11);
+  sub_imm_reg(8, RSP);
+
+#ifdef _WIN64
+  move_mem_reg(offset, reg, RCX);
+  sub_imm_reg(32, RSP);
+  move_runtime_reg((size_t)MemoryManager::SatbRecord, R10);
+  call_reg(R10);
+  add_imm_reg(32, RSP);
+#else
+  move_mem_reg(offset, reg, RDI);
+  move_runtime_reg((size_t)MemoryManager::SatbRecord, R10);
+  call_reg(R10);
+#endif
+
+  add_imm_reg(8, RSP);
+  pop_reg(R11);
+  pop_reg(R10);
+  pop_reg(R9);
+  pop_reg(R8);
+  pop_reg(RDI);
+  pop_reg(RSI);
+  pop_reg(RDX);
+  pop_reg(RCX);
+  pop_reg(RAX);
+
+  while(!dirty_xmms.empty()) {
+    RegInstr* left = xmms.top();
+    move_mem_xreg(dirty_xmms.top(), RBP, left->GetRegister()->GetRegister());
+    xmms.pop();
+    dirty_xmms.pop();
+  }
+  LoadLocals(local_index, true);
+
+  // update skip offset
+  const int32_t skip_offset = (int32_t)(code_index - skip_index - 4);
+  memcpy(&code[skip_index], &skip_offset, 4);
+}
+
 void JitAmd64::ProcessCopy(StackInstr* instr) {
   Register dest;
+  RegisterHolder* addr_holder = nullptr;
+
   // instance/method memory
   if(instr->GetOperand2() == LOCL) {
     dest = RBP;
@@ -1493,16 +1900,20 @@ void JitAmd64::ProcessCopy(StackInstr* instr) {
     RegInstr* left = working_stack.front();
     working_stack.pop_front();
 
-    RegisterHolder* holder = GetRegister();
-    move_mem_reg((long)left->GetOperand(), RBP, holder->GetRegister());
-    CheckNilDereference(holder->GetRegister());
-    dest = holder->GetRegister();
-    ReleaseRegister(holder);
+    addr_holder = GetRegister();
+    move_mem_reg((long)left->GetOperand(), RBP, addr_holder->GetRegister());
+    CheckNilDereference(addr_holder->GetRegister());
+    dest = addr_holder->GetRegister();
     
     delete left;
     left = nullptr;
   }
   
+  // reference overwritten in class or instance memory
+  if(addr_holder && instr->GetType() == COPY_CLS_INST_INT_VAR) {
+    SatbBarrier(dest, instr->GetOperand3());
+  }
+  
   RegInstr* left = working_stack.front();
   switch(left->GetType()) {
   case IMM_INT: {
@@ -1569,6 +1980,14 @@ void JitAmd64::ProcessCopy(StackInstr* instr) {
   }
     break;
   }
+
+  if(addr_holder) {
+    // reference copied into an instance
+    if(instr->GetOperand2() == INST && instr->GetType() == COPY_CLS_INST_INT_VAR) {
+      MarkCard(dest, instr->GetOperand3());
+    }
+    ReleaseRegister(addr_holder);
+  }
 }
 
 void JitAmd64::ProcessStackCallback(long instr_id, StackInstr* instr, long &instr_index, long params) {
@@ -1634,7 +2053,7 @@ void JitAmd64::ProcessStackCallback(long instr_id, StackInstr* instr, long &inst
 #ifdef _WIN64
   // set parameters
   move_imm_reg(instr_id, RCX);
-  move_imm_reg((size_t)instr, RDX);
+  move_instr_reg(instr, RDX);
   move_mem_reg(CLS_ID, RBP, R8);
   move_mem_reg(MTHD_ID, RBP, R9);
   push_imm(instr_index - 1);
@@ -1646,7 +2065,7 @@ void JitAmd64::ProcessStackCallback(long instr_id, StackInstr* instr, long &inst
 
   // call function
   sub_imm_reg(32, RSP);
-  move_imm_reg((size_t)JitCompiler::JitStackCallback, R10);
+  move_runtime_reg((size_t)JitCompiler::JitStackCallback, R10);
   call_reg(R10);
   add_imm_reg(80, RSP);
 #else
@@ -1661,7 +2080,7 @@ void JitAmd64::ProcessStackCallback(long instr_id, StackInstr* instr, long &inst
   move_mem_reg(INSTANCE_MEM, RBP, R8);
   move_mem_reg(MTHD_ID, RBP, RCX);
   move_mem_reg(CLS_ID, RBP, RDX);
-  move_imm_reg((size_t)instr, RSI);
+  move_instr_reg(instr, RSI);
   move_imm_reg(instr_id, RDI);  
   push_imm(instr_index - 1);
   push_mem(CALL_STACK_POS, RBP);
@@ -1669,7 +2088,7 @@ void JitAmd64::ProcessStackCallback(long instr_id, StackInstr* instr, long &inst
   push_mem(STACK_POS, RBP);
   
   // call function
-  move_imm_reg((size_t)JitCompiler::JitStackCallback, R15);
+  move_runtime_reg((size_t)JitCompiler::JitStackCallback, R15);
   call_reg(R15);
   add_imm_reg(32, RSP);
   
@@ -1696,6 +2115,7 @@ void JitAmd64::ProcessStackCallback(long instr_id, StackInstr* instr, long &inst
     xmms.pop();
     dirty_xmms.pop();
   }
+  LoadLocals(local_index, true);
 }
 
 void JitAmd64::ProcessReturn(long params) {
@@ -2347,12 +2767,22 @@ void JitAmd64::ProcessFloatRound(StackInstr* instruction, wchar_t mode) {
   RegInstr* left = working_stack.front();
   working_stack.pop_front();
 
-#ifdef _DEBUG_JIT
-  assert(left->GetType() == MEM_FLOAT);
-#endif
+  RegisterHolder* holder;
+  switch(left->GetType()) {
+  case IMM_FLOAT:
+    holder = GetXmmRegister();
+    move_imm_xreg(left, holder->GetRegister());
+    break;
 
-  RegisterHolder* holder = GetXmmRegister();
-  move_mem_xreg((long)left->GetOperand(), RBP, holder->GetRegister());
+  case REG_FLOAT:
+    holder = left->GetRegister();
+    break;
+
+  default:
+    holder = GetXmmRegister();
+    move_mem_xreg((long)left->GetOperand(), RBP, holder->GetRegister());
+    break;
+  }
   round_xreg_xreg(holder->GetRegister(), holder->GetRegister(), mode);
 
   working_stack.push_front(new RegInstr(holder));
@@ -2434,6 +2864,11 @@ void JitAmd64::move_reg_mem(Register src, long offset, Register dest) {
   AddMachineCode(ModRM(dest, src));
   // write value
   AddImm(offset);
+
+  Register local_reg;
+  if(GetLocalRegister(offset, dest, local_reg)) {
+    move_reg_reg(src, local_reg);
+  }
 }
 
 void JitAmd64::move_mem8_reg(long offset, Register src, Register dest) {
@@ -2480,6 +2915,12 @@ void JitAmd64::move_mem32_reg(long offset, Register src, Register dest) {
 }
 
 void JitAmd64::move_mem_reg(long offset, Register src, Register dest) {
+  Register local_reg;
+  if(GetLocalRegister(offset, src, local_reg)) {
+    move_reg_reg(local_reg, dest);
+    return;
+  }
+
 #ifdef _DEBUG_JIT
   std::wcout << L"  " << (++instr_count) << L": [movq " << offset << L"(%" 
         << GetRegisterName(src) << L"), %" << GetRegisterName(dest)
@@ -2571,6 +3012,11 @@ void JitAmd64::move_imm_mem(int64_t imm, long offset, Register dest) {
     // write value
     AddImm(offset);
     AddImm((long)imm);
+
+    Register local_reg;
+    if(GetLocalRegister(offset, dest, local_reg)) {
+      move_imm_reg(imm, local_reg);
+    }
   }
 }
 
@@ -2596,15 +3042,64 @@ void JitAmd64::move_imm_xreg(RegInstr* instr, Register reg) {
   // copy address of imm value
   RegisterHolder* imm_holder = GetRegister();
 #ifdef _WIN64  
-  move_imm_reg(instr->GetOperand2(), imm_holder->GetRegister());  
+  move_const_reg(instr->GetOperand2(), imm_holder->GetRegister());  
 #else
-  move_imm_reg(instr->GetOperand(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand(), imm_holder->GetRegister());
 #endif  
   move_mem_xreg(0, imm_holder->GetRegister(), reg);
   ReleaseRegister(imm_holder);
 }
+
+/**
+ * Loads the address of a float constant, cached code is patched with
+ * the address of the constants it is loaded with
+ */
+void JitAmd64::move_const_reg(size_t addr, Register reg) {
+  move_imm_reg(addr, reg);
+  const size_t offset = addr - (size_t)float_consts;
+  if(offset < sizeof(double) * MAX_DBLS) {
+    fixups.push_back({ (int32_t)(code_index - sizeof(int64_t)), FIXUP_FLOAT, (int64_t)offset });
+  }
+  else {
+    cacheable = false;
+  }
+}
+
+/**
+ * Loads the address of a runtime function or variable
+ */
+void JitAmd64::move_runtime_reg(size_t addr, Register reg) {
+  move_imm_reg(addr, reg);
+  std::vector<size_t> &addresses = GetRuntimeAddresses();
+  std::vector<size_t>::iterator found = std::find(addresses.begin(), addresses.end(), addr);
+  if(found != addresses.end()) {
+    fixups.push_back({ (int32_t)(code_index - sizeof(int64_t)), FIXUP_RUNTIME, (int64_t)(found - addresses.begin()) });
+  }
+  else {
+    cacheable = false;
+  }
+}
+
+/**
+ * Loads the address of the instruction being translated
+ */
+void JitAmd64::move_instr_reg(StackInstr* instr, Register reg) {
+  move_imm_reg((size_t)instr, reg);
+  if(instr_index > 0 && method->GetInstruction(instr_index - 1) == instr) {
+    fixups.push_back({ (int32_t)(code_index - sizeof(int64_t)), FIXUP_INSTR, (int64_t)(instr_index - 1) });
+  }
+  else {
+    cacheable = false;
+  }
+}
     
 void JitAmd64::move_mem_xreg(long offset, Register src, Register dest) {
+  Register local_reg;
+  if(GetLocalRegister(offset, src, local_reg)) {
+    move_xreg_xreg(local_reg, dest);
+    return;
+  }
+
 #ifdef _DEBUG_JIT
   std::wcout << L"  " << (++instr_count) << L": [movsd " << offset << L"(%" 
         << GetRegisterName(src) << L"), %" << GetRegisterName(dest) << L"]" << std::endl;
@@ -2633,19 +3128,24 @@ void JitAmd64::move_xreg_mem(Register src, long offset, Register dest) {
   AddMachineCode(ModRM(dest, src));
   // write value
   AddImm(offset);
+
+  Register local_reg;
+  if(GetLocalRegister(offset, dest, local_reg)) {
+    move_xreg_xreg(src, local_reg);
+  }
 }
     
 void JitAmd64::move_xreg_xreg(Register src, Register dest) {
   if(src != dest) {
 #ifdef _DEBUG_JIT
-    std::wcout << L"  " << (++instr_count) << L": [movsd %" << GetRegisterName(src) 
+    std::wcout << L"  " << (++instr_count) << L": [movapd %" << GetRegisterName(src) 
           << L", %" << GetRegisterName(dest) << L"]" << std::endl;
 #endif
-    // encode
-    AddMachineCode(0xf2);
+    // encode, movapd replaces the whole register and does not wait on its old value
+    AddMachineCode(0x66);
     AddMachineCode(ROB(src, dest));
     AddMachineCode(0x0f);
-    AddMachineCode(0x11);
+    AddMachineCode(0x29);
     unsigned char code = 0xc0;
     // write value
     RegisterEncode3(code, 2, src);
@@ -2843,7 +3343,7 @@ RegisterHolder* JitAmd64::call_xfunc(double(*func_ptr)(double), RegInstr* left)
   move_mem_xreg((long)left->GetOperand(), RBP, XMM0);
 
   RegisterHolder* call_holder = GetRegister();
-  move_imm_reg((size_t)func_ptr, call_holder->GetRegister());
+  move_runtime_reg((size_t)func_ptr, call_holder->GetRegister());
   call_reg(call_holder->GetRegister());
   ReleaseRegister(call_holder);
   
@@ -2852,6 +3352,7 @@ RegisterHolder* JitAmd64::call_xfunc(double(*func_ptr)(double), RegInstr* left)
     move_xreg_xreg(XMM0, result_holder->GetRegister());
     move_mem_xreg(TMP_XMM_0, RBP, XMM0);
   }
+  LoadLocals(local_index, true);
 
   return result_holder;
 }
@@ -2872,7 +3373,7 @@ RegisterHolder* JitAmd64::call_xfunc2(double(*func_ptr)(double, double), RegInst
   move_mem_xreg((long)right->GetOperand(), RBP, XMM0);
   
   RegisterHolder* call_holder = GetRegister();
-  move_imm_reg((size_t)func_ptr, call_holder->GetRegister());
+  move_runtime_reg((size_t)func_ptr, call_holder->GetRegister());
   call_reg(call_holder->GetRegister());
   ReleaseRegister(call_holder);
 
@@ -2882,6 +3383,7 @@ RegisterHolder* JitAmd64::call_xfunc2(double(*func_ptr)(double, double), RegInst
     move_xreg_xreg(XMM0, result_holder->GetRegister());
     move_mem_xreg(TMP_XMM_0, RBP, XMM0);
   }
+  LoadLocals(local_index, true);
 
   delete right;
   right = nullptr;
@@ -3024,6 +3526,12 @@ void JitAmd64::math_reg_reg(Register src, Register dest, InstructionType type) {
 }
 
 void JitAmd64::math_mem_reg(long offset, Register reg, InstructionType type) {
+  Register local_reg;
+  if(GetLocalRegister(offset, RBP, local_reg)) {
+    math_reg_reg(local_reg, reg, type);
+    return;
+  }
+
   switch(type) {
   case SHL_INT:
     shl_mem_reg(offset, RBP, reg);
@@ -3130,6 +3638,12 @@ void JitAmd64::math_imm_xreg(RegInstr* instr, Register reg, InstructionType type
 }
 
 void JitAmd64::math_mem_xreg(long offset, Register dest, InstructionType type) {
+  Register local_reg;
+  if(GetLocalRegister(offset, RBP, local_reg)) {
+    math_xreg_xreg(local_reg, dest, type);
+    return;
+  }
+
   RegisterHolder* holder = GetXmmRegister();
   move_mem_xreg(offset, RBP, holder->GetRegister());
   math_xreg_xreg(holder->GetRegister(), dest, type);
@@ -3187,6 +3701,12 @@ void JitAmd64::cmp_reg_reg(Register src, Register dest) {
 }
 
 void JitAmd64::cmp_mem_reg(long offset, Register src, Register dest) {
+  Register local_reg;
+  if(GetLocalRegister(offset, src, local_reg)) {
+    cmp_reg_reg(local_reg, dest);
+    return;
+  }
+
 #ifdef _DEBUG_JIT
   std::wcout << L"  " << (++instr_count) << L": [cmpq " << offset << L"(%" 
         << GetRegisterName(src) << L"), %" << GetRegisterName(dest) 
@@ -3226,6 +3746,12 @@ void JitAmd64::cmp_imm_reg(int64_t imm, Register reg) {
 
 // TODO: 64-bit literal operation for Windows
 void JitAmd64::cmp_imm_mem(long offset, Register src, int64_t imm) {
+  Register local_reg;
+  if(GetLocalRegister(offset, src, local_reg)) {
+    cmp_imm_reg(imm, local_reg);
+    return;
+  }
+
   if(imm < INT32_MIN || imm > INT32_MAX) {
     RegisterHolder* inm_holder = GetRegister();
     move_imm_reg(imm, inm_holder->GetRegister());
@@ -3358,9 +3884,9 @@ void JitAmd64::add_imm_xreg(RegInstr* instr, Register reg) {
   // copy address of imm value
   RegisterHolder* imm_holder = GetRegister();
 #ifdef _WIN64
-  move_imm_reg(instr->GetOperand2(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand2(), imm_holder->GetRegister());
 #else
-  move_imm_reg(instr->GetOperand(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand(), imm_holder->GetRegister());
 #endif
   add_mem_xreg(0, imm_holder->GetRegister(), reg);
   ReleaseRegister(imm_holder);
@@ -3370,9 +3896,9 @@ void JitAmd64::sub_imm_xreg(RegInstr* instr, Register reg) {
   // copy address of imm value
   RegisterHolder* imm_holder = GetRegister();
 #ifdef _WIN64
-  move_imm_reg(instr->GetOperand2(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand2(), imm_holder->GetRegister());
 #else
-  move_imm_reg(instr->GetOperand(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand(), imm_holder->GetRegister());
 #endif
   sub_mem_xreg(0, imm_holder->GetRegister(), reg);
   ReleaseRegister(imm_holder);
@@ -3382,9 +3908,9 @@ void JitAmd64::div_imm_xreg(RegInstr* instr, Register reg) {
   // copy address of imm value
   RegisterHolder* imm_holder = GetRegister();
 #ifdef _WIN64
-  move_imm_reg(instr->GetOperand2(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand2(), imm_holder->GetRegister());
 #else
-  move_imm_reg(instr->GetOperand(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand(), imm_holder->GetRegister());
 #endif
   div_mem_xreg(0, imm_holder->GetRegister(), reg);
   ReleaseRegister(imm_holder);
@@ -3394,9 +3920,9 @@ void JitAmd64::mul_imm_xreg(RegInstr* instr, Register reg) {
   // copy address of imm value
   RegisterHolder* imm_holder = GetRegister();
 #ifdef _WIN64
-  move_imm_reg(instr->GetOperand2(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand2(), imm_holder->GetRegister());
 #else
-  move_imm_reg(instr->GetOperand(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand(), imm_holder->GetRegister());
 #endif
   mul_mem_xreg(0, imm_holder->GetRegister(), reg);
   ReleaseRegister(imm_holder);
@@ -3504,11 +4030,12 @@ void JitAmd64::round_xreg_xreg(Register src, Register dest, wchar_t mode) {
   RegisterEncode3(code, 5, src);
   AddMachineCode(code);
 
+  // rounding control: 1 toward -inf, 2 toward +inf
   if(mode == L'c') {
-    AddMachineCode(0x1);
+    AddMachineCode(0x2);
   }
   else if(mode == L'f') {
-    AddMachineCode(0x2);
+    AddMachineCode(0x1);
   }
   else {
     AddMachineCode(0x0);
@@ -4108,7 +4635,7 @@ void JitAmd64::cmp_mem_xreg(long offset, Register src, Register dest) {
 void JitAmd64::cmp_imm_xreg(size_t addr, Register reg) {
   // copy address of imm value
   RegisterHolder* imm_holder = GetRegister();
-  move_imm_reg(addr, imm_holder->GetRegister());
+  move_const_reg(addr, imm_holder->GetRegister());
   cmp_mem_xreg(0, imm_holder->GetRegister(), reg);
   ReleaseRegister(imm_holder);
 }
@@ -4134,15 +4661,21 @@ void JitAmd64::cvt_imm_reg(RegInstr* instr, Register reg) {
   // copy address of imm value
   RegisterHolder* imm_holder = GetRegister();
 #ifdef _WIN64
-  move_imm_reg(instr->GetOperand2(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand2(), imm_holder->GetRegister());
 #else
-  move_imm_reg(instr->GetOperand(), imm_holder->GetRegister());
+  move_const_reg(instr->GetOperand(), imm_holder->GetRegister());
 #endif
   cvt_mem_reg(0, imm_holder->GetRegister(), reg);
   ReleaseRegister(imm_holder);
 }
 
 void JitAmd64::cvt_mem_reg(long offset, Register src, Register dest) {
+  Register local_reg;
+  if(GetLocalRegister(offset, src, local_reg)) {
+    cvt_xreg_reg(local_reg, dest);
+    return;
+  }
+
 #ifdef _DEBUG_JIT
   std::wcout << L"  " << (++instr_count) << L": [cvtsd2si " << offset << L"(%" 
         << GetRegisterName(src) << L"), %" << GetRegisterName(dest) << L"]" << std::endl;
@@ -4182,6 +4715,12 @@ void JitAmd64::cvt_imm_xreg(RegInstr* instr, Register reg) {
 }
 
 void JitAmd64::cvt_mem_xreg(long offset, Register src, Register dest) {
+  Register local_reg;
+  if(GetLocalRegister(offset, src, local_reg)) {
+    cvt_reg_xreg(local_reg, dest);
+    return;
+  }
+
 #ifdef _DEBUG_JIT
   std::wcout << L"  " << (++instr_count) << L": [cvtsi2sd " << offset << L"(%" 
         << GetRegisterName(src) << L"), %" << GetRegisterName(dest) << L"]" << std::endl;
@@ -4352,6 +4891,14 @@ void JitAmd64::fstp_mem(int32_t offset, Register src) {
   AddMachineCode(ModRM(src, RBX));
   // write value
   AddImm(offset);
+
+  Register local_reg;
+  if(GetLocalRegister(offset, src, local_reg)) {
+    const long index = local_index;
+    local_index = -1;
+    move_mem_xreg(offset, src, local_reg);
+    local_index = index;
+  }
 }
 
 void JitAmd64::fsin() {
@@ -4744,7 +5291,12 @@ RegisterHolder* JitAmd64::ArrayIndex(StackInstr* instr, MemoryType type)
     exit(1);
     break;
   }
-  CheckNilDereference(array_holder->GetRegister());
+
+  // indexed by the counter of a loop over the array
+  const bool checked = checked_elements.find(local_index) != checked_elements.end();
+  if(!checked) {
+    CheckNilDereference(array_holder->GetRegister());
+  }
 
   /* Algorithm:
    long index = PopInt();
@@ -4812,39 +5364,49 @@ RegisterHolder* JitAmd64::ArrayIndex(StackInstr* instr, MemoryType type)
   }
 
   // bounds check
-  RegisterHolder* bounds_holder = GetRegister();
+  RegisterHolder* bounds_holder = nullptr;
+  if(!checked) {
+    bounds_holder = GetRegister();
 #ifdef _WIN64    
-  move_mem_reg32(0, array_holder->GetRegister(), bounds_holder->GetRegister());
+    move_mem_reg32(0, array_holder->GetRegister(), bounds_holder->GetRegister());
 #else
-  move_mem_reg(0, array_holder->GetRegister(), bounds_holder->GetRegister());
+    move_mem_reg(0, array_holder->GetRegister(), bounds_holder->GetRegister());
 #endif    
+  }
 
   // ajust indices
+  long shift = 0;
   switch(type) {
   case BYTE_ARY_TYPE:
     break;
 
   case CHAR_ARY_TYPE:
 #ifdef _WIN64    
-    shl_imm_reg(1, index_holder->GetRegister());
-    shl_imm_reg(1, bounds_holder->GetRegister());
+    shift = 1;
 #else
-    shl_imm_reg(2, index_holder->GetRegister());
-    shl_imm_reg(2, bounds_holder->GetRegister());
+    shift = 2;
 #endif      
     break;
 
   case INT_TYPE:
   case FLOAT_TYPE:
-    shl_imm_reg(3, index_holder->GetRegister());
-    shl_imm_reg(3, bounds_holder->GetRegister());
+    shift = 3;
     break;
 
   default:
     break;
   }
-  CheckArrayBounds(index_holder->GetRegister(), bounds_holder->GetRegister());
-  ReleaseRegister(bounds_holder);
+
+  if(shift) {
+    shl_imm_reg(shift, index_holder->GetRegister());
+  }
+  if(bounds_holder) {
+    if(shift) {
+      shl_imm_reg(shift, bounds_holder->GetRegister());
+    }
+    CheckArrayBounds(index_holder->GetRegister(), bounds_holder->GetRegister());
+    ReleaseRegister(bounds_holder);
+  }
 
   // skip first 2 integers (size and dimension) and all dimension indices
   add_imm_reg((instr->GetOperand() + 2) * sizeof(size_t), index_holder->GetRegister());
@@ -4867,6 +5429,8 @@ void JitAmd64::ProcessIndices()
     StackInstr* instr = method->GetInstruction(i);
     switch(instr->GetType()) {
     case LOAD_LOCL_INT_VAR:
+    case INC_LOCL_INT_VAR:
+    case CMP_JMP_LOCL_INT_VAR:
     case LOAD_CLS_INST_INT_VAR:
     case STOR_LOCL_INT_VAR:
     case STOR_CLS_INST_INT_VAR:
@@ -4902,6 +5466,8 @@ void JitAmd64::ProcessIndices()
       if(last_id != id) {
         switch(instr->GetType()) {
         case LOAD_LOCL_INT_VAR:
+        case INC_LOCL_INT_VAR:
+        case CMP_JMP_LOCL_INT_VAR:
         case LOAD_CLS_INST_INT_VAR:
         case STOR_LOCL_INT_VAR:
         case STOR_CLS_INST_INT_VAR:
@@ -4941,6 +5507,537 @@ void JitAmd64::ProcessIndices()
 #endif
 }
 
+/**
+ * Finds loops in the method. Records the loop depth of instructions and,
+ * for counted loops over an array ('i < a->Size()' with 'i' starting at
+ * a literal and only incremented), the array accesses indexed by
+ * the counter that need no nil or bounds checks. Array sizes and class or
+ * instance fields read in loops are recorded as candidates to be held in
+ * registers.
+ */
+void JitAmd64::ProcessLoops()
+{
+  const long count = method->GetInstructionCount();
+
+  // loop depth of each instruction
+  loop_depths.assign(count, 0);
+  for(long i = 0; i < count; ++i) {
+    StackInstr* instr = method->GetInstruction(i);
+    if(instr->GetType() == JMP && instr->GetOperand() <= i) {
+      for(long j = instr->GetOperand(); j <= i; ++j) {
+        loop_depths[j]++;
+      }
+    }
+  }
+
+  std::vector<LocalRange> loads;
+  for(long j = 0; j < count; ++j) {
+    StackInstr* back_instr = method->GetInstruction(j);
+    if(back_instr->GetType() != JMP || back_instr->GetOperand2() > -1 ||
+       back_instr->GetOperand() > j || back_instr->GetOperand() < 1) {
+      continue;
+    }
+    const long header = back_instr->GetOperand();
+
+    // entered only through the header
+    bool entered = false;
+    for(long i = 0; i < count && !entered; ++i) {
+      StackInstr* instr = method->GetInstruction(i);
+      entered = instr->GetType() == JMP && (i < header || i > j) &&
+        instr->GetOperand() >= header && instr->GetOperand() <= j;
+    }
+
+    // class and instance fields
+    for(long i = header; i <= j; ++i) {
+      StackInstr* instr = method->GetInstruction(i);
+      if((instr->GetType() == LOAD_CLS_INST_INT_VAR || instr->GetType() == LOAD_FLOAT_VAR) &&
+         (instr->GetOperand2() == CLS || instr->GetOperand2() == INST)) {
+        const long mem_type = method->GetInstruction(i - 1)->GetType();
+        if((instr->GetOperand2() == CLS && mem_type == LOAD_CLS_MEM) ||
+           (instr->GetOperand2() == INST && mem_type == LOAD_INST_MEM)) {
+          const long offset = instr->GetOperand2() == CLS ? CLASS_MEM : INSTANCE_MEM;
+          const LocalRange load = { offset, instr->GetOperand3(), header - 1, j, LoopWeight(i),
+                                    instr->GetType() == LOAD_FLOAT_VAR, RAX };
+          loads.push_back(load);
+        }
+      }
+    }
+
+    // counted loop, 'LOAD s, LOAD_ARY_SIZE, LOAD i, LES_INT, JMP <exit>'
+    long test = header;
+    while(test < j && method->GetInstruction(test)->GetType() != JMP) {
+      test++;
+    }
+    if(entered || test - header < 4) {
+      continue;
+    }
+    StackInstr* exit_instr = method->GetInstruction(test);
+    StackInstr* size_instr = method->GetInstruction(test - 4);
+    StackInstr* index_instr = method->GetInstruction(test - 2);
+    if(exit_instr->GetOperand2() != 0 || exit_instr->GetOperand() <= j ||
+       method->GetInstruction(test - 1)->GetType() != LES_INT ||
+       index_instr->GetType() != LOAD_LOCL_INT_VAR || index_instr->GetOperand2() != LOCL ||
+       method->GetInstruction(test - 3)->GetType() != LOAD_ARY_SIZE ||
+       size_instr->GetType() != LOAD_LOCL_INT_VAR || size_instr->GetOperand2() != LOCL) {
+      continue;
+    }
+    const long index_offset = index_instr->GetOperand3();
+    long array_offset = size_instr->GetOperand3();
+
+    // counter starts at a literal that is not negative
+    long init = header - 1;
+    if(init > 0 && method->GetInstruction(init)->GetType() == LBL) {
+      init--;
+    }
+    if(init < 1 || !IsLocalStore(method->GetInstruction(init), index_offset) ||
+       method->GetInstruction(init - 1)->GetType() != LOAD_INT_LIT ||
+       method->GetInstruction(init - 1)->GetInt64Operand() < 0) {
+      continue;
+    }
+
+    // counter is only stored by its increment
+    long inc = -1;
+    bool counted = true;
+    for(long i = header; i <= j && counted; ++i) {
+      if(IsLocalStore(method->GetInstruction(i), index_offset)) {
+        counted = inc < 0 && IsLocalIncrement(i, index_offset);
+        inc = i;
+      }
+    }
+    if(!counted || inc < 0) {
+      continue;
+    }
+
+    // size is read from the array or from a copy made in the header
+    long copy = -1;
+    for(long i = header; i <= j && counted; ++i) {
+      if(IsLocalStore(method->GetInstruction(i), array_offset)) {
+        counted = copy < 0 && i < test - 4 && i - 3 >= header &&
+          method->GetInstruction(i - 3)->GetType() == LOAD_LOCL_INT_VAR &&
+          method->GetInstruction(i - 2)->GetType() == LOAD_INST_MEM &&
+          method->GetInstruction(i - 1)->GetType() == STOR_LOCL_INT_VAR;
+        copy = i;
+      }
+    }
+    if(copy > -1 && counted) {
+      array_offset = method->GetInstruction(copy - 3)->GetOperand3();
+    }
+
+    // array is not stored in the loop and the body is not entered after the increment
+    for(long i = header; i <= j && counted; ++i) {
+      StackInstr* instr = method->GetInstruction(i);
+      counted = !IsLocalStore(instr, array_offset) &&
+        !(i >= inc && i < j && instr->GetType() == JMP && instr->GetOperand() > test && instr->GetOperand() < inc);
+    }
+    if(!counted) {
+      continue;
+    }
+
+    for(long i = test + 1; i < inc; ++i) {
+      StackInstr* instr = method->GetInstruction(i);
+      switch(instr->GetType()) {
+      case LOAD_BYTE_ARY_ELM:
+      case LOAD_CHAR_ARY_ELM:
+      case LOAD_INT_ARY_ELM:
+      case LOAD_FLOAT_ARY_ELM:
+      case STOR_BYTE_ARY_ELM:
+      case STOR_CHAR_ARY_ELM:
+      case STOR_INT_ARY_ELM:
+      case STOR_FLOAT_ARY_ELM:
+        if(instr->GetOperand() == 1 &&
+           IsLocalLoad(method->GetInstruction(i - 1), array_offset) &&
+           IsLocalLoad(method->GetInstruction(i - 2), index_offset)) {
+          checked_elements.insert(i);
+#ifdef _DEBUG_JIT
+          std::wcout << L"Checked array access: index=" << i << L"; loop=[" << header
+            << L"," << j << L"]" << std::endl;
+#endif
+        }
+        break;
+
+      default:
+        break;
+      }
+    }
+
+    // size of the array
+    size_loads[test - 3] = array_offset;
+    const LocalRange load = { array_offset, (long)(2 * sizeof(size_t)), header - 1, j, LoopWeight(test - 3), false, RAX };
+    loads.push_back(load);
+  }
+
+  // one candidate per loop and value, outer loops first and weighted by the loads they contain
+  std::sort(loads.begin(), loads.end(), [](const LocalRange &a, const LocalRange &b) {
+    if(a.offset != b.offset) {
+      return a.offset < b.offset;
+    }
+    if(a.field != b.field) {
+      return a.field < b.field;
+    }
+    if(a.start != b.start) {
+      return a.start < b.start;
+    }
+    return a.end > b.end;
+  });
+  for(size_t i = 0; i < loads.size(); ++i) {
+    const LocalRange &load = loads[i];
+    if(!loop_loads.empty() && loop_loads.back().offset == load.offset && loop_loads.back().field == load.field &&
+       loop_loads.back().start == load.start && loop_loads.back().end == load.end) {
+      loop_loads.back().weight += load.weight;
+    }
+    else {
+      loop_loads.push_back(load);
+    }
+  }
+  for(size_t i = 0; i < loop_loads.size(); ++i) {
+    for(size_t j = i + 1; j < loop_loads.size() && loop_loads[j].offset == loop_loads[i].offset &&
+        loop_loads[j].field == loop_loads[i].field && loop_loads[j].start <= loop_loads[i].end; ++j) {
+      if(loop_loads[j].end <= loop_loads[i].end) {
+        loop_loads[i].weight += loop_loads[j].weight;
+      }
+    }
+  }
+}
+
+/**
+ * Assigns registers to locals referenced in loops and to values loaded in
+ * loops. Each live range is widened to cover jumps into it and loop
+ * headers, then ranges are scanned by start and the lightest active range
+ * is evicted when a class of registers runs out. Ranges are weighted by
+ * loop depth.
+ */
+void JitAmd64::AllocateLocals()
+{
+#ifndef _WIN64
+  const long count = method->GetInstructionCount();
+
+  // candidates, locals only read and written as a single type
+  std::map<long, LocalRange> ranges;
+  std::set<long> excluded, looped;
+  for(long i = 0; i < count; ++i) {
+    StackInstr* instr = method->GetInstruction(i);
+    if(instr->GetOperand2() != LOCL) {
+      continue;
+    }
+
+    bool is_float;
+    switch(instr->GetType()) {
+    case LOAD_LOCL_INT_VAR:
+    case INC_LOCL_INT_VAR:
+    case CMP_JMP_LOCL_INT_VAR:
+    case STOR_LOCL_INT_VAR:
+    case COPY_LOCL_INT_VAR:
+      is_float = false;
+      break;
+
+    case LOAD_FLOAT_VAR:
+    case STOR_FLOAT_VAR:
+    case COPY_FLOAT_VAR:
+      is_float = true;
+      break;
+
+    case LOAD_FUNC_VAR:
+    case STOR_FUNC_VAR:
+      excluded.insert(instr->GetOperand3());
+      continue;
+
+    default:
+      continue;
+    }
+
+    const long offset = instr->GetOperand3();
+    std::map<long, LocalRange>::iterator found = ranges.find(offset);
+    if(found == ranges.end()) {
+      LocalRange range = { offset, -1, i, i, 0, is_float, RAX };
+      found = ranges.insert(std::pair<long, LocalRange>(offset, range)).first;
+    }
+    else if(found->second.is_float != is_float) {
+      excluded.insert(offset);
+    }
+    found->second.end = i;
+    found->second.weight += LoopWeight(i);
+    if(loop_depths[i] > 0) {
+      looped.insert(offset);
+    }
+  }
+
+  // widens a range until no jumps enter it and its loops are entered once
+  auto widen = [this, count](LocalRange &range) {
+    bool widened = false;
+    bool changed = true;
+    while(changed) {
+      changed = false;
+      for(long i = 0; i < count; ++i) {
+        StackInstr* instr = method->GetInstruction(i);
+        if(instr->GetType() != JMP) {
+          continue;
+        }
+
+        const long target = instr->GetOperand();
+        if(target > range.start && target <= range.end && (i < range.start || i > range.end)) {
+          range.start = i < range.start ? i : range.start;
+          range.end = i > range.end ? i : range.end;
+          changed = true;
+        }
+        else if(target <= range.start && range.start > 0 && i >= range.start && i <= range.end) {
+          range.start = target > 0 ? target - 1 : 0;
+          changed = true;
+        }
+      }
+
+      // fused conditional jumps are emitted with the instruction before them
+      if(range.start > 0 && method->GetInstruction(range.start)->GetType() == JMP) {
+        range.start--;
+        changed = true;
+      }
+      widened = widened || changed;
+    }
+    return widened;
+  };
+
+  std::vector<LocalRange> candidates;
+  for(std::map<long, LocalRange>::iterator iter = ranges.begin(); iter != ranges.end(); ++iter) {
+    LocalRange range = iter->second;
+    if(excluded.find(range.offset) != excluded.end() || looped.find(range.offset) == looped.end()) {
+      continue;
+    }
+
+    // loads are consumed later in the block, i.e. by a compare
+    while(range.end + 1 < count && method->GetInstruction(range.end)->GetType() != JMP &&
+          method->GetInstruction(range.end + 1)->GetType() != LBL) {
+      range.end++;
+    }
+    widen(range);
+    candidates.push_back(range);
+  }
+
+  // values loaded in loops, loaded before the outermost loop that does not change them
+  for(size_t i = 0; i < loop_loads.size(); ++i) {
+    LocalRange range = loop_loads[i];
+    bool covered = false;
+    for(size_t j = 0; j < candidates.size() && !covered; ++j) {
+      covered = candidates[j].offset == range.offset && candidates[j].field == range.field &&
+        candidates[j].start <= range.start && range.end <= candidates[j].end;
+    }
+    if(!covered && !widen(range) && IsLoopInvariant(range)) {
+      candidates.push_back(range);
+    }
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const LocalRange &a, const LocalRange &b) { return a.start < b.start; });
+
+  // linear scan
+  std::vector<Register> regs = { R12, R9, RSI, RDI };
+  std::vector<Register> xregs = { XMM2, XMM3, XMM4, XMM5, XMM6, XMM7, XMM8, XMM9 };
+  std::vector<bool> assigned(candidates.size(), false);
+  std::list<size_t> active;
+  for(size_t i = 0; i < candidates.size(); ++i) {
+    LocalRange &range = candidates[i];
+
+    // release expired ranges
+    for(std::list<size_t>::iterator iter = active.begin(); iter != active.end();) {
+      const LocalRange &expired = candidates[*iter];
+      if(expired.end < range.start) {
+        if(expired.is_float) {
+          xregs.push_back(expired.reg);
+        }
+        else {
+          regs.push_back(expired.reg);
+        }
+        iter = active.erase(iter);
+      }
+      else {
+        ++iter;
+      }
+    }
+
+    std::vector<Register> &pool = range.is_float ? xregs : regs;
+    if(pool.empty()) {
+      // spill the lightest active range of the same class
+      std::list<size_t>::iterator lightest = active.end();
+      for(std::list<size_t>::iterator iter = active.begin(); iter != active.end(); ++iter) {
+        if(candidates[*iter].is_float == range.is_float &&
+           (lightest == active.end() || candidates[*iter].weight < candidates[*lightest].weight)) {
+          lightest = iter;
+        }
+      }
+
+      if(lightest == active.end() || candidates[*lightest].weight >= range.weight) {
+        continue;
+      }
+      assigned[*lightest] = false;
+      pool.push_back(candidates[*lightest].reg);
+      active.erase(lightest);
+    }
+
+    range.reg = pool.back();
+    pool.pop_back();
+    assigned[i] = true;
+    active.push_back(i);
+  }
+
+  for(size_t i = 0; i < candidates.size(); ++i) {
+    if(assigned[i]) {
+      local_ranges.push_back(candidates[i]);
+#ifdef _DEBUG_JIT
+      std::wcout << L"Local register: offset=" << candidates[i].offset << L"; field="
+        << candidates[i].field << L"; range=[" << candidates[i].start << L"," << candidates[i].end
+        << L"]; weight=" << candidates[i].weight << L"; reg=" << GetRegisterName(candidates[i].reg) << std::endl;
+#endif
+    }
+  }
+#endif
+}
+
+/**
+ * Checks that nothing in a range changes a value loaded before it. Array
+ * sizes only change if the array is stored, fields may also be changed by
+ * calls.
+ */
+bool JitAmd64::IsLoopInvariant(const LocalRange &range)
+{
+  const bool is_field = range.offset == CLASS_MEM || range.offset == INSTANCE_MEM;
+  const long mem_type = range.offset == CLASS_MEM ? CLS : INST;
+  for(long i = range.start; i <= range.end; ++i) {
+    StackInstr* instr = method->GetInstruction(i);
+    switch(instr->GetType()) {
+    case STOR_LOCL_INT_VAR:
+    case COPY_LOCL_INT_VAR:
+      if(!is_field && instr->GetOperand3() == range.offset) {
+        return false;
+      }
+      break;
+
+    case STOR_CLS_INST_INT_VAR:
+    case COPY_CLS_INST_INT_VAR:
+    case STOR_FLOAT_VAR:
+    case COPY_FLOAT_VAR:
+      if(is_field && instr->GetOperand2() == mem_type && instr->GetOperand3() == range.field) {
+        return false;
+      }
+      break;
+
+    case STOR_FUNC_VAR:
+      if(is_field && instr->GetOperand2() == mem_type &&
+         (instr->GetOperand3() == range.field || instr->GetOperand3() + (long)sizeof(size_t) == range.field)) {
+        return false;
+      }
+      break;
+
+    case MTHD_CALL:
+    case DYN_MTHD_CALL:
+    case TRAP:
+    case TRAP_RTRN:
+    case CRITICAL_START:
+    case CRITICAL_END:
+    case THREAD_JOIN:
+    case THREAD_SLEEP:
+      if(is_field) {
+        return false;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Loads values held in registers, either the ranges starting at an
+ * instruction or, after calls, all ranges covering it
+ */
+void JitAmd64::LoadLocals(long index, bool reload)
+{
+  if(index < 0) {
+    return;
+  }
+
+  const long cur_index = local_index;
+  local_index = -1;
+  for(size_t i = 0; i < local_ranges.size(); ++i) {
+    const LocalRange &range = local_ranges[i];
+    if(reload ? range.start <= index && index <= range.end : range.start == index) {
+      // array size or field
+      if(range.field > -1) {
+        if(range.is_float) {
+          RegisterHolder* holder = GetRegister();
+          move_mem_reg(range.offset, RBP, holder->GetRegister());
+          CheckNilDereference(holder->GetRegister());
+          move_mem_xreg(range.field, holder->GetRegister(), range.reg);
+          ReleaseRegister(holder);
+        }
+        else {
+          move_mem_reg(range.offset, RBP, range.reg);
+          CheckNilDereference(range.reg);
+          move_mem_reg(range.field, range.reg, range.reg);
+        }
+      }
+      else if(range.is_float) {
+        move_mem_xreg(range.offset, RBP, range.reg);
+      }
+      else {
+        move_mem_reg(range.offset, RBP, range.reg);
+      }
+    }
+  }
+  local_index = cur_index;
+}
+
+bool JitAmd64::GetLocalRegister(long offset, Register base, Register &reg)
+{
+  if(base != RBP || local_index < 0) {
+    return false;
+  }
+
+  for(size_t i = 0; i < local_ranges.size(); ++i) {
+    const LocalRange &range = local_ranges[i];
+    if(range.field < 0 && range.offset == offset && range.start <= local_index && local_index <= range.end) {
+      reg = range.reg;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool JitAmd64::IsLocalIncrement(long index, long offset)
+{
+  if(index < 3 || method->GetInstruction(index - 1)->GetType() != ADD_INT) {
+    return false;
+  }
+
+  StackInstr* first = method->GetInstruction(index - 3);
+  StackInstr* second = method->GetInstruction(index - 2);
+  if(second->GetType() == LOAD_INT_LIT) {
+    std::swap(first, second);
+  }
+
+  // adds a small positive literal
+  return first->GetType() == LOAD_INT_LIT && first->GetInt64Operand() > 0 && first->GetInt64Operand() <= INT32_MAX &&
+    (IsLocalLoad(second, offset) || (second->GetType() == INC_LOCL_INT_VAR && second->GetOperand3() == offset));
+}
+
+bool JitAmd64::GetLoadRegister(long offset, long field, Register &reg)
+{
+  if(local_index < 0) {
+    return false;
+  }
+
+  for(size_t i = 0; i < local_ranges.size(); ++i) {
+    const LocalRange &range = local_ranges[i];
+    if(range.field == field && range.offset == offset && range.start <= local_index && local_index <= range.end) {
+      reg = range.reg;
+      return true;
+    }
+  }
+
+  return false;
+}
+
 bool JitAmd64::Compile(StackMethod* cm)
 {
   compile_success = true;
@@ -4952,6 +6049,11 @@ bool JitAmd64::Compile(StackMethod* cm)
     skip_jump = false;
     method = cm;
 
+    // machine code of an earlier run
+    if(LoadCachedCode()) {
+      return true;
+    }
+
 #ifdef _DEBUG_JIT
     long cls_id = method->GetClass()->GetId();
     long mthd_id = method->GetId();
@@ -4978,6 +6080,8 @@ bool JitAmd64::Compile(StackMethod* cm)
 #endif    
     local_space = floats_index = instr_index = code_index = epilog_index = instr_count = 0;
     float_consts[floats_index++] = 0.0;
+    fixups.clear();
+    cacheable = true;
 
     rax_reg = new RegisterHolder(RAX);
 #ifdef _WIN64
@@ -5029,25 +6133,18 @@ bool JitAmd64::Compile(StackMethod* cm)
 #endif
 
     // process offsets
+    local_index = -1;
     ProcessIndices();
+    ProcessLoops();
+    if(local_registers) {
+      AllocateLocals();
+    }
 
     // setup
     Prolog();
 
     // method information
-#ifdef _WIN64    
-    move_reg_mem(RCX, CLS_ID, RBP);
-    move_reg_mem(RDX, MTHD_ID, RBP);
-    move_reg_mem(R8, CLASS_MEM, RBP);
-    move_reg_mem(R9, INSTANCE_MEM, RBP);
-#else
-    move_reg_mem(RDI, CLS_ID, RBP);
-    move_reg_mem(RSI, MTHD_ID, RBP);
-    move_reg_mem(RDX, CLASS_MEM, RBP);
-    move_reg_mem(RCX, INSTANCE_MEM, RBP);
-    move_reg_mem(R8, OP_STACK, RBP);
-    move_reg_mem(R9, STACK_POS, RBP);
-#endif
+    ProcessMethodInfo();
 
     // register root
     RegisterRoot();
@@ -5056,6 +6153,9 @@ bool JitAmd64::Compile(StackMethod* cm)
     ProcessParameters(method->GetParamCount());
     // translate program
     ProcessInstructions();
+    if(compile_success) {
+      ProcessOsrEntries();
+    }
     if(!compile_success) {
 #ifdef _WIN64
       VirtualFree(float_consts, 0, MEM_RELEASE);
@@ -5110,7 +6210,14 @@ bool JitAmd64::Compile(StackMethod* cm)
       << L", buffer=" << code_buf_max << L" byte(s)" << std::endl;
 #endif
     // store compiled code
-    method->SetNativeCode(new NativeCode(page_manager->GetPage(code, code_index), code_index, float_consts));
+    NativeCode* native_code = new NativeCode(page_manager->GetPage(code, code_index), code_index, float_consts);
+    for(std::unordered_map<long, long>::iterator entry = osr_entries.begin(); entry != osr_entries.end(); ++entry) {
+      native_code->AddOsrEntry(entry->first, entry->second);
+    }
+    method->SetNativeCode(native_code);
+    if(cacheable) {
+      StoreCachedCode(native_code);
+    }
 
     free(code);
     code = nullptr;
@@ -5126,6 +6233,241 @@ bool JitAmd64::Compile(StackMethod* cm)
   return compile_success;
 }
 
+/**
+ * Runtime functions and variables referenced by machine code, cached
+ * code refers to them by index since their addresses change between runs
+ */
+std::vector<size_t> &JitAmd64::GetRuntimeAddresses()
+{
+  typedef double(*func_ptr)(double);
+  typedef double(*func2_ptr)(double, double);
+
+  static std::vector<size_t> addresses;
+  if(addresses.empty()) {
+    addresses.push_back((size_t)MemoryManager::GetSafepointFlag());
+    addresses.push_back((size_t)MemoryManager::Safepoint);
+    addresses.push_back((size_t)MemoryManager::GetMarkingFlag());
+    addresses.push_back((size_t)MemoryManager::SatbRecord);
+    addresses.push_back(MemoryManager::GetCardTableBias());
+    addresses.push_back((size_t)JitCompiler::JitStackCallback);
+    // math functions
+    addresses.push_back((size_t)(func_ptr)trunc);
+    addresses.push_back((size_t)(func_ptr)exp);
+    addresses.push_back((size_t)(func_ptr)asin);
+    addresses.push_back((size_t)(func_ptr)acos);
+    addresses.push_back((size_t)(func_ptr)acosh);
+    addresses.push_back((size_t)(func_ptr)asinh);
+    addresses.push_back((size_t)(func_ptr)atanh);
+    addresses.push_back((size_t)(func_ptr)log2);
+    addresses.push_back((size_t)(func_ptr)cbrt);
+    addresses.push_back((size_t)(func_ptr)cosh);
+    addresses.push_back((size_t)(func_ptr)sinh);
+    addresses.push_back((size_t)(func_ptr)tanh);
+    addresses.push_back((size_t)(func_ptr)tgamma);
+    addresses.push_back((size_t)(func2_ptr)atan2);
+    addresses.push_back((size_t)(func2_ptr)fmod);
+    addresses.push_back((size_t)(func2_ptr)pow);
+  }
+
+  return addresses;
+}
+
+/**
+ * Cache file of the method, named by the program's file hash and the
+ * method's class and method ids
+ */
+std::string JitAmd64::GetCachePath()
+{
+  if(cache_dir.empty() || !program->GetFileHash()) {
+    return "";
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "/%016llx-%ld-%ld.jit", (unsigned long long)program->GetFileHash(),
+           method->GetClass()->GetId(), method->GetId());
+  return cache_dir + name;
+}
+
+/**
+ * Code generation options that change the machine code
+ */
+static int32_t GetCacheOptions(bool local_registers)
+{
+  return (MemoryManager::IsGenerational() ? 1 : 0) | (MemoryManager::IsConcurrent() ? 2 : 0) | (local_registers ? 4 : 0);
+}
+
+/**
+ * Maps the machine code of a method compiled by an earlier run and
+ * patches its absolute addresses. Files of other programs, builds or
+ * options are ignored and rewritten once the method is compiled.
+ */
+bool JitAmd64::LoadCachedCode()
+{
+#ifdef _WIN64
+  return false;
+#else
+  const std::string path = GetCachePath();
+  if(path.empty()) {
+    return false;
+  }
+
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if(fstat(fd, &info) < 0 || info.st_size < (off_t)sizeof(CodeCacheHeader)) {
+    close(fd);
+    return false;
+  }
+
+  const size_t file_size = (size_t)info.st_size;
+  unsigned char* buffer = (unsigned char*)mmap(nullptr, file_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(buffer == MAP_FAILED) {
+    return false;
+  }
+
+  // check header
+  const CodeCacheHeader* header = (CodeCacheHeader*)buffer;
+  const char* build = __DATE__ " " __TIME__;
+  const size_t tables_size = sizeof(CodeCacheHeader) + sizeof(CodeFixup) * (size_t)header->fixup_count +
+    sizeof(double) * (size_t)header->float_count + sizeof(int64_t) * 2 * (size_t)header->osr_count;
+  if(memcmp(header->magic, "OJIT", 4) || header->version != CODE_CACHE_VERSION ||
+     header->build != HashBytes(build, strlen(build)) || header->file_hash != program->GetFileHash() ||
+     header->cls_id != method->GetClass()->GetId() || header->mthd_id != method->GetId() ||
+     header->options != GetCacheOptions(local_registers) || header->fixup_count < 0 || header->osr_count < 0 ||
+     header->float_count < 1 || header->float_count > MAX_DBLS || header->code_size < 1 ||
+     header->code_offset < (int32_t)tables_size || (size_t)header->code_offset + header->code_size != file_size) {
+    munmap(buffer, file_size);
+    return false;
+  }
+
+  const CodeFixup* code_fixups = (CodeFixup*)(buffer + sizeof(CodeCacheHeader));
+  const double* cached_floats = (double*)(code_fixups + header->fixup_count);
+  const int64_t* osr = (int64_t*)(cached_floats + header->float_count);
+  unsigned char* cached_code = buffer + header->code_offset;
+
+  if(posix_memalign((void**)&float_consts, PAGE_SIZE, sizeof(double) * MAX_DBLS)) {
+    std::wcerr << L"Unable to reallocate JIT memory!" << std::endl;
+    exit(1);
+  }
+  memcpy(float_consts, cached_floats, sizeof(double) * header->float_count);
+
+  // patch addresses
+  std::vector<size_t> &addresses = GetRuntimeAddresses();
+  for(int32_t i = 0; i < header->fixup_count; ++i) {
+    const CodeFixup &fixup = code_fixups[i];
+    bool patched = fixup.offset >= 0 && fixup.offset + (int32_t)sizeof(int64_t) <= header->code_size && fixup.value >= 0;
+    size_t addr = 0;
+    if(patched) {
+      switch(fixup.type) {
+      case FIXUP_FLOAT:
+        patched = fixup.value < (int64_t)(sizeof(double) * header->float_count);
+        addr = (size_t)float_consts + (size_t)fixup.value;
+        break;
+
+      case FIXUP_INSTR:
+        patched = fixup.value < method->GetInstructionCount();
+        addr = patched ? (size_t)method->GetInstruction((long)fixup.value) : 0;
+        break;
+
+      case FIXUP_RUNTIME:
+        patched = fixup.value < (int64_t)addresses.size();
+        addr = patched ? addresses[(size_t)fixup.value] : 0;
+        break;
+
+      default:
+        patched = false;
+        break;
+      }
+    }
+
+    if(!patched) {
+      free(float_consts);
+      float_consts = nullptr;
+      munmap(buffer, file_size);
+      return false;
+    }
+    memcpy(&cached_code[fixup.offset], &addr, sizeof(addr));
+  }
+
+#ifdef _DEBUG_JIT
+  std::wcout << L"Loaded cached JIT code: file='" << BytesToUnicode(path) << L"'; size="
+    << header->code_size << L" byte(s)" << std::endl;
+#endif
+
+  NativeCode* native_code = new NativeCode(cached_code, header->code_size, float_consts);
+  for(int32_t i = 0; i < header->osr_count; ++i) {
+    native_code->AddOsrEntry((long)osr[i * 2], (long)osr[i * 2 + 1]);
+  }
+  method->SetNativeCode(native_code);
+  float_consts = nullptr;
+
+  return true;
+#endif
+}
+
+/**
+ * Writes the machine code of a compiled method to the code cache. The
+ * file is written under a temporary name and renamed, so other processes
+ * see either no file or all of it.
+ */
+void JitAmd64::StoreCachedCode(NativeCode* native_code)
+{
+#ifndef _WIN64
+  const std::string path = GetCachePath();
+  if(path.empty()) {
+    return;
+  }
+
+  CodeCacheHeader header = {};
+  const char* build = __DATE__ " " __TIME__;
+  memcpy(header.magic, "OJIT", 4);
+  header.version = CODE_CACHE_VERSION;
+  header.build = HashBytes(build, strlen(build));
+  header.file_hash = program->GetFileHash();
+  header.cls_id = method->GetClass()->GetId();
+  header.mthd_id = method->GetId();
+  header.options = GetCacheOptions(local_registers);
+  header.code_size = (int32_t)native_code->GetSize();
+  header.fixup_count = (int32_t)fixups.size();
+  header.float_count = (int32_t)floats_index;
+  header.osr_count = (int32_t)osr_entries.size();
+
+  // code is aligned to 16 bytes
+  const size_t tables_size = sizeof(CodeCacheHeader) + sizeof(CodeFixup) * fixups.size() +
+    sizeof(double) * floats_index + sizeof(int64_t) * 2 * osr_entries.size();
+  header.code_offset = (int32_t)((tables_size + 15) & ~(size_t)15);
+
+  std::vector<int64_t> osr;
+  for(std::unordered_map<long, long>::iterator entry = osr_entries.begin(); entry != osr_entries.end(); ++entry) {
+    osr.push_back(entry->first);
+    osr.push_back(entry->second);
+  }
+
+  const std::string temp_path = path + "." + std::to_string(getpid()) + ".tmp";
+  std::ofstream file_out(temp_path.c_str(), std::ofstream::binary);
+  if(!file_out.is_open()) {
+    return;
+  }
+
+  const char padding[16] = {};
+  file_out.write((const char*)&header, sizeof(header));
+  file_out.write((const char*)fixups.data(), sizeof(CodeFixup) * fixups.size());
+  file_out.write((const char*)float_consts, sizeof(double) * floats_index);
+  file_out.write((const char*)osr.data(), sizeof(int64_t) * osr.size());
+  file_out.write(padding, header.code_offset - tables_size);
+  file_out.write((const char*)code, header.code_size);
+  file_out.close();
+
+  if(!file_out || rename(temp_path.c_str(), path.c_str())) {
+    remove(temp_path.c_str());
+  }
+#endif
+}
+
 /**
  * JitExecutor class
  */
@@ -5137,7 +6479,7 @@ void JitRuntime::Initialize(StackProgram* p)
 }
 
 // Executes machine code
-long JitRuntime::Execute(StackMethod* method, size_t* inst, size_t* op_stack, long* stack_pos, StackFrame** call_stack, long* call_stack_pos, StackFrame* frame) 
+long JitRuntime::Execute(StackMethod* method, size_t* inst, size_t* op_stack, long* stack_pos, StackFrame** call_stack, long* call_stack_pos, StackFrame* frame, long entry) 
 {
   const long cls_id = method->GetClass()->GetId();
   const long mthd_id = method->GetId();
@@ -5152,7 +6494,7 @@ long JitRuntime::Execute(StackMethod* method, size_t* inst, size_t* op_stack, lo
 #endif
 
   // create function
-  jit_fun_ptr jit_fun = (jit_fun_ptr)native_code->GetCode();
+  jit_fun_ptr jit_fun = (jit_fun_ptr)(native_code->GetCode() + entry);
 
   // execute
   const long status = jit_fun(cls_id, mthd_id, method->GetClass()->GetClassMemory(), inst, op_stack,
@@ -5187,11 +6529,14 @@ RegInstr::RegInstr(StackInstr* si)
     break;
 
   case LOAD_INST_MEM:
+  case LOAD_SELF_INT_VAR:
     type = MEM_INT;
     operand = INSTANCE_MEM;
     break;
 
   case LOAD_LOCL_INT_VAR:
+  case INC_LOCL_INT_VAR:
+  case CMP_JMP_LOCL_INT_VAR:
   case LOAD_CLS_INST_INT_VAR:
   case STOR_LOCL_INT_VAR:
   case STOR_CLS_INST_INT_VAR:
@@ -88,6 +88,7 @@ namespace Runtime {
 #define MAX_DBLS 256
 #define BUFFER_SIZE 512
 #define PAGE_SIZE 4096
+#define CODE_CACHE_VERSION 1
 
   // register type
   typedef enum _RegType {
@@ -310,12 +311,66 @@ namespace Runtime {
 
     unsigned char* GetPage(unsigned char* code, int32_t size);
   };
+
+  /**
+   * Absolute addresses in machine code, patched when code is loaded from
+   * the code cache
+   */
+  enum CodeFixupType {
+    FIXUP_FLOAT = 0, // byte offset into the method's float constants
+    FIXUP_INSTR,     // index of the method instruction
+    FIXUP_RUNTIME    // index of a runtime function or variable
+  };
+
+  struct CodeFixup {
+    int32_t offset;
+    int32_t type;
+    int64_t value;
+  };
+
+  /**
+   * Code cache file header, followed by fixups, float constants,
+   * on-stack replacement entries and machine code
+   */
+  struct CodeCacheHeader {
+    char magic[4];
+    int32_t version;
+    uint64_t build;
+    uint64_t file_hash;
+    int32_t cls_id;
+    int32_t mthd_id;
+    int32_t options;
+    int32_t code_size;
+    int32_t code_offset;
+    int32_t fixup_count;
+    int32_t float_count;
+    int32_t osr_count;
+  };
+
+  /**
+   * Instructions over which a local is held in a register. The register
+   * is loaded from the local's stack slot where the range starts and
+   * stores write both, so the slot stays current for the collector.
+   * Array sizes and fields that do not change in a loop are held the
+   * same way, loaded through the slot holding the array or instance.
+   */
+  struct LocalRange {
+    long offset;
+    long field; // array size or field offset, -1 for locals
+    long start;
+    long end;
+    long weight;
+    bool is_float;
+    Register reg;
+  };
   
   /**
    * JIT compiler class for AMD64
    */
   class JitAmd64 : public JitCompiler {
     static PageManager* page_manager;
+    static bool local_registers;
+    static std::string cache_dir;
     std::deque<RegInstr*> working_stack;
     std::vector<RegisterHolder*> aval_regs;
     std::list<RegisterHolder*> used_regs;
@@ -328,6 +383,15 @@ namespace Runtime {
     std::vector<long> bounds_less_offsets;    // code -2
     std::vector<long> bounds_greater_offsets; // code -3
     std::vector<long> div_by_zero_offsets;    // code -4
+    std::unordered_map<long, long> osr_entries; // loop headers to code offsets
+    std::vector<LocalRange> local_ranges;       // locals held in registers
+    std::vector<LocalRange> loop_loads;         // values loaded in loops
+    std::vector<long> loop_depths;              // loop depth of instructions
+    std::set<long> checked_elements;            // array accesses within bounds
+    std::unordered_map<long, long> size_loads;  // array size loads to array slots
+    std::vector<CodeFixup> fixups;              // absolute addresses in code
+    bool cacheable;                             // all addresses have fixups
+    long local_index;                           // instruction being translated, -1 if none
     long local_space, org_local_space;
     StackMethod* method;
     long instr_count;
@@ -346,12 +410,15 @@ namespace Runtime {
     void Epilog();
 
     // stack conversion operations
+    void ProcessMethodInfo();
     void ProcessParameters(long count);
     void RegisterRoot();
+    void ProcessOsrEntries();
     void ProcessInstructions();
     void ProcessLoad(StackInstr* instr);
     void ProcessStore(StackInstr* instruction);
     void ProcessCopy(StackInstr* instr);
+    void ProcessArraySize(StackInstr* instr);
     RegInstr* ProcessIntFold(int64_t left_imm, int64_t right_imm, InstructionType type);
     void ProcessIntCalculation(StackInstr* instruction);
     void ProcessFloatCalculation(StackInstr* instruction);
@@ -375,6 +442,8 @@ namespace Runtime {
     void ProcessLoadFloatElement(StackInstr* instr);
     void ProcessStoreFloatElement(StackInstr* instr);
     void ProcessJump(StackInstr* instr);
+    void ProcessSafepoint();
+    void SatbBarrier(Register reg, long offset);
     void ProcessFloor(StackInstr* instr);
     void ProcessCeiling(StackInstr* instr);
     void ProcessFloatToInt(StackInstr* instr);
@@ -578,6 +647,24 @@ namespace Runtime {
       // jump to exit
     }
 
+    /**
+     * Marks the card of a reference stored into heap memory
+     */
+    inline void MarkCard(Register reg, long offset) {
+      if(MemoryManager::IsGenerational()) {
+        RegisterHolder* card_holder = GetRegister();
+        RegisterHolder* table_holder = GetRegister();
+        move_imm_reg((int64_t)offset, card_holder->GetRegister());
+        add_reg_reg(reg, card_holder->GetRegister());
+        shr_imm_reg(HEAP_CARD_SHIFT, card_holder->GetRegister());
+        move_runtime_reg(MemoryManager::GetCardTableBias(), table_holder->GetRegister());
+        add_reg_reg(table_holder->GetRegister(), card_holder->GetRegister());
+        move_imm_mem8(1, 0, card_holder->GetRegister());
+        ReleaseRegister(table_holder);
+        ReleaseRegister(card_holder);
+      }
+    }
+
     /**
      * Check for divide by 0
      */
@@ -769,6 +856,9 @@ namespace Runtime {
     void move_imm_reg(long imm, Register reg);
 #endif  
     void move_imm_xreg(RegInstr* instr, Register reg);
+    void move_const_reg(size_t addr, Register reg);
+    void move_runtime_reg(size_t addr, Register reg);
+    void move_instr_reg(StackInstr* instr, Register reg);
     void move_mem_xreg(long offset, Register src, Register dest);
     void move_xreg_mem(Register src, long offset, Register dest);
     void move_xreg_xreg(Register src, Register dest);
@@ -892,6 +982,36 @@ namespace Runtime {
     // Calculates the indices for memory references.
     void ProcessIndices();
 
+    // Finds counted loops and values loaded in loops
+    void ProcessLoops();
+    bool IsLoopInvariant(const LocalRange &range);
+    bool IsLocalIncrement(long index, long offset);
+
+    inline bool IsLocalLoad(StackInstr* instr, long offset) {
+      return instr->GetType() == LOAD_LOCL_INT_VAR && instr->GetOperand2() == LOCL && instr->GetOperand3() == offset;
+    }
+
+    inline bool IsLocalStore(StackInstr* instr, long offset) {
+      return (instr->GetType() == STOR_LOCL_INT_VAR || instr->GetType() == COPY_LOCL_INT_VAR) &&
+        instr->GetOperand2() == LOCL && instr->GetOperand3() == offset;
+    }
+
+    inline long LoopWeight(long index) {
+      return 1L << (3 * (loop_depths[index] < 6 ? loop_depths[index] : 6));
+    }
+
+    // Assigns registers to locals referenced in loops (linear scan)
+    void AllocateLocals();
+    void LoadLocals(long index, bool reload);
+    bool GetLocalRegister(long offset, Register base, Register &reg);
+    bool GetLoadRegister(long offset, long field, Register &reg);
+
+    // Persistent code cache, keyed by the program's file hash and method id
+    static std::vector<size_t> &GetRuntimeAddresses();
+    std::string GetCachePath();
+    bool LoadCachedCode();
+    void StoreCachedCode(NativeCode* native_code);
+
   public:
     static void Initialize(StackProgram* p);
 
@@ -981,7 +1101,7 @@ namespace Runtime {
 
     // Executes machine code
     long Execute(StackMethod* method, size_t* inst, size_t* op_stack, long* stack_pos, 
-                 StackFrame** call_stack, long* call_stack_pos, StackFrame* frame);
+                 StackFrame** call_stack, long* call_stack_pos, StackFrame* frame, long entry = 0);
   };
 }
 #endif
@@ -361,8 +361,9 @@ void JitArm64::ProcessInstructions() {
       working_stack.push_front(new RegInstr(&float_consts[floats_index++]));
       break;
       
-      // load self
-    case LOAD_INST_MEM: {
+      // load self, superinstruction is compiled as its first instruction
+    case LOAD_INST_MEM:
+    case LOAD_SELF_INT_VAR: {
 #ifdef _DEBUG_JIT_JIT
       wcout << L"LOAD_INST_MEM; regs=" << aval_regs.size() << endl;
 #endif
@@ -379,8 +380,10 @@ void JitArm64::ProcessInstructions() {
     }
       break;
       
-      // load variable
+      // load variable, superinstructions are compiled as their first instruction
     case LOAD_LOCL_INT_VAR:
+    case INC_LOCL_INT_VAR:
+    case CMP_JMP_LOCL_INT_VAR:
     case LOAD_CLS_INST_INT_VAR:
     case LOAD_FLOAT_VAR:
     case LOAD_FUNC_VAR:
@@ -555,8 +558,8 @@ void JitArm64::ProcessInstructions() {
 #ifdef _DEBUG_JIT_JIT
       wcout << L"DYN_MTHD_CALL: regs=" << aval_regs.size() << endl;
 #endif
-      // passing instance variable
-      ProcessStackCallback(DYN_MTHD_CALL, instr, instr_index, instr->GetOperand() + 3);
+      // passing instance and packed class/method ids
+      ProcessStackCallback(DYN_MTHD_CALL, instr, instr_index, instr->GetOperand() + 2);
       ProcessReturnParameters((MemoryType)instr->GetOperand2());
     }
       break;
@@ -677,7 +680,7 @@ void JitArm64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_BYTE_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_BYTE_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_BYTE_ARY, instr, instr_index, 1);
     }
       break;
 
@@ -685,7 +688,7 @@ void JitArm64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_CHAR_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_CHAR_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_CHAR_ARY, instr, instr_index, 1);
     }
       break;
 
@@ -693,7 +696,7 @@ void JitArm64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_INT_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_INT_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_INT_ARY, instr, instr_index, 1);
     }
       break;
 
@@ -701,7 +704,7 @@ void JitArm64::ProcessInstructions() {
 #ifdef _DEBUG_JIT
       std::wcout << L"ZERO_FLOAT_ARY: regs=" << aval_regs.size() << L"," << aux_regs.size() << std::endl;
 #endif
-      ProcessStackCallback(ZERO_FLOAT_ARY, instr, instr_index, 5);
+      ProcessStackCallback(ZERO_FLOAT_ARY, instr, instr_index, 1);
     }
       break;
  
@@ -821,7 +824,7 @@ void JitArm64::ProcessInstructions() {
 #ifdef _DEBUG_JIT_JIT
       wcout << L"S2F: regs=" << aval_regs.size() << endl;
 #endif
-      ProcessStackCallback(S2F, instr, instr_index, 2);
+      ProcessStackCallback(S2F, instr, instr_index, 1);
       ProcessReturnParameters(FLOAT_TYPE);
       break;
       
@@ -898,10 +901,13 @@ void JitArm64::ProcessInstructions() {
 #endif
       break;
       
+      // unsupported, method is interpreted
     default: {
+#ifdef _DEBUG_JIT
       InstructionType error = (InstructionType)instr->GetType();
-      wcerr << L"Unknown instruction: " << error << L"!" << endl;
-      exit(1);
+      wcerr << L"Unsupported instruction: " << error << L"!" << endl;
+#endif
+      compile_success = false;
     }
       break;
     }
@@ -973,6 +979,11 @@ void JitArm64::ProcessJump(StackInstr* instr) {
     wcout << L"JMP: id=" << instr->GetOperand() << L", regs=" << aval_regs.size()
           << endl;
 #endif
+    // poll on backward jumps
+    if(instr->GetOperand() < instr_index) {
+      ProcessSafepoint();
+    }
+
     if(instr->GetOperand2() < 0) {
 #ifdef _DEBUG_JIT_JIT
       wcout << L"  " << (++instr_count) << L": [b <imm>]" << endl;
@@ -1041,6 +1052,82 @@ void JitArm64::ProcessJump(StackInstr* instr) {
   }
 }
 
+/**
+ * Safepoint poll, parks the thread while memory is collected. Live
+ * registers are saved to the temporary slots, which are checked as
+ * roots, before calling the memory manager.
+ */
+void JitArm64::ProcessSafepoint() {
+  RegisterHolder* flag_holder = GetRegister();
+  move_imm_reg((size_t)MemoryManager::GetSafepointFlag(), flag_holder->GetRegister());
+  move_mem8_reg(0, flag_holder->GetRegister(), flag_holder->GetRegister());
+  cmp_imm_reg(0, flag_holder->GetRegister());
+  ReleaseRegister(flag_holder);
+
+  // skip if not requested
+#ifdef _DEBUG_JIT_JIT
+  std::wcout << L"  " << (++instr_count) << L": [b.eq <safepoint>]" << std::endl;
+#endif
+  const long skip_index = code_index;
+  AddMachineCode(0x54000000);
+
+  stack<RegInstr*> regs;
+  stack<int32_t> dirty_regs;
+  int32_t reg_offset = TMP_X0;
+
+  stack<RegInstr*> fp_regs;
+  stack<int32_t> dirty_fp_regs;
+  int32_t fp_offset = TMP_D0;
+
+  for(deque<RegInstr*>::iterator iter = working_stack.begin(); iter != working_stack.end(); ++iter) {
+    RegInstr* left = (*iter);
+    switch(left->GetType()) {
+    case REG_INT:
+      move_reg_mem(left->GetRegister()->GetRegister(), reg_offset, SP);
+      dirty_regs.push(reg_offset);
+      regs.push(left);
+      reg_offset += sizeof(size_t);
+      break;
+
+    case REG_FLOAT:
+      move_freg_mem(left->GetRegister()->GetRegister(), fp_offset, SP);
+      dirty_fp_regs.push(fp_offset);
+      fp_regs.push(left);
+      fp_offset += sizeof(size_t);
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  if(dirty_regs.size() > 6 || dirty_fp_regs.size() > 4 ) {
+    compile_success = false;
+  }
+
+  move_imm_reg((size_t)MemoryManager::Safepoint, X10);
+  call_reg(X10);
+
+  // restore register values
+  while(!dirty_regs.empty()) {
+    RegInstr* left = regs.top();
+    move_mem_reg(dirty_regs.top(), SP, left->GetRegister()->GetRegister());
+    regs.pop();
+    dirty_regs.pop();
+  }
+
+  while(!dirty_fp_regs.empty()) {
+    RegInstr* left = fp_regs.top();
+    move_mem_freg(dirty_fp_regs.top(), SP, left->GetRegister()->GetRegister());
+    fp_regs.pop();
+    dirty_fp_regs.pop();
+  }
+
+  // update skip offset
+  const int32_t skip_offset = (int32_t)(code_index - skip_index);
+  code[skip_index] |= (skip_offset & 0x7ffff) << 5;
+}
+
 void JitArm64::ProcessReturnParameters(MemoryType type) {
   switch(type) {
   case INT_TYPE:
@@ -1165,6 +1252,7 @@ void JitArm64::ProcessStoreCharElement(StackInstr* instr) {
 
 void JitArm64::ProcessStoreIntElement(StackInstr* instr) {
   RegisterHolder* elem_holder = ArrayIndex(instr, INT_TYPE);
+  SatbBarrier(elem_holder->GetRegister(), 0);
   RegInstr* left = working_stack.front();
   working_stack.pop_front();
   
@@ -1191,6 +1279,11 @@ void JitArm64::ProcessStoreIntElement(StackInstr* instr) {
   default:
     break;
   }
+
+  // reference stored into an array
+  if(left->GetType() == MEM_INT || left->GetType() == REG_INT) {
+    MarkCard(elem_holder->GetRegister(), 0);
+  }
   ReleaseRegister(elem_holder);
   
   delete left;
@@ -1318,6 +1411,16 @@ void JitArm64::ProcessStore(StackInstr* instr) {
     left = nullptr;
   }
   
+  // references overwritten in class or instance memory
+  if(addr_holder && instr->GetType() != STOR_FLOAT_VAR) {
+    if(instr->GetType() == STOR_FUNC_VAR) {
+      SatbBarrier(dest, instr->GetOperand3() + sizeof(size_t));
+    }
+    else {
+      SatbBarrier(dest, instr->GetOperand3());
+    }
+  }
+  
   RegInstr* left = working_stack.front();
   working_stack.pop_front();
   
@@ -1401,6 +1504,16 @@ void JitArm64::ProcessStore(StackInstr* instr) {
     break;
   }
 
+  // reference stored into an instance
+  if(instr->GetOperand2() == INST && (left->GetType() == MEM_INT || left->GetType() == REG_INT)) {
+    if(instr->GetType() == STOR_FUNC_VAR) {
+      MarkCard(dest, instr->GetOperand3() + sizeof(size_t));
+    }
+    else {
+      MarkCard(dest, instr->GetOperand3());
+    }
+  }
+
   if(addr_holder) {
     ReleaseRegister(addr_holder);
   }
@@ -1409,8 +1522,78 @@ void JitArm64::ProcessStore(StackInstr* instr) {
   left = nullptr;
 }
 
+/**
+ * Snapshot barrier, records the value about to be overwritten while
+ * memory is concurrently marked. Registers are saved in a stack area
+ * above the link register slot used by calls.
+ */
+void JitArm64::SatbBarrier(Register reg, long offset) {
+  if(!MemoryManager::IsConcurrent()) {
+    return;
+  }
+
+  RegisterHolder* flag_holder = GetRegister();
+  move_imm_reg((size_t)MemoryManager::GetMarkingFlag(), flag_holder->GetRegister());
+  move_mem8_reg(0, flag_holder->GetRegister(), flag_holder->GetRegister());
+  cmp_imm_reg(0, flag_holder->GetRegister());
+  ReleaseRegister(flag_holder);
+
+  // skip if not marking
+#ifdef _DEBUG_JIT_JIT
+  std::wcout << L"  " << (++instr_count) << L": [b.eq <satb>]" << std::endl;
+#endif
+  const long skip_index = code_index;
+  AddMachineCode(0x54000000);
+
+  const Register save_regs[] = { X0, X1, X2, X3, X4, X5, X6, X7, X9, X10, X11, X12, X13, X14, X15 };
+  const Register save_fregs[] = { D0, D1, D2, D3, D4, D5, D6, D7 };
+  const int num_regs = sizeof(save_regs) / sizeof(Register);
+  const int num_fregs = sizeof(save_fregs) / sizeof(Register);
+  const uint32_t save_size = 304;
+
+#ifdef _DEBUG_JIT_JIT
+  wcout << L"  " << (++instr_count) << L": [sub sp, sp, #" << save_size << L"]" << endl;
+#endif
+  AddMachineCode(0xD10003FF | (save_size << 10));
+
+  int32_t save_offset = TMP_LR + sizeof(size_t);
+  for(int i = 0; i < num_regs; ++i) {
+    move_reg_mem(save_regs[i], save_offset, SP);
+    save_offset += sizeof(size_t);
+  }
+  for(int i = 0; i < num_fregs; ++i) {
+    move_freg_mem(save_fregs[i], save_offset, SP);
+    save_offset += sizeof(size_t);
+  }
+
+  move_mem_reg(offset, reg, X0);
+  move_imm_reg((size_t)MemoryManager::SatbRecord, X10);
+  call_reg(X10);
+
+  save_offset = TMP_LR + sizeof(size_t);
+  for(int i = 0; i < num_regs; ++i) {
+    move_mem_reg(save_offset, SP, save_regs[i]);
+    save_offset += sizeof(size_t);
+  }
+  for(int i = 0; i < num_fregs; ++i) {
+    move_mem_freg(save_offset, SP, save_fregs[i]);
+    save_offset += sizeof(size_t);
+  }
+
+#ifdef _DEBUG_JIT_JIT
+  wcout << L"  " << (++instr_count) << L": [add sp, sp, #" << save_size << L"]" << endl;
+#endif
+  AddMachineCode(0x910003FF | (save_size << 10));
+
+  // update skip offset
+  const int32_t skip_offset = (int32_t)(code_index - skip_index);
+  code[skip_index] |= (skip_offset & 0x7ffff) << 5;
+}
+
 void JitArm64::ProcessCopy(StackInstr* instr) {
   Register dest;
+  RegisterHolder* addr_holder = nullptr;
+
   // instance/method memory
   if(instr->GetOperand2() == LOCL) {
     dest = SP;
@@ -1420,16 +1603,20 @@ void JitArm64::ProcessCopy(StackInstr* instr) {
     RegInstr* left = working_stack.front();
     working_stack.pop_front();
 
-    RegisterHolder* holder = GetRegister();
-    move_mem_reg(left->GetOperand(), SP, holder->GetRegister());
-    CheckNilDereference(holder->GetRegister());
-    dest = holder->GetRegister();
-    ReleaseRegister(holder);
+    addr_holder = GetRegister();
+    move_mem_reg(left->GetOperand(), SP, addr_holder->GetRegister());
+    CheckNilDereference(addr_holder->GetRegister());
+    dest = addr_holder->GetRegister();
     
     delete left;
     left = nullptr;
   }
   
+  // reference overwritten in class or instance memory
+  if(addr_holder && instr->GetType() == COPY_CLS_INST_INT_VAR) {
+    SatbBarrier(dest, instr->GetOperand3());
+  }
+  
   RegInstr* left = working_stack.front();
   switch(left->GetType()) {
   case IMM_INT: {
@@ -1496,6 +1683,14 @@ void JitArm64::ProcessCopy(StackInstr* instr) {
   }
     break;
   }
+
+  if(addr_holder) {
+    // reference copied into an instance
+    if(instr->GetOperand2() == INST && instr->GetType() == COPY_CLS_INST_INT_VAR) {
+      MarkCard(dest, instr->GetOperand3());
+    }
+    ReleaseRegister(addr_holder);
+  }
 }
 
 void JitArm64::ProcessStackCallback(long instr_id, StackInstr* instr, long &instr_index, long params) {
@@ -4136,6 +4331,8 @@ void JitArm64::ProcessIndices()
     StackInstr* instr = method->GetInstruction(i);
     switch(instr->GetType()) {
     case LOAD_LOCL_INT_VAR:
+    case INC_LOCL_INT_VAR:
+    case CMP_JMP_LOCL_INT_VAR:
     case LOAD_CLS_INST_INT_VAR:
     case STOR_LOCL_INT_VAR:
     case STOR_CLS_INST_INT_VAR:
@@ -4168,6 +4365,8 @@ void JitArm64::ProcessIndices()
     else {
       if(last_id != id) {
         if(instr->GetType() == LOAD_LOCL_INT_VAR ||
+           instr->GetType() == INC_LOCL_INT_VAR ||
+           instr->GetType() == CMP_JMP_LOCL_INT_VAR ||
            instr->GetType() == LOAD_CLS_INST_INT_VAR ||
            instr->GetType() == STOR_LOCL_INT_VAR ||
            instr->GetType() == STOR_CLS_INST_INT_VAR ||
@@ -4431,7 +4630,7 @@ void JitRuntime::Initialize(StackProgram* p)
 
 // Executes machine code
 long JitRuntime::Execute(StackMethod* method, size_t* inst, size_t* op_stack, long* stack_pos,
-                          StackFrame** call_stack, long* call_stack_pos, StackFrame* frame)
+                          StackFrame** call_stack, long* call_stack_pos, StackFrame* frame, long entry)
 {
   const int32_t cls_id = method->GetClass()->GetId();
   const int32_t mthd_id = method->GetId();
@@ -4449,7 +4648,7 @@ long JitRuntime::Execute(StackMethod* method, size_t* inst, size_t* op_stack, lo
   
   // create function
   uint32_t* code = native_code->GetCode();
-  jit_fun_ptr jit_fun = (jit_fun_ptr)code;
+  jit_fun_ptr jit_fun = (jit_fun_ptr)(code + entry);
   
   // execute
   const long rtrn_value = jit_fun(cls_id, mthd_id, method->GetClass()->GetClassMemory(), inst, op_stack, stack_pos,
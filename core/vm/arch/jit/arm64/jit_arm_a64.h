@@ -203,11 +203,14 @@ namespace Runtime {
         break;
 
       case LOAD_INST_MEM:
+      case LOAD_SELF_INT_VAR:
         type = MEM_INT;
         operand = INSTANCE_MEM;
         break;
 
       case LOAD_LOCL_INT_VAR:
+      case INC_LOCL_INT_VAR:
+      case CMP_JMP_LOCL_INT_VAR:
       case LOAD_CLS_INST_INT_VAR:
       case STOR_LOCL_INT_VAR:
       case STOR_CLS_INST_INT_VAR:
@@ -377,6 +380,8 @@ namespace Runtime {
     void ProcessLoadFloatElement(StackInstr* instr);
     void ProcessStoreFloatElement(StackInstr* instr);
     void ProcessJump(StackInstr* instr);
+    void ProcessSafepoint();
+    void SatbBarrier(Register reg, long offset);
     void ProcessFloatToInt(StackInstr* instr);
     void ProcessIntToFloat(StackInstr* instr);
     
@@ -418,6 +423,24 @@ namespace Runtime {
       // ...
     }
 
+    /**
+     * Marks the card of a reference stored into heap memory
+     */
+    inline void MarkCard(Register reg, long offset) {
+      if(MemoryManager::IsGenerational()) {
+        RegisterHolder* card_holder = GetRegister();
+        RegisterHolder* table_holder = GetRegister();
+        move_imm_reg(offset, card_holder->GetRegister());
+        add_reg_reg(reg, card_holder->GetRegister());
+        shr_imm_reg(HEAP_CARD_SHIFT, card_holder->GetRegister());
+        move_imm_reg((long)MemoryManager::GetCardTableBias(), table_holder->GetRegister());
+        add_reg_reg(table_holder->GetRegister(), card_holder->GetRegister());
+        move_imm_mem8(1, 0, card_holder->GetRegister());
+        ReleaseRegister(table_holder);
+        ReleaseRegister(card_holder);
+      }
+    }
+
     /**
      * Check for divide by 0
      */
@@ -781,7 +804,7 @@ namespace Runtime {
     
     // Executes machine code
     long Execute(StackMethod* method, size_t* inst, size_t* op_stack, long* stack_pos,
-                 StackFrame** call_stack, long* call_stack_pos, StackFrame* frame);
+                 StackFrame** call_stack, long* call_stack_pos, StackFrame* frame, long entry = 0);
   };
 }
 #endif
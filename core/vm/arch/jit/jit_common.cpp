@@ -69,6 +69,11 @@ void JitCompiler::JitStackCallback(const long instr_id, StackInstr* instr, const
     StackMethod* called = program->GetClass(instr->GetOperand())->GetMethod(instr->GetOperand2());
     std::wcout << L"jit oper: MTHD_CALL: mthd=" << called->GetName() << std::endl;
 #endif
+    // callee with native code, no need for an interpreter
+    if(Runtime::StackInterpreter::JitMethodCall(instr, op_stack, stack_pos, call_stack, call_stack_pos)) {
+      break;
+    }
+
     Runtime::StackInterpreter intpr(call_stack, call_stack_pos);
     intpr.Execute(op_stack, stack_pos, ip, program->GetClass(cls_id)->GetMethod(mthd_id), inst, true);
   }
@@ -312,8 +317,16 @@ void JitCompiler::JitStackCallback(const long instr_id, StackInstr* instr, const
     size_t* str_ptr = (size_t*)PopInt(op_stack, stack_pos);
     if(str_ptr) {
       wchar_t* str = (wchar_t*)(str_ptr + 3);
-      const FLOAT_VALUE value = std::stod(str);
-      PushFloat(value, op_stack, stack_pos);
+      try {
+        const FLOAT_VALUE value = std::stod(str);
+        PushFloat(value, op_stack, stack_pos);
+      }
+      catch(std::invalid_argument& e) {
+#ifdef _WIN32
+        UNREFERENCED_PARAMETER(e);
+#endif
+        PushFloat(0.0, op_stack, stack_pos);
+      }
     }
     else {
       std::wcerr << L">>> Attempting to dereference a 'Nil' memory instance <<<" << std::endl;
@@ -410,6 +423,7 @@ void JitCompiler::JitStackCallback(const long instr_id, StackInstr* instr, const
       exit(1);
     }
 
+    MemoryManager::EnterSafeRegion();
 #ifdef _WIN32
     HANDLE vm_thread = (HANDLE)instance[0];
     if(WaitForSingleObject(vm_thread, INFINITE) != WAIT_OBJECT_0) {
@@ -424,15 +438,18 @@ void JitCompiler::JitStackCallback(const long instr_id, StackInstr* instr, const
       exit(-1);
     }
 #endif      
+    MemoryManager::LeaveSafeRegion();
   }
     break;
 
   case THREAD_SLEEP:
+    MemoryManager::EnterSafeRegion();
 #ifdef _WIN32    
     Sleep((DWORD)PopInt(op_stack, stack_pos));
 #else
     usleep(PopInt(op_stack, stack_pos));
 #endif      
+    MemoryManager::LeaveSafeRegion();
     break;
 
   case THREAD_MUTEX: {
@@ -457,11 +474,13 @@ void JitCompiler::JitStackCallback(const long instr_id, StackInstr* instr, const
       std::wcerr << L"  native method: name=" << program->GetClass(cls_id)->GetMethod(mthd_id)->GetName() << std::endl;
       exit(1);
     }
+    MemoryManager::EnterSafeRegion();
 #ifdef _WIN32      
     EnterCriticalSection((CRITICAL_SECTION*)&instance[1]);
 #else
     pthread_mutex_lock((pthread_mutex_t*)&instance[1]);
 #endif      
+    MemoryManager::LeaveSafeRegion();
   }
     break;
 
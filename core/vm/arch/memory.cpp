@@ -1,1545 +1,2678 @@
-/***************************************************************************
-* VM memory manager. Implements a "mark and sweep" collection algorithm.
-*
-* Copyright (c) 2023, Randy Hollines
-* All rights reserved.
-*
-* Redistribution and use in source and binary forms, with or without
-* modification, are permitted provided that the following conditions are met:
-*
-* - Redistributions of source code must retain the above copyright
-* notice, this list of conditions and the following disclaimer.
-* - Redistributions in binary form must reproduce the above copyright
-* notice, this list of conditions and the following disclaimer in
-* the documentation and/or other materials provided with the distribution.
-* - Neither the name of the Objeck Team nor the names of its
-* contributors may be used to endorse or promote products derived
-* from this software without specific prior written permission.
-*
-* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
-* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
-* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
-* TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
-*  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
-* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
-* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-***************************************************************************/
-
-#include "memory.h"
-#include <iomanip>
-
-StackProgram* MemoryManager::prgm;
-
-std::unordered_set<StackFrame**> MemoryManager::pda_frames;
-std::unordered_set<StackFrameMonitor*> MemoryManager::pda_monitors;
-std::vector<StackFrame*> MemoryManager::jit_frames;
-std::set<size_t*> MemoryManager::allocated_memory;
-
-std::unordered_map<size_t, std::list<size_t*>*> MemoryManager::free_memory_cache;
-size_t MemoryManager::free_memory_cache_size;
-
-bool MemoryManager::initialized;
-size_t MemoryManager::allocation_size;
-size_t MemoryManager::mem_max_size;
-size_t MemoryManager::uncollected_count;
-size_t MemoryManager::collected_count;
-
-#ifdef _MEM_LOGGING
-ofstream MemoryManager::mem_logger;
-long MemoryManager::mem_cycle = 0L;
-#endif
-
-// operation locks
-#ifdef _WIN32
-CRITICAL_SECTION MemoryManager::jit_frame_lock;
-CRITICAL_SECTION MemoryManager::pda_frame_lock;
-CRITICAL_SECTION MemoryManager::pda_monitor_lock;
-CRITICAL_SECTION MemoryManager::allocated_lock;
-CRITICAL_SECTION MemoryManager::marked_lock;
-CRITICAL_SECTION MemoryManager::marked_sweep_lock;
-CRITICAL_SECTION MemoryManager::free_memory_cache_lock;
-#else
-pthread_mutex_t MemoryManager::pda_monitor_lock = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t MemoryManager::pda_frame_lock = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t MemoryManager::jit_frame_lock = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t MemoryManager::allocated_lock = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t MemoryManager::marked_lock = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t MemoryManager::marked_sweep_lock = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t MemoryManager::free_memory_cache_lock = PTHREAD_MUTEX_INITIALIZER;
-#endif
-
-void MemoryManager::Initialize(StackProgram* p)
-{
-  prgm = p;
-  allocation_size = 0;
-  mem_max_size = MEM_START_MAX;
-  uncollected_count = 0;
-  free_memory_cache_size = 0;
-
-#ifdef _MEM_LOGGING
-  mem_logger.open("mem_log.csv");
-  mem_logger << L"cycle,oper,type,addr,size" << std::endl;
-#endif
-
-#ifdef _WIN32
-  InitializeCriticalSection(&jit_frame_lock);
-  InitializeCriticalSection(&pda_frame_lock);
-  InitializeCriticalSection(&pda_monitor_lock);
-  InitializeCriticalSection(&allocated_lock);
-  InitializeCriticalSection(&marked_lock);
-  InitializeCriticalSection(&marked_sweep_lock);
-  InitializeCriticalSection(&free_memory_cache_lock);
-#endif
-
-  initialized = true;
-}
-
-// if return true, trace memory otherwise do not
-inline bool MemoryManager::MarkMemory(size_t* mem)
-{
-  if(mem) {
-    // check if memory has been marked
-    if(mem[MARKED_FLAG]) {
-      return false;
-    }
-
-    // mark & add to list
-#ifndef _GC_SERIAL
-    MUTEX_LOCK(&marked_lock);
-#endif
-    mem[MARKED_FLAG] = 1L;
-#ifndef _GC_SERIAL
-    MUTEX_UNLOCK(&marked_lock);
-#endif
-
-    return true;
-  }
-  
-  return false;
-}
-
-// if return true, trace memory otherwise do not
-inline bool MemoryManager::MarkValidMemory(size_t* mem)
-{
-  if(mem) {
-    // check if memory has been marked
-    if(mem[MARKED_FLAG]) {
-      return false;
-    }
-
-    // mark & add to list
-#ifndef _GC_SERIAL
-    MUTEX_LOCK(&marked_lock);
-#endif
-    mem[MARKED_FLAG] = 1L;
-#ifndef _GC_SERIAL
-    MUTEX_UNLOCK(&marked_lock);
-#endif
-    return true;
-  }
-
-  return false;
-}
-
-void MemoryManager::AddPdaMethodRoot(StackFrame** frame)
-{
-  if(!initialized) {
-    return;
-  }
-
-#ifdef _DEBUG_GC
-  std::wcout << L"adding PDA frame: addr=" << frame << std::endl;
-#endif
-
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&pda_frame_lock);
-#endif
-  pda_frames.insert(frame);
-  
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&pda_frame_lock);
-#endif
-}
-
-void MemoryManager::RemovePdaMethodRoot(StackFrame** frame)
-{
-#ifdef _DEBUG_GC
-  std::wcout << L"removing PDA frame: addr=" << frame << std::endl;
-#endif
-  
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&pda_frame_lock);
-#endif
-  pda_frames.erase(frame);
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&pda_frame_lock);
-#endif
-}
-
-void MemoryManager::AddPdaMethodRoot(StackFrameMonitor* monitor)
-{
-#ifdef _DEBUG_GC
-  std::wcout << L"adding PDA method: monitor=" << monitor << std::endl;
-#endif
-
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&pda_monitor_lock);
-#endif
-  pda_monitors.insert(monitor);
-  
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&pda_monitor_lock);
-#endif
-}
-
-void MemoryManager::RemovePdaMethodRoot(StackFrameMonitor* monitor)
-{
-  if(!initialized) {
-    return;
-  }
-
-#ifdef _DEBUG_GC
-  std::wcout << L"removing PDA method: monitor=" << monitor << std::endl;
-#endif
-
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&pda_monitor_lock);
-#endif
-  pda_monitors.erase(monitor);
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&pda_monitor_lock);
-#endif
-}
-
-size_t* MemoryManager::AllocateObject(const long obj_id, size_t* op_stack, long stack_pos, bool collect)
-{
-  StackClass* cls = prgm->GetClass(obj_id);
-#ifdef _DEBUG_GC
-  assert(cls);
-#endif
-
-  size_t* mem = nullptr;
-  if(cls) {
-    const long size = cls->GetInstanceMemorySize();
-
-    // collect memory
-    if(collect && allocation_size + size > mem_max_size) {
-      CollectAllMemory(op_stack, stack_pos);
-    }
-
-    // allocate memory
-#ifdef _DEBUG_GC
-    bool is_cached = false;
-#endif
-    const size_t alloc_size = size * 2 + sizeof(size_t) * EXTRA_BUF_SIZE;
-    
-    mem = GetMemory(alloc_size);
-    mem[EXTRA_BUF_SIZE + TYPE] = NIL_TYPE;
-    mem[EXTRA_BUF_SIZE + SIZE_OR_CLS] = (size_t)cls;
-    mem += EXTRA_BUF_SIZE;
-
-    // record
- #ifndef _GC_SERIAL
-    MUTEX_LOCK(&allocated_lock);
- #endif
-    allocation_size += size;
-    allocated_memory.insert(mem);
- #ifndef _GC_SERIAL
-    MUTEX_UNLOCK(&allocated_lock);
- #endif
-
-#ifdef _MEM_LOGGING
-    mem_logger << mem_cycle << L",alloc,obj," << mem << L"," << size << std::endl;
-#endif
-
-#ifdef _DEBUG_GC
-    std::wcout << L"# allocating object: cached=" << (is_cached ? L"true" : L"false")  << L", addr=" << mem << L"(" 
-          << (size_t)mem << L"), size=" << size << L" byte(s), used=" << allocation_size << L" byte(s) #"
-          << std::endl;
-#endif
-  }
-
-  return mem;
-}
-
-size_t* MemoryManager::AllocateArray(const size_t size, const MemoryType type, size_t* op_stack, long stack_pos, bool collect)
-{
-  size_t calc_size;
-  size_t* mem;
-  switch (type) {
-  case BYTE_ARY_TYPE:
-    calc_size = size * sizeof(char);
-    break;
-
-  case CHAR_ARY_TYPE:
-    calc_size = size * sizeof(wchar_t);
-    break;
-
-  case INT_TYPE:
-    calc_size = size * sizeof(size_t);
-    break;
-
-  case FLOAT_TYPE:
-    calc_size = size * sizeof(FLOAT_VALUE);
-    break;
-
-  default:
-    std::wcerr << L">>> Invalid memory allocation <<<" << std::endl;
-    exit(1);
-  }
-
-  // collect memory
-  if (collect && allocation_size + calc_size > mem_max_size) {
-    CollectAllMemory(op_stack, stack_pos);
-  }
-
-  // allocate memory
-#ifdef _DEBUG_GC
-  bool is_cached = false;
-#endif
-  const size_t alloc_size = calc_size + sizeof(size_t) * EXTRA_BUF_SIZE;
-
-  mem = GetMemory(alloc_size);
-  mem[EXTRA_BUF_SIZE + TYPE] = type;
-  mem[EXTRA_BUF_SIZE + SIZE_OR_CLS] = calc_size;
-  mem += EXTRA_BUF_SIZE;
-
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&allocated_lock);
-#endif
-  allocation_size += calc_size;
-  allocated_memory.insert(mem);
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&allocated_lock);
-#endif
-
-#ifdef _MEM_LOGGING
-  mem_logger << mem_cycle << L",alloc,array," << mem << L"," << size << std::endl;
-#endif
-
-#ifdef _DEBUG_GC
-  std::wcout << L"# allocating array: cached=" << (is_cached ? L"true" : L"false") << L", addr=" << mem
-    << L"(" << (size_t)mem << L"), size=" << calc_size << L" byte(s), used=" << allocation_size
-    << L" byte(s) #" << std::endl;
-#endif
-
-  return mem;
-}
-
-size_t* MemoryManager::GetMemory(size_t size) {
-  size_t* mem = GetFreeMemory(size);
-  if(mem) {
-    return mem;
-  }
-
-  size_t alloc_size = size + sizeof(size_t);
-  size_t* raw_mem = (size_t*)calloc(alloc_size, sizeof(char));
-#ifdef _DEBUG_GC
-  std::wcout << L"*** Raw allocation: address=" << raw_mem << L" ***" << std::endl;
-#endif
-  raw_mem[0] = size;
-  return raw_mem + 1;
-}
-
-void MemoryManager::AddFreeMemory(size_t* raw_mem) {
-  if(free_memory_cache_size > mem_max_size) {
-    ClearFreeMemory();
-  }
-
-  const size_t size = AlignMemorySize(raw_mem[0]);
-  if(size) {
-    AddFreeCache(size, raw_mem);
-  }
-  else {
-    free(raw_mem);
-    raw_mem = nullptr;
-  }
-}
-
-void MemoryManager::AddFreeCache(size_t pool, size_t* raw_mem) {
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&free_memory_cache_lock);
-#endif
-  const size_t mem_size = raw_mem[0];
-  free_memory_cache_size += mem_size;
-
-  std::unordered_map<size_t, std::list<size_t*>*>::iterator result = free_memory_cache.find(pool);
-  if(result == free_memory_cache.end()) {
-    std::list<size_t*>* pool_list = new std::list<size_t*>;
-    pool_list->push_front(raw_mem);
-    free_memory_cache.insert(std::pair<size_t, std::list<size_t*>*>(pool, pool_list));
-  }
-  else {
-    result->second->push_front(raw_mem);
-  }
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&free_memory_cache_lock);
-#endif
-}
-
-size_t* MemoryManager::GetFreeMemory(size_t size) {
-  size_t cache_size = AlignMemorySize(size);
-  if(!cache_size) {
-    return nullptr;
-  }
-
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&free_memory_cache_lock);
-#endif
-  std::unordered_map<size_t, std::list<size_t*>*>::iterator result = free_memory_cache.find(cache_size);
-  if(result != free_memory_cache.end() && !result->second->empty()) {
-    bool found = false;
-    std::list<size_t*>* free_cache = result->second;
-
-    std::list<size_t*>::iterator iter = free_cache->begin();
-    for(; !found && iter != free_cache->end(); ++iter) {
-      size_t* check_mem = *iter;
-      const size_t check_size = check_mem[0];
-      if(check_size >= size) {
-        found = true;
-      }
-    }
-
-    if(found) {
-      --iter;
-      size_t* raw_mem = *iter;
-      free_cache->erase(iter);
-
-      const size_t mem_size = raw_mem[0];
-      free_memory_cache_size -= mem_size;
-      memset(raw_mem + 1, 0, mem_size);
-#ifndef _GC_SERIAL
-      MUTEX_UNLOCK(&free_memory_cache_lock);
-#endif
-      return raw_mem + 1;
-    }
-  }
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&free_memory_cache_lock);
-#endif
-
-  return nullptr;
-}
-
-size_t MemoryManager::AlignMemorySize(size_t size) {
-  if(size > 0 && size <= 8) {
-    return 8;
-  }
-  else if(size > 8 && size <= 16) {
-    return 16;
-  }
-  else if(size > 16 && size <= 32) {
-    return 32;
-  }
-  else if(size > 32 && size <= 64) {
-    return 64;
-  }
-  else if(size > 64 && size <= 128) {
-    return 128;
-  }
-  else if(size > 128 && size <= 256) {
-    return 256;
-  }
-  else if(size > 256 && size <= 512) {
-    return 512;
-  }
-  else if(size > 512 && size <= 1024) {
-    return 1024;
-  }
-  else if(size > 1024 && size <= 2048) {
-    return 2048;
-  }
-  else if(size > 2048 && size <= 4096) {
-    return 4096;
-  }
-  else if(size > 4096 && size <= 8192) {
-    return 8192;
-  }
-  else if(size > 8192 && size <= 16384) {
-    return 16384;
-  }
-  else if(size > 16384 && size <= 32768) {
-    return 32768;
-  }
-  else if(size > 32768 && size <= 65536) {
-    return 65536;
-  }
-  else if(size > 65536 && size <= 131072) {
-    return 131072;
-  }
-  else if(size > 131072 && size <= 262144) {
-    return 262144;
-  }
-  else if(size > 262144 && size <= 524288) {
-    return 524288;
-  }
-  else if(size > 524288 && size <= 1048576) {
-    return 1048576;
-  }
-  else if(size > 1048576 && size <= 2097152) {
-    return 2097152;
-  }
-  else if(size > 2097152 && size <= 4194304) {
-    return 4194304;
-  }
-
-  return 0;
-}
-
-void MemoryManager::ClearFreeMemory(size_t* op_stack, long stack_pos, bool all) {
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&free_memory_cache_lock);
-#endif
-  if(op_stack) {
-    CollectAllMemory(op_stack, stack_pos);
-  }
-
-  std::unordered_map<size_t, std::list<size_t*>*>::iterator iter = free_memory_cache.begin();
-  for(; iter != free_memory_cache.end(); ++iter) {
-    std::list<size_t*>* free_cache = iter->second;
-
-    while(!free_cache->empty()) {
-      size_t* raw_mem = free_cache->front();
-      free_cache->pop_front();
-
-      const size_t size = raw_mem[0];
-      free_memory_cache_size -= size;
-
-      free(raw_mem);
-      raw_mem = nullptr;
-    }
-
-    if(all) {
-      delete free_cache;
-      free_cache = nullptr;
-    }
-  }
-
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&free_memory_cache_lock);
-#endif
-}
-
-size_t* MemoryManager::ValidObjectCast(size_t* mem, long to_id, long* cls_hierarchy, long** cls_interfaces)
-{
-  // invalid array cast  
-  long id = GetObjectID(mem);
-  if(id < 0) {
-    return nullptr;
-  }
-
-  // upcast
-  long virtual_cls_id = id;
-  while(virtual_cls_id != -1) {
-    if (virtual_cls_id == to_id) {
-      return mem;
-    }
-    // update
-    virtual_cls_id = cls_hierarchy[virtual_cls_id];
-  }
-
-  // check interfaces
-  virtual_cls_id = id;
-  while(virtual_cls_id != -1) {
-    long* interfaces = cls_interfaces[virtual_cls_id];
-    if(interfaces) {
-      int i = 0;
-      long inf_id = interfaces[i];
-      while(inf_id > INF_ENDING) {
-        if (inf_id == to_id) {
-          return mem;
-        }
-        inf_id = interfaces[++i];
-      }
-    }
-    // update
-    virtual_cls_id = cls_hierarchy[virtual_cls_id];
-  }
-
-  return nullptr;
-}
-
-void MemoryManager::CollectAllMemory(size_t* op_stack, long stack_pos)
-{
-#ifdef _TIMING
-  std::wcout << L"=========================================" << std::endl;
-  clock_t start = clock();
-#endif
-
-#ifndef _GC_SERIAL
-#ifdef _WIN32
-  // only one thread at a time can invoke the gargabe collector
-  if(!TryEnterCriticalSection(&marked_sweep_lock)) {
-    return;
-  }
-#else
-  if(pthread_mutex_trylock(&marked_sweep_lock)) {
-    return;
-  }  
-#endif
-#endif
-
-  CollectionInfo* info = new CollectionInfo;
-  info->op_stack = op_stack; 
-  info->stack_pos = stack_pos;
-
-#ifndef _GC_SERIAL
-#ifdef _WIN32
-  HANDLE collect_thread_id = (HANDLE)_beginthreadex(nullptr, 0, CollectMemory, info, 0, nullptr);
-  if(!collect_thread_id) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-#else
-  pthread_attr_t attrs;
-  pthread_attr_init(&attrs);
-  pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_JOINABLE);
-  
-  pthread_t collect_thread;
-  if(pthread_create(&collect_thread, &attrs, CollectMemory, (void*)info)) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-#endif
-#else
-  CollectMemory(info);
-#endif
-
-#ifndef _GC_SERIAL
-#ifdef _WIN32
-  if(WaitForSingleObject(collect_thread_id, INFINITE) != WAIT_OBJECT_0) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }  
-  CloseHandle(collect_thread_id);
-#else
-  void* status;
-  if(pthread_join(collect_thread, &status)) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }
-  pthread_attr_destroy(&attrs);
-#endif  
-  MUTEX_UNLOCK(&marked_sweep_lock);
-#endif
-
-  delete info;
-  info = nullptr;
-
-#ifdef _TIMING
-  clock_t end = clock();
-  std::wcout << L"Collection: size=" << mem_max_size << L", time=" << (double)(end - start) / CLOCKS_PER_SEC << L" second(s)." << std::endl;
-  std::wcout << L"=========================================" << std::endl << std::endl;
-#endif
-}
-
-#ifdef _WIN32
-unsigned int MemoryManager::CollectMemory(void* arg)
-#else
-void* MemoryManager::CollectMemory(void* arg)
-#endif
-{
-#ifdef _TIMING
-  clock_t start = clock();
-#endif
-
-  CollectionInfo* info = (CollectionInfo*)arg;
-
-#ifdef _DEBUG_GC
-  size_t start = allocation_size;
-  std::wcout << std::dec << std::endl << L"=========================================" << std::endl;
-#ifdef _WIN32  
-  std::wcout << L"Starting Garbage Collection; thread=" << GetCurrentThread() << std::endl;
-#else
-  std::wcout << L"Starting Garbage Collection; thread=" << pthread_self() << std::endl;
-#endif  
-  std::wcout << L"=========================================" << std::endl;
-  std::wcout << L"## Marking memory ##" << std::endl;
-#endif
-
-#ifndef _GC_SERIAL
-#ifdef _WIN32
-  const int num_threads = 3;
-  HANDLE thread_ids[num_threads];
-
-  thread_ids[0] = (HANDLE)_beginthreadex(nullptr, 0, CheckStatic, info, 0, nullptr);
-  if(!thread_ids[0]) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-
-  thread_ids[1] = (HANDLE)_beginthreadex(nullptr, 0, CheckStack, info, 0, nullptr);
-  if(!thread_ids[1]) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-
-  thread_ids[2] = (HANDLE)_beginthreadex(nullptr, 0, CheckPdaRoots, nullptr, 0, nullptr);
-  if(!thread_ids[2]) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-
-  // join all mark threads
-  if(WaitForMultipleObjects(num_threads, thread_ids, TRUE, INFINITE) != WAIT_OBJECT_0) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }
-
-  for(int i=0; i < num_threads; ++i) {
-    CloseHandle(thread_ids[i]);
-  }
-#else
-  pthread_attr_t attrs;
-  pthread_attr_init(&attrs);
-  pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_JOINABLE);
-  
-  pthread_t static_thread;
-  if(pthread_create(&static_thread, &attrs, CheckStatic, (void*)info)) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-
-  pthread_t stack_thread;
-  if(pthread_create(&stack_thread, &attrs, CheckStack, (void*)info)) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-
-  pthread_t pda_thread;
-  if(pthread_create(&pda_thread, &attrs, CheckPdaRoots, nullptr)) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-  
-  pthread_attr_destroy(&attrs);
-  
-  // join all of the mark threads
-  void *status;
-
-  if(pthread_join(static_thread, &status)) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }
-  
-  if(pthread_join(stack_thread, &status)) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }
-
-  if(pthread_join(pda_thread, &status)) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }
-#endif  
-#else
-  CheckStatic(nullptr);
-  CheckStack(info);
-  CheckPdaRoots(nullptr);
-  CheckJitRoots(nullptr);
-#endif
-  
-#ifdef _TIMING
-  clock_t end = clock();
-  std::wcout << dec << L"Mark time: " << (double)(end - start) / CLOCKS_PER_SEC << L" second(s)." << std::endl;
-  start = clock();
-#endif
-  
-  // sweep memory
-#ifdef _DEBUG_GC
-  std::wcout << L"## Sweeping memory ##" << std::endl;
-#endif
-
-  // sort and search
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&allocated_lock);
-  MUTEX_LOCK(&marked_lock);
-#endif
-
-#ifdef _DEBUG_GC
-  std::wcout << L"-----------------------------------------" << std::endl;
-  std::wcout << L"Sweeping..." << std::endl;
-  std::wcout << L"-----------------------------------------" << std::endl;
-#endif
-
-#ifndef _GC_SERIAL
-
-#endif
-  std::set<size_t*> live_memory;
-
-  // for(size_t i = 0; i < allocated_memory.size(); ++i) {
-  for (std::set<size_t*>::iterator iter = allocated_memory.begin(); iter != allocated_memory.end(); ++iter) {
-    // size_t* mem = allocated_memory[i];
-    size_t* mem = *iter;
-
-    // check dynamic memory
-    bool found = false;
-    if(mem[MARKED_FLAG]) {
-      mem[MARKED_FLAG] = 0L;
-      found = true;
-    }
-
-    // live
-    if(found) {
-      live_memory.insert(mem);
-    }
-    // will be collected
-    else {
-      // object or array  
-      size_t mem_size;
-      if(mem[TYPE] == NIL_TYPE) {
-        StackClass* cls = (StackClass*)mem[SIZE_OR_CLS];
-#ifdef _DEBUG_GC
-        assert(cls);
-#endif
-        if(cls) {
-          mem_size = cls->GetInstanceMemorySize();
-        }
-        else {
-          mem_size = mem[SIZE_OR_CLS];
-        }
-      } 
-      else {
-        mem_size = mem[SIZE_OR_CLS];
-      }
-
-      // account for deallocated memory
-      allocation_size -= mem_size;
-
-#ifdef _MEM_LOGGING
-      mem_logger << mem_cycle << L", dealloc," << (mem[SIZE_OR_CLS] ? "obj," : "array,") << mem << L"," << mem_size << std::endl;
-#endif
-
-      // cache or free memory
-      size_t* tmp = mem - EXTRA_BUF_SIZE;
-      AddFreeMemory(tmp - 1);
-#ifdef _DEBUG_GC
-      std::wcout << L"# freeing memory: addr=" << mem << L"(" << (size_t)mem
-            << L"), size=" << mem_size << L" byte(s) #" << std::endl;
-#endif
-    }
-  }
-
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&marked_lock);
-#endif  
-
-  // did not collect memory; adjust constraints
-  if(live_memory.size() >= allocated_memory.size() - 1) {
-    if(uncollected_count < UNCOLLECTED_COUNT) {
-      uncollected_count++;
-    } 
-    else {
-      mem_max_size <<= 3;
-      uncollected_count = 0;
-    }
-  }
-  // collected memory; adjust constraints
-  else if(mem_max_size != MEM_START_MAX) {
-    if(collected_count < COLLECTED_COUNT) {
-      collected_count++;
-    } 
-    else {
-      mem_max_size >>= 2;
-      if(mem_max_size <= 0) {
-        mem_max_size = MEM_START_MAX;
-      }
-      collected_count = 0;
-    }
-  }
-
-  // copy live memory to allocated memory
-  allocated_memory = live_memory;
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&allocated_lock);
-#endif
-
-#ifdef _MEM_LOGGING
-  mem_cycle++;
-#endif
-
-#ifdef _DEBUG_GC
-  std::wcout << L"===============================================================" << std::endl;
-  std::wcout << L"Finished Collection: collected=" << (start - allocation_size)
-        << L" of " << start << L" byte(s) - " << std::showpoint << std::setprecision(3)
-        << (((double)(start - allocation_size) / (double)start) * 100.0)
-        << L"%" << std::endl;
-  std::wcout << L"===============================================================" << std::endl;
-#endif
-  
-#ifdef _TIMING
-  end = clock();
-  std::wcout << dec << L"Sweep time: " << (double)(end - start) / CLOCKS_PER_SEC << L" second(s)." << std::endl;
-#endif
-  
-#ifndef _WIN32
-#ifndef _GC_SERIAL
-  pthread_exit(nullptr);
-#endif
-#endif
-  
-  return 0;
-}
-
-#ifdef _WIN32
-unsigned int MemoryManager::CheckStatic(void* arg)
-#else
-void* MemoryManager::CheckStatic(void* arg)
-#endif
-{
-  StackClass** clss = prgm->GetClasses();
-  const int cls_num = prgm->GetClassNumber();
-  
-  for(int i = 0; i < cls_num; ++i) {
-    StackClass* cls = clss[i];
-    CheckMemory(cls->GetClassMemory(), cls->GetClassDeclarations(), cls->GetNumberClassDeclarations(), 0);
-  }
-  
-  return 0;
-}
-
-#ifdef _WIN32
-unsigned int MemoryManager::CheckStack(void* arg)
-#else
-void* MemoryManager::CheckStack(void* arg)
-#endif
-{
-  CollectionInfo* info = (CollectionInfo*)arg;
-#ifdef _DEBUG_GC
-  std::wcout << L"----- Marking Stack: std::stack: pos=" << info->stack_pos 
-#ifdef _WIN32  
-        << L"; thread=" << GetCurrentThread() << L" -----" << std::endl;
-#else
-        << L"; thread=" << pthread_self() << L" -----" << std::endl;
-#endif    
-#endif
-
-
-  while(info->stack_pos > -1) {
-    size_t* check_mem = (size_t*)info->op_stack[info->stack_pos--];
-#ifndef _GC_SERIAL
-    MUTEX_LOCK(&allocated_lock);
-#endif
-    const bool found = allocated_memory.find(check_mem) != allocated_memory.end();
-#ifndef _GC_SERIAL
-    MUTEX_UNLOCK(&allocated_lock);
-#endif
-    if(found) {
-      CheckObject(check_mem, false, 1);
-    }
-  }
-
-#ifndef _WIN32
-#ifndef _GC_SERIAL
-  pthread_exit(nullptr);
-#endif
-#endif
-    
-  return 0;  
-}
-
-#ifdef _WIN32
-unsigned int MemoryManager::CheckJitRoots(void* arg)
-#else
-void* MemoryManager::CheckJitRoots(void* arg)
-#endif
-{
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&jit_frame_lock);
-#endif  
-
-#ifdef _DEBUG_GC
-  std::wcout << L"---- Marking JIT method root(s): num=" << jit_frames.size()
-#ifdef _WIN32
-        << L"; thread=" << GetCurrentThread() << L" ------" << std::endl;
-#else
-        << L"; thread=" << pthread_self() << L" ------" << std::endl;
-#endif    
-  std::wcout << L"memory types: " << std::endl;
-#endif
-  
-  for(size_t i = 0; i < jit_frames.size(); ++i) {
-    StackFrame* frame = jit_frames[i];
-    StackMethod* method = frame->method;
-    size_t* mem = frame->jit_mem;
-    size_t* self = (size_t*)frame->mem[0];
-    const long dclrs_num = method->GetNumberDeclarations();
-
-#ifdef _DEBUG_GC
-    std::wcout << L"\t===== JIT method: name=" << method->GetName() << L", id=" << method->GetClass()->GetId()
-      << L"," << method->GetId() << L"; addr=" << method << L"; mem=" << mem << L"; self=" << self
-      << L"; num=" << method->GetNumberDeclarations() << L" =====" << std::endl;
-#endif
-
-    if(mem) {
-#ifdef _ARM64
-      size_t* start = mem - 1;
-#endif
-      
-      // check self
-      if(!method->IsLambda()) {
-        CheckObject(self, true, 1);
-      }
-
-      StackDclr** dclrs = method->GetDeclarations();
-#ifdef _ARM64
-      // front to back...
-      if(method->HasAndOr()) {
-        mem++;
-      }
-      
-      for(int j = 0; j < dclrs_num; ++j) {
-#else
-      // front to back...
-      for(int j = dclrs_num - 1; j > -1; --j) {
-#endif
-        // update address based upon type
-        switch(dclrs[j]->type) {
-        case FUNC_PARM: {
-          size_t* lambda_mem = (size_t*) * (mem + 1);
-          const size_t mthd_cls_id = *mem;
-          const long virtual_cls_id = (mthd_cls_id >> (16 * (1))) & 0xFFFF;
-          const long mthd_id = (mthd_cls_id >> (16 * (0))) & 0xFFFF;
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": FUNC_PARM: id=(" << virtual_cls_id << L"," << mthd_id << L"), mem=" << lambda_mem << std::endl;
-#endif
-          std::pair<int, StackDclr**> closure_dclrs = prgm->GetClass(virtual_cls_id)->GetClosureDeclarations(mthd_id);
-          if(MarkMemory(lambda_mem)) {
-            CheckMemory(lambda_mem, closure_dclrs.second, closure_dclrs.first, 1);
-          }
-          // update
-          mem += 2;
-        }
-          break;
-
-        case CHAR_PARM:
-        case INT_PARM:
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": CHAR_PARM/INT_PARM: value=" << (*mem) << std::endl;
-#endif
-          // update
-          mem++;
-          break;
-
-        case FLOAT_PARM: {
-#ifdef _DEBUG_GC
-          FLOAT_VALUE value;
-          memcpy(&value, mem, sizeof(FLOAT_VALUE));
-          std::wcout << L"\t" << j << L": FLOAT_PARM: value=" << value << std::endl;
-#endif
-          // update
-          mem++;
-        }
-          break;
-
-        case BYTE_ARY_PARM:
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": BYTE_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
-            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
-            << L" byte(s)" << std::endl;
-#endif
-          // mark data
-          MarkMemory((size_t*)(*mem));
-          // update
-          mem++;
-          break;
-
-        case CHAR_ARY_PARM:
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": CHAR_ARY_PARM: addr=" << (size_t*)(*mem) << L"(" << (size_t)(*mem)
-            << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
-            << L" byte(s)" << std::endl;
-#endif
-          // mark data
-          MarkMemory((size_t*)(*mem));
-          // update
-          mem++;
-          break;
-
-        case INT_ARY_PARM:
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": INT_ARY_PARM: addr=" << (size_t*)(*mem)
-            << L"(" << (size_t)(*mem) << L"), size="
-            << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
-            << L" byte(s)" << std::endl;
-#endif
-          // mark data
-          MarkMemory((size_t*)(*mem));
-          // update
-          mem++;
-          break;
-
-        case FLOAT_ARY_PARM:
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": FLOAT_ARY_PARM: addr=" << (size_t*)(*mem)
-            << L"(" << (size_t)(*mem) << L"), size=" << L" byte(s)"
-            << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) << std::endl;
-#endif
-          // mark data
-          MarkMemory((size_t*)(*mem));
-          // update
-          mem++;
-          break;
-
-        case OBJ_PARM: {
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": OBJ_PARM: addr=" << (size_t*)(*mem)
-            << L"(" << (size_t)(*mem) << L"), id=";
-          if(*mem) {
-            StackClass* tmp = (StackClass*)((size_t*)(*mem))[SIZE_OR_CLS];
-            std::wcout << L"'" << tmp->GetName() << L"'" << std::endl;
-          }
-          else {
-            std::wcout << L"Unknown" << std::endl;
-          }
-#endif
-          // check object
-          CheckObject((size_t*)(*mem), true, 1);
-          // update
-          mem++;
-        }
-          break;
-
-        case OBJ_ARY_PARM:
-#ifdef _DEBUG_GC
-          std::wcout << L"\t" << j << L": OBJ_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
-            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
-            << L" byte(s)" << std::endl;
-#endif
-          // mark data
-          if(MarkValidMemory((size_t*)(*mem))) {
-            size_t* array = (size_t*)(*mem);
-            const size_t size = array[0];
-            const size_t dim = array[1];
-            size_t* objects = (size_t*)(array + 2 + dim);
-            for(size_t k = 0; k < size; ++k) {
-              CheckObject((size_t*)objects[k], true, 2);
-            }
-          }
-          // update
-          mem++;
-          break;
-
-        default:
-          break;
-        }
-      }
-
-      // NOTE: this marks temporary variables that are stored in JIT memory
-      // during some method calls. There are 6 integer temp addresses
-      // TODO: for non-ARM64 targets, skip 'has_and_or' variable addressed
-#ifdef _ARM32
-      // for ARM32, skip the link register
-      for(int i = 1; i <= 6; ++i) {
-#elif _ARM64
-      mem = start;
-      for(int i = 0; i > -6; --i) {
-#else
-      for(int i = 0; i < 6; ++i) {
-#endif
-        size_t* check_mem = (size_t*)mem[i];
-#ifndef _GC_SERIAL
-        MUTEX_LOCK(&allocated_lock);
-#endif 
-        const bool found = allocated_memory.find(check_mem) != allocated_memory.end();
-#ifndef _GC_SERIAL
-        MUTEX_UNLOCK(&allocated_lock);
-#endif
-        if(found) {
-          CheckObject(check_mem, false, 1);
-        }
-      }
-    }
-#ifdef _DEBUG_GC
-    else {
-      std::wcout << L"\t\t--- Nil memory ---" << std::endl;
-    }
-#endif
-  }
-  jit_frames.clear();
-
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&jit_frame_lock);
-#ifndef _WIN32
-  pthread_exit(nullptr);
-#endif
-#endif
-  
-  return 0;
-}
-
-#ifdef _WIN32
-unsigned int MemoryManager::CheckPdaRoots(void* arg)
-#else
-void* MemoryManager::CheckPdaRoots(void* arg)
-#endif
-{
-  std::vector<StackFrame*> frames;
-
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&pda_frame_lock);
-#endif
-
-#ifdef _DEBUG_GC
-  std::wcout << L"----- PDA frames(s): num=" << pda_frames.size() 
-#ifdef _WIN32  
-        << L"; thread=" << GetCurrentThread()<< L" -----" << std::endl;
-#else
-        << L"; thread=" << pthread_self() << L" -----" << std::endl;
-#endif    
-  std::wcout << L"memory types:" <<  std::endl;
-#endif
-
-  for(std::unordered_set<StackFrame**>::iterator iter = pda_frames.begin(); iter != pda_frames.end(); ++iter) {
-    StackFrame** frame = *iter;
-    if(*frame) {
-      if((*frame)->jit_mem) {
-#ifndef _GC_SERIAL
-        MUTEX_LOCK(&jit_frame_lock);
-#endif
-        jit_frames.push_back(*frame);
-#ifndef _GC_SERIAL
-        MUTEX_UNLOCK(&jit_frame_lock);
-#endif
-      }
-      else {
-        frames.push_back(*frame);
-      }
-    }
-  }
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&pda_frame_lock);
-#endif 
-  
-  // ------
-#ifndef _GC_SERIAL
-  MUTEX_LOCK(&pda_monitor_lock);
-#endif
-
-#ifdef _DEBUG_GC
-  std::wcout << L"----- PDA method root(s): num=" << pda_monitors.size() 
-#ifdef _WIN32  
-        << L"; thread=" << GetCurrentThread()<< L" -----" << std::endl;
-#else
-        << L"; thread=" << pthread_self()<< L" -----" << std::endl;
-#endif    
-  std::wcout << L"memory types:" <<  std::endl;
-#endif
-
-    // look at pda methods
-  std::unordered_set<StackFrameMonitor*>::iterator pda_iter;
-  for(pda_iter = pda_monitors.begin(); pda_iter != pda_monitors.end(); ++pda_iter) {
-    StackFrameMonitor* monitor = *pda_iter;
-    // gather stack frames
-    long call_stack_pos = *(monitor->call_stack_pos);
-
-    if(call_stack_pos > 0) {
-      StackFrame** call_stack = monitor->call_stack;
-      StackFrame* cur_frame = *(monitor->cur_frame);
-
-      if(cur_frame->jit_mem) {
-#ifndef _GC_SERIAL
-        MUTEX_LOCK(&jit_frame_lock);
-#endif
-        jit_frames.push_back(cur_frame);
-#ifndef _GC_SERIAL
-        MUTEX_UNLOCK(&jit_frame_lock);
-#endif
-      }
-      else {
-        frames.push_back(cur_frame);
-      }
-
-      // copy frames locally
-      frames.push_back(cur_frame);
-      while(--call_stack_pos > -1) {
-        StackFrame* frame = call_stack[call_stack_pos];
-        if(frame->jit_mem) {
-#ifndef _GC_SERIAL
-          MUTEX_LOCK(&jit_frame_lock);
-#endif    
-          jit_frames.push_back(frame);
-#ifndef _GC_SERIAL
-          MUTEX_UNLOCK(&jit_frame_lock);
-#endif
-        }
-        else {
-          frames.push_back(frame);
-        }
-      }
-    }
-  }
-
-#ifndef _GC_SERIAL
-  MUTEX_UNLOCK(&pda_monitor_lock);
-#endif
-
-  // check JIT roots in separate thread
-#ifndef _GC_SERIAL
-#ifdef _WIN32
-  HANDLE thread_id = (HANDLE)_beginthreadex(nullptr, 0, CheckJitRoots, nullptr, 0, nullptr);
-  if(!thread_id) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-#else
-  pthread_attr_t attrs;
-  pthread_attr_init(&attrs);
-  pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_JOINABLE);
-  
-  pthread_t jit_thread;
-  if(pthread_create(&jit_thread, &attrs, CheckJitRoots, nullptr)) {
-    std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
-    exit(-1);
-  }
-#endif
-#endif
-
-  // check PDA roots
-  for(size_t i = 0; i < frames.size(); ++i) {
-    StackFrame* frame = frames[i];
-    StackMethod* method = frame->method;
-    size_t* mem = frame->mem;
-
-#ifdef _DEBUG_GC
-    std::wcout << L"\t===== PDA method: name=" << method->GetName() << L", addr="
-      << method << L", num=" << method->GetNumberDeclarations() << L" =====" << std::endl;
-#endif
-
-    // mark self
-    if(!method->IsLambda()) {
-      CheckObject((size_t*)(*mem), true, 1);
-    }
-
-    if(method->HasAndOr()) {
-      mem += 2;
-    }
-    else {
-      mem++;
-    }
-
-    // mark rest of memory
-    CheckMemory(mem, method->GetDeclarations(), method->GetNumberDeclarations(), 0);
-  }
-
-#ifndef _GC_SERIAL
-#ifdef _WIN32
-  // wait for JIT thread
-  if(WaitForSingleObject(thread_id, INFINITE) != WAIT_OBJECT_0) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }
-  CloseHandle(thread_id);
-#else
-  void *status;
-  if(pthread_join(jit_thread, &status)) {
-    std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
-    exit(-1);
-  }
-  pthread_exit(nullptr);
-#endif
-#endif
-
-  return 0;
-}
-
-void MemoryManager::CheckMemory(size_t* mem, StackDclr** dclrs, const long dcls_size, long depth)
-{
-  // check method
-  for(long i = 0; i < dcls_size; ++i) {
-#ifdef _DEBUG_GC
-    for(int j = 0; j < depth; ++j) {
-      std::wcout << L"\t";
-    }
-#endif
-
-    // update address based upon type
-    switch(dclrs[i]->type) {
-    case FUNC_PARM: {
-      size_t* lambda_mem = (size_t*) * (mem + 1);
-      const size_t mthd_cls_id = *mem;
-      const long virtual_cls_id = (mthd_cls_id >> (16 * (1))) & 0xFFFF;
-      const long mthd_id = (mthd_cls_id >> (16 * (0))) & 0xFFFF;
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": FUNC_PARM: id=(" << virtual_cls_id << L"," << mthd_id << L"), mem=" << lambda_mem << std::endl;
-#endif
-      std::pair<int, StackDclr**> closure_dclrs = prgm->GetClass(virtual_cls_id)->GetClosureDeclarations(mthd_id);
-      if(MarkMemory(lambda_mem)) {
-        CheckMemory(lambda_mem, closure_dclrs.second, closure_dclrs.first, depth + 1);
-      }
-      // update
-      mem += 2;
-    }
-      break;
-
-  case CHAR_PARM:
-    case INT_PARM:
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": CHAR_PARM/INT_PARM: value=" << (*mem) << std::endl;
-#endif
-      // update
-      mem++;
-      break;
-
-    case FLOAT_PARM: {
-#ifdef _DEBUG_GC
-      FLOAT_VALUE value;
-      memcpy(&value, mem, sizeof(FLOAT_VALUE));
-      std::wcout << L"\t" << i << L": FLOAT_PARM: value=" << value << std::endl;
-#endif
-      // update
-      mem++;
-    }
-      break;
-
-    case BYTE_ARY_PARM:
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": BYTE_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
-            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
-            << L" byte(s)" << std::endl;
-#endif
-      // mark data
-      MarkMemory((size_t*)(*mem));
-      // update
-      mem++;
-      break;
-
-    case CHAR_ARY_PARM:
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": CHAR_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
-            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) 
-            << L" byte(s)" << std::endl;
-#endif
-      // mark data
-      MarkMemory((size_t*)(*mem));
-      // update
-      mem++;
-      break;
-
-    case INT_ARY_PARM:
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": INT_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
-            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) 
-            << L" byte(s)" << std::endl;
-#endif
-      // mark data
-      MarkMemory((size_t*)(*mem));
-      // update
-      mem++;
-      break;
-
-    case FLOAT_ARY_PARM:
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": FLOAT_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
-            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) 
-            << L" byte(s)" << std::endl;
-#endif
-      // mark data
-      MarkMemory((size_t*)(*mem));
-      // update
-      mem++;
-      break;
-
-    case OBJ_PARM: {
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": OBJ_PARM: addr=" << (size_t*)(*mem) << L"(" << (size_t)(*mem) << L"), id=";
-      if(*mem) {
-        StackClass* tmp = (StackClass*)((size_t*)(*mem))[SIZE_OR_CLS];
-        std::wcout << L"'" << tmp->GetName() << L"'" << std::endl;
-      }
-      else {
-        std::wcout << L"Unknown" << std::endl;
-      }
-#endif
-      // check object
-      CheckObject((size_t*)(*mem), true, depth + 1);
-      // update
-      mem++;
-    }
-      break;
-
-    case OBJ_ARY_PARM:
-#ifdef _DEBUG_GC
-      std::wcout << L"\t" << i << L": OBJ_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
-            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
-            << L" byte(s)" << std::endl;
-#endif
-      // mark data
-      if(MarkValidMemory((size_t*)(*mem))) {
-        size_t* array = (size_t*)(*mem);
-        const size_t size = array[0];
-        const size_t dim = array[1];
-        size_t* objects = (size_t*)(array + 2 + dim);
-        for(size_t k = 0; k < size; ++k) {
-          CheckObject((size_t*)objects[k], true, 2);
-        }
-      }
-      // update
-      mem++;
-      break;
-
-    default:
-      break;
-    }
-  }
-}
-
-void MemoryManager::CheckObject(size_t* mem, bool is_obj, long depth)
-{
-  if(allocated_memory.find(mem) != allocated_memory.end()) {
-    StackClass* cls;
-    if(is_obj) {
-      cls = GetClass(mem);
-    }
-    else {
-      cls = GetClassMapping(mem);
-    }
-
-    if(cls) {
-#ifdef _DEBUG_GC
-      for(int i = 0; i < depth; ++i) {
-        std::wcout << L"\t";
-      }
-      std::wcout << L"\t----- object: addr=" << mem << L"(" << (size_t)mem << L"), name='"
-            << cls->GetName() << L"', num=" << cls->GetNumberInstanceDeclarations() << L" -----" << std::endl;
-#endif
-
-      // mark data
-      if(MarkMemory(mem)) {
-        CheckMemory(mem, cls->GetInstanceDeclarations(), cls->GetNumberInstanceDeclarations(), depth);
-      }
-    } 
-    else {
-      // NOTE: this happens when we are trying to mark unidentified memory
-      // segments. these segments may be parts of that stack or temp for
-      // register variables
-#ifdef _DEBUG_GC
-      for(int i = 0; i < depth; ++i) {
-        std::wcout << L"\t";
-      }
-      std::wcout <<"$: addr/value=" << mem << std::endl;
-      if(is_obj) {
-        assert(cls);
-      }
-#endif
-      // primitive or object array
-      if(MarkValidMemory(mem)) {
-        // ensure we're only checking int and obj arrays
-        if(std::binary_search(allocated_memory.begin(), allocated_memory.end(), mem) && 
-          (mem[TYPE] == NIL_TYPE || mem[TYPE] == INT_TYPE)) {
-            size_t* array = mem;
-            const size_t size = array[0];
-            const size_t dim = array[1];
-            size_t* objects = (size_t*)(array + 2 + dim);
-            for(size_t i = 0; i < size; ++i) {
-              CheckObject((size_t*)objects[i], false, 2);
-            }
-        }
-      }
-    }
-  }
-}
+/***************************************************************************
+* VM memory manager. Implements a "mark and sweep" collection algorithm.
+*
+* Copyright (c) 2023, Randy Hollines
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* - Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* - Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in
+* the documentation and/or other materials provided with the distribution.
+* - Neither the name of the Objeck Team nor the names of its
+* contributors may be used to endorse or promote products derived
+* from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+* A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+* OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+* TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+*  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+
+#include "memory.h"
+#include <iomanip>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+StackProgram* MemoryManager::prgm;
+
+std::unordered_set<StackFrame**> MemoryManager::pda_frames;
+std::unordered_set<StackFrameMonitor*> MemoryManager::pda_monitors;
+
+char* MemoryManager::heap_base;
+size_t MemoryManager::heap_chunks;
+size_t MemoryManager::heap_max_chunks;
+HeapChunk** MemoryManager::chunk_table;
+unsigned char* MemoryManager::chunk_dirty;
+std::vector<size_t> MemoryManager::free_chunks;
+std::vector<HeapChunk*> MemoryManager::class_chunks[HEAP_NUM_CLASSES];
+SizeClassStats MemoryManager::class_stats[HEAP_NUM_CLASSES];
+thread_local ThreadAllocationBuffers MemoryManager::alloc_buffers;
+std::atomic<bool> MemoryManager::gc_active;
+size_t MemoryManager::gc_cycle;
+std::atomic<size_t> MemoryManager::gc_marked_bytes;
+thread_local size_t MemoryManager::mark_bytes;
+size_t MemoryManager::gc_live_bytes;
+bool MemoryManager::gc_generational;
+bool MemoryManager::gc_minor;
+size_t MemoryManager::gc_minor_count;
+unsigned char* MemoryManager::card_table;
+size_t MemoryManager::card_bias;
+int MemoryManager::gc_num_workers;
+MarkDeque* MemoryManager::mark_deques;
+thread_local int MemoryManager::gc_worker_id;
+thread_local std::deque<MarkTask> MemoryManager::mark_stack;
+std::atomic<int> MemoryManager::gc_idle_workers;
+size_t MemoryManager::gc_phase;
+std::atomic<int> MemoryManager::gc_running_workers;
+bool MemoryManager::gc_workers_exit;
+bool MemoryManager::gc_concurrent;
+bool MemoryManager::gc_roots_only;
+std::atomic<bool> MemoryManager::gc_marking;
+std::vector<size_t> MemoryManager::satb_queue;
+std::atomic<bool> MemoryManager::safepoint_requested;
+std::unordered_set<MutatorThread*> MemoryManager::mutators;
+thread_local MutatorThread* MemoryManager::mutator;
+long MemoryManager::running_mutators;
+size_t MemoryManager::buffer_refills;
+std::atomic<size_t> MemoryManager::buffer_lock_contention;
+size_t MemoryManager::released_chunks;
+size_t MemoryManager::gc_collections;
+size_t MemoryManager::gc_pauses;
+size_t MemoryManager::gc_pause_total;
+size_t MemoryManager::gc_pause_max;
+size_t MemoryManager::gc_pause_histogram[GC_PAUSE_BUCKETS];
+size_t MemoryManager::gc_max_size_changes;
+size_t MemoryManager::allocated_bytes;
+std::ofstream MemoryManager::gc_log;
+std::chrono::steady_clock::time_point MemoryManager::gc_start_time;
+
+bool MemoryManager::initialized;
+size_t MemoryManager::allocation_size;
+size_t MemoryManager::mem_max_size;
+size_t MemoryManager::uncollected_count;
+size_t MemoryManager::collected_count;
+
+#ifdef _MEM_LOGGING
+ofstream MemoryManager::mem_logger;
+long MemoryManager::mem_cycle = 0L;
+#endif
+
+// operation locks
+#ifdef _WIN32
+CRITICAL_SECTION MemoryManager::pda_frame_lock;
+CRITICAL_SECTION MemoryManager::pda_monitor_lock;
+CRITICAL_SECTION MemoryManager::allocated_lock;
+CRITICAL_SECTION MemoryManager::marked_sweep_lock;
+CRITICAL_SECTION MemoryManager::gc_pool_lock;
+CONDITION_VARIABLE MemoryManager::gc_pool_start;
+CONDITION_VARIABLE MemoryManager::gc_pool_done;
+std::vector<HANDLE> MemoryManager::gc_workers;
+CRITICAL_SECTION MemoryManager::safepoint_lock;
+CONDITION_VARIABLE MemoryManager::safepoint_parked;
+CONDITION_VARIABLE MemoryManager::safepoint_resume;
+CRITICAL_SECTION MemoryManager::satb_lock;
+#else
+pthread_mutex_t MemoryManager::pda_monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t MemoryManager::pda_frame_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t MemoryManager::allocated_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t MemoryManager::marked_sweep_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t MemoryManager::gc_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t MemoryManager::gc_pool_start = PTHREAD_COND_INITIALIZER;
+pthread_cond_t MemoryManager::gc_pool_done = PTHREAD_COND_INITIALIZER;
+std::vector<pthread_t> MemoryManager::gc_workers;
+pthread_mutex_t MemoryManager::safepoint_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t MemoryManager::safepoint_parked = PTHREAD_COND_INITIALIZER;
+pthread_cond_t MemoryManager::safepoint_resume = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t MemoryManager::satb_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void MemoryManager::Initialize(StackProgram* p)
+{
+  prgm = p;
+  allocation_size = 0;
+  mem_max_size = MEM_START_MAX;
+  uncollected_count = 0;
+
+#ifdef _MEM_LOGGING
+  mem_logger.open("mem_log.csv");
+  mem_logger << L"cycle,oper,type,addr,size" << std::endl;
+#endif
+
+#ifdef _WIN32
+  InitializeCriticalSection(&pda_frame_lock);
+  InitializeCriticalSection(&pda_monitor_lock);
+  InitializeCriticalSection(&allocated_lock);
+  InitializeCriticalSection(&marked_sweep_lock);
+  InitializeCriticalSection(&gc_pool_lock);
+  InitializeConditionVariable(&gc_pool_start);
+  InitializeConditionVariable(&gc_pool_done);
+  InitializeCriticalSection(&safepoint_lock);
+  InitializeConditionVariable(&safepoint_parked);
+  InitializeConditionVariable(&safepoint_resume);
+  InitializeCriticalSection(&satb_lock);
+#endif
+
+  // opt-in generational collection
+  gc_generational = StackProgram::GetProperty(L"gc-generational") == L"true";
+
+  // opt-in concurrent marking, requires collector threads
+#ifdef _GC_SERIAL
+  gc_concurrent = false;
+#else
+  gc_concurrent = !gc_generational && StackProgram::GetProperty(L"gc-concurrent") == L"true";
+#endif
+
+  // optional log with a line per pause
+  gc_start_time = std::chrono::steady_clock::now();
+  const std::wstring gc_log_file = StackProgram::GetProperty(L"gc-log");
+  if(!gc_log_file.empty()) {
+    gc_log.open(UnicodeToBytes(gc_log_file).c_str());
+    if(gc_log.is_open()) {
+      gc_log << "time_ms,collection,pause,pause_us,live_bytes,heap_bytes,max_bytes,free_bytes" << std::endl;
+    }
+    else {
+      std::wcerr << L">>> Unable to open GC log file: '" << gc_log_file << L"' <<<" << std::endl;
+    }
+  }
+
+  InitializeHeap();
+  StartMarkWorkers();
+  initialized = true;
+}
+
+// if return true, trace memory otherwise do not
+inline bool MemoryManager::MarkMemory(size_t* mem)
+{
+  size_t index;
+  HeapChunk* chunk = FindChunk(mem, index);
+  if(chunk) {
+    // check if memory has been marked, avoids an atomic update for memory seen before
+    std::atomic<size_t> &mark_bits = chunk->mark_bits[index / HEAP_BITS];
+    const size_t mark_bit = (size_t)1 << (index % HEAP_BITS);
+    if(mark_bits.load(std::memory_order_relaxed) & mark_bit) {
+      return false;
+    }
+
+    // test-and-set, only the thread that sets the bit traces the memory
+    if(mark_bits.fetch_or(mark_bit, std::memory_order_relaxed) & mark_bit) {
+      return false;
+    }
+    mark_bytes += chunk->block_size;
+    
+    return true;
+  }
+  
+  return false;
+}
+
+// if return true, trace memory otherwise do not
+inline bool MemoryManager::MarkValidMemory(size_t* mem)
+{
+  return MarkMemory(mem);
+}
+
+void MemoryManager::AddPdaMethodRoot(StackFrame** frame)
+{
+  if(!initialized) {
+    return;
+  }
+
+#ifdef _DEBUG_GC
+  std::wcout << L"adding PDA frame: addr=" << frame << std::endl;
+#endif
+
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&pda_frame_lock);
+#endif
+  pda_frames.insert(frame);
+  
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&pda_frame_lock);
+#endif
+}
+
+void MemoryManager::RemovePdaMethodRoot(StackFrame** frame)
+{
+#ifdef _DEBUG_GC
+  std::wcout << L"removing PDA frame: addr=" << frame << std::endl;
+#endif
+  
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&pda_frame_lock);
+#endif
+  pda_frames.erase(frame);
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&pda_frame_lock);
+#endif
+}
+
+void MemoryManager::AddPdaMethodRoot(StackFrameMonitor* monitor)
+{
+#ifdef _DEBUG_GC
+  std::wcout << L"adding PDA method: monitor=" << monitor << std::endl;
+#endif
+
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&pda_monitor_lock);
+#endif
+  pda_monitors.insert(monitor);
+  
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&pda_monitor_lock);
+#endif
+}
+
+void MemoryManager::RemovePdaMethodRoot(StackFrameMonitor* monitor)
+{
+  if(!initialized) {
+    return;
+  }
+
+#ifdef _DEBUG_GC
+  std::wcout << L"removing PDA method: monitor=" << monitor << std::endl;
+#endif
+
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&pda_monitor_lock);
+#endif
+  pda_monitors.erase(monitor);
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&pda_monitor_lock);
+#endif
+}
+
+size_t* MemoryManager::AllocateObject(const long obj_id, size_t* op_stack, long stack_pos, bool collect)
+{
+  StackClass* cls = prgm->GetClass(obj_id);
+#ifdef _DEBUG_GC
+  assert(cls);
+#endif
+
+  size_t* mem = nullptr;
+  if(cls) {
+    const long size = cls->GetInstanceMemorySize();
+
+    // collect memory
+    if(collect && allocation_size + size > mem_max_size) {
+      CollectAllMemory(op_stack, stack_pos);
+    }
+
+    // allocate memory
+#ifdef _DEBUG_GC
+    bool is_cached = false;
+#endif
+    const size_t alloc_size = size * 2 + sizeof(size_t) * EXTRA_BUF_SIZE;
+    
+    mem = GetMemory(alloc_size);
+    mem[EXTRA_BUF_SIZE + TYPE] = NIL_TYPE;
+    mem[EXTRA_BUF_SIZE + SIZE_OR_CLS] = (size_t)cls;
+    mem += EXTRA_BUF_SIZE;
+
+#ifdef _MEM_LOGGING
+    mem_logger << mem_cycle << L",alloc,obj," << mem << L"," << size << std::endl;
+#endif
+
+#ifdef _DEBUG_GC
+    std::wcout << L"# allocating object: cached=" << (is_cached ? L"true" : L"false")  << L", addr=" << mem << L"(" 
+          << (size_t)mem << L"), size=" << size << L" byte(s), used=" << allocation_size << L" byte(s) #"
+          << std::endl;
+#endif
+  }
+
+  return mem;
+}
+
+size_t* MemoryManager::AllocateArray(const size_t size, const MemoryType type, size_t* op_stack, long stack_pos, bool collect)
+{
+  size_t calc_size;
+  size_t* mem;
+  switch (type) {
+  case BYTE_ARY_TYPE:
+    calc_size = size * sizeof(char);
+    break;
+
+  case CHAR_ARY_TYPE:
+    calc_size = size * sizeof(wchar_t);
+    break;
+
+  case INT_TYPE:
+    calc_size = size * sizeof(size_t);
+    break;
+
+  case FLOAT_TYPE:
+    calc_size = size * sizeof(FLOAT_VALUE);
+    break;
+
+  default:
+    std::wcerr << L">>> Invalid memory allocation <<<" << std::endl;
+    exit(1);
+  }
+
+  // collect memory
+  if (collect && allocation_size + calc_size > mem_max_size) {
+    CollectAllMemory(op_stack, stack_pos);
+  }
+
+  // allocate memory
+#ifdef _DEBUG_GC
+  bool is_cached = false;
+#endif
+  const size_t alloc_size = calc_size + sizeof(size_t) * EXTRA_BUF_SIZE;
+
+  mem = GetMemory(alloc_size);
+  mem[EXTRA_BUF_SIZE + TYPE] = type;
+  mem[EXTRA_BUF_SIZE + SIZE_OR_CLS] = calc_size;
+  mem += EXTRA_BUF_SIZE;
+
+#ifdef _MEM_LOGGING
+  mem_logger << mem_cycle << L",alloc,array," << mem << L"," << size << std::endl;
+#endif
+
+#ifdef _DEBUG_GC
+  std::wcout << L"# allocating array: cached=" << (is_cached ? L"true" : L"false") << L", addr=" << mem
+    << L"(" << (size_t)mem << L"), size=" << calc_size << L" byte(s), used=" << allocation_size
+    << L" byte(s) #" << std::endl;
+#endif
+
+  return mem;
+}
+
+void MemoryManager::InitializeHeap()
+{
+  // reserve address space for the heap, backing off if the OS refuses
+  size_t reserve_size = HEAP_RESERVE_SIZE;
+  heap_base = nullptr;
+  while(!heap_base && reserve_size >= HEAP_MIN_RESERVE_SIZE) {
+#ifdef _WIN32
+    heap_base = (char*)VirtualAlloc(nullptr, reserve_size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* addr = mmap(nullptr, reserve_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    heap_base = addr == MAP_FAILED ? nullptr : (char*)addr;
+#endif
+    if(!heap_base) {
+      reserve_size >>= 1;
+    }
+  }
+
+  if(!heap_base) {
+    std::wcerr << L">>> Unable to reserve heap memory <<<" << std::endl;
+    exit(1);
+  }
+
+  // chunks must be aligned to their size
+  const size_t offset = (size_t)heap_base & (HEAP_CHUNK_SIZE - 1);
+  heap_max_chunks = reserve_size >> HEAP_CHUNK_SHIFT;
+  if(offset) {
+    heap_base += HEAP_CHUNK_SIZE - offset;
+    heap_max_chunks--;
+  }
+  heap_chunks = 0;
+
+  chunk_table = (HeapChunk**)calloc(heap_max_chunks, sizeof(HeapChunk*));
+  chunk_dirty = (unsigned char*)calloc(heap_max_chunks, sizeof(unsigned char));
+
+  // card table pages are only touched as the heap grows
+  card_table = nullptr;
+  card_bias = 0;
+  if(gc_generational) {
+    card_table = (unsigned char*)calloc(heap_max_chunks << (HEAP_CHUNK_SHIFT - HEAP_CARD_SHIFT), sizeof(unsigned char));
+    card_bias = (size_t)card_table - ((size_t)heap_base >> HEAP_CARD_SHIFT);
+  }
+  free_chunks.clear();
+  for(int i = 0; i < HEAP_NUM_CLASSES; ++i) {
+    class_chunks[i].clear();
+    class_stats[i].block_size = ClassBlockSize(i);
+    class_stats[i].allocations = class_stats[i].requested_bytes = class_stats[i].chunks = 0;
+  }
+
+  gc_active = false;
+  gc_cycle = 0;
+  gc_marked_bytes = 0;
+  gc_live_bytes = 0;
+  gc_minor = false;
+  gc_minor_count = 0;
+  buffer_refills = 0;
+  released_chunks = 0;
+  buffer_lock_contention = 0;
+}
+
+void MemoryManager::ReleaseHeap()
+{
+  if(!chunk_table) {
+    return;
+  }
+
+  for(size_t i = 0; i < heap_chunks; ++i) {
+    HeapChunk* chunk = chunk_table[i];
+    if(chunk && chunk->base == heap_base + (i << HEAP_CHUNK_SHIFT)) {
+      delete chunk;
+      chunk = nullptr;
+    }
+  }
+
+  free(chunk_table);
+  chunk_table = nullptr;
+
+  free(chunk_dirty);
+  chunk_dirty = nullptr;
+
+  free(card_table);
+  card_table = nullptr;
+
+  // reserved range includes any alignment padding
+#ifdef _WIN32
+  VirtualFree(heap_base, 0, MEM_RELEASE);
+#else
+  munmap(heap_base, heap_max_chunks << HEAP_CHUNK_SHIFT);
+#endif
+  heap_base = nullptr;
+  heap_chunks = heap_max_chunks = 0;
+
+  free_chunks.clear();
+  for(int i = 0; i < HEAP_NUM_CLASSES; ++i) {
+    class_chunks[i].clear();
+  }
+  
+  // other threads have exited, drop this thread's buffers
+  memset(alloc_buffers.buffers, 0, sizeof(alloc_buffers.buffers));
+  alloc_buffers.allocated = 0;
+}
+
+// note: caller holds 'allocated_lock'
+HeapChunk* MemoryManager::NewChunk(const size_t span, const size_t block_size, const int size_class)
+{
+  size_t start = heap_chunks;
+
+  // reuse a free chunk
+  if(span == 1) {
+    while(!free_chunks.empty() && start == heap_chunks) {
+      const size_t index = free_chunks.back();
+      free_chunks.pop_back();
+      if(!chunk_table[index]) {
+        start = index;
+      }
+    }
+  }
+  // reuse a run of free chunks
+  else {
+    size_t run = 0;
+    for(size_t i = 0; i < heap_chunks && start == heap_chunks; ++i) {
+      run = chunk_table[i] ? 0 : run + 1;
+      if(run == span) {
+        start = i - span + 1;
+      }
+    }
+  }
+
+  // grow heap
+  if(start == heap_chunks) {
+    if(heap_chunks + span > heap_max_chunks) {
+      std::wcerr << L">>> Unable to allocate heap memory: exceeded " << (heap_max_chunks << HEAP_CHUNK_SHIFT) << L" byte(s) <<<" << std::endl;
+      exit(1);
+    }
+  }
+
+#ifdef _WIN32
+  // untouched and released chunks are committed on use
+  for(size_t i = start; i < start + span; ++i) {
+    if(!chunk_dirty[i] && !VirtualAlloc(heap_base + (i << HEAP_CHUNK_SHIFT), HEAP_CHUNK_SIZE, MEM_COMMIT, PAGE_READWRITE)) {
+      std::wcerr << L">>> Unable to commit heap memory <<<" << std::endl;
+      exit(1);
+    }
+  }
+#endif
+
+  HeapChunk* chunk = new HeapChunk();
+  chunk->base = heap_base + (start << HEAP_CHUNK_SHIFT);
+  chunk->block_size = block_size;
+  chunk->num_blocks = (span << HEAP_CHUNK_SHIFT) / block_size;
+  chunk->span = span;
+  chunk->sweep_cycle = gc_cycle;
+  chunk->size_class = size_class;
+
+  for(size_t i = start; i < start + span; ++i) {
+    if(chunk_dirty[i]) {
+      chunk->dirty_bytes = ((i - start) + 1) << HEAP_CHUNK_SHIFT;
+    }
+    chunk_dirty[i] = 1;
+    chunk_table[i] = chunk;
+  }
+
+  // publish once the table has been updated
+  if(start + span > heap_chunks) {
+    heap_chunks = start + span;
+  }
+
+#ifdef _DEBUG_GC
+  std::wcout << L"*** New chunk: address=" << (void*)chunk->base << L", span=" << span
+             << L", block_size=" << block_size << L" ***" << std::endl;
+#endif
+
+  return chunk;
+}
+
+// note: caller holds 'allocated_lock'
+void MemoryManager::FreeChunk(HeapChunk* chunk)
+{
+  const size_t start = (chunk->base - heap_base) >> HEAP_CHUNK_SHIFT;
+  for(size_t i = start; i < start + chunk->span; ++i) {
+    chunk_table[i] = nullptr;
+    free_chunks.push_back(i);
+  }
+
+#ifdef _DEBUG_GC
+  std::wcout << L"*** Free chunk: address=" << (void*)chunk->base << L", span=" << chunk->span << L" ***" << std::endl;
+#endif
+
+  delete chunk;
+  chunk = nullptr;
+}
+
+//
+// finds the next run of free blocks in a chunk, starting at its cursor
+//
+inline bool MemoryManager::NextFreeRun(HeapChunk* chunk, size_t &start, size_t &end)
+{
+  const size_t num_blocks = chunk->num_blocks;
+
+  // first free block
+  size_t i = chunk->next_block;
+  while(i < num_blocks) {
+    const size_t word = i / HEAP_BITS;
+    const size_t free_bits = ~chunk->alloc_bits[word].load(std::memory_order_relaxed) & (~(size_t)0 << (i % HEAP_BITS));
+    if(free_bits) {
+      i = word * HEAP_BITS + BitScan(free_bits);
+      break;
+    }
+    i = (word + 1) * HEAP_BITS;
+  }
+
+  if(i >= num_blocks) {
+    chunk->next_block = num_blocks;
+    return false;
+  }
+  start = i;
+
+  // extend over free blocks
+  while(i < num_blocks) {
+    const size_t word = i / HEAP_BITS;
+    const size_t used_bits = chunk->alloc_bits[word].load(std::memory_order_relaxed) & (~(size_t)0 << (i % HEAP_BITS));
+    if(used_bits) {
+      i = word * HEAP_BITS + BitScan(used_bits);
+      break;
+    }
+    i = (word + 1) * HEAP_BITS;
+  }
+
+  end = i < num_blocks ? i : num_blocks;
+  chunk->next_block = end;
+
+  return true;
+}
+
+void MemoryManager::LockAllocationBuffers()
+{
+#ifndef _GC_SERIAL
+#ifdef _WIN32
+  if(!TryEnterCriticalSection(&allocated_lock)) {
+    buffer_lock_contention++;
+    EnterCriticalSection(&allocated_lock);
+  }
+#else
+  if(pthread_mutex_trylock(&allocated_lock)) {
+    buffer_lock_contention++;
+    pthread_mutex_lock(&allocated_lock);
+  }
+#endif
+#endif
+}
+
+// note: caller holds 'allocated_lock'
+void MemoryManager::ReleaseAllocationBuffer(AllocationBuffer &buffer)
+{
+  HeapChunk* chunk = buffer.chunk;
+  if(chunk) {
+    chunk->is_owned = false;
+    chunk->next_block = 0;
+
+    SizeClassStats &stats = class_stats[chunk->size_class];
+    stats.allocations += buffer.allocations;
+    stats.requested_bytes += buffer.requested_bytes;
+
+    // blocks may have been freed behind the cursor
+    size_t live_blocks = 0;
+    const size_t num_words = (chunk->num_blocks + HEAP_BITS - 1) / HEAP_BITS;
+    for(size_t i = 0; i < num_words; ++i) {
+      live_blocks += BitCount(chunk->alloc_bits[i].load(std::memory_order_relaxed));
+    }
+    chunk->live_blocks = live_blocks;
+
+    if(live_blocks < chunk->num_blocks) {
+      class_chunks[chunk->size_class].push_back(chunk);
+    }
+  }
+
+  buffer.chunk = nullptr;
+  buffer.next_block = buffer.end_block = 0;
+  buffer.allocations = buffer.requested_bytes = 0;
+}
+
+void MemoryManager::FillAllocationBuffer(AllocationBuffer &buffer, const int size_class)
+{
+  // next free run in the owned chunk
+  size_t start = 0, end = 0;
+  if(buffer.chunk && NextFreeRun(buffer.chunk, start, end)) {
+    buffer.next_block = start;
+    buffer.end_block = end;
+    return;
+  }
+
+  // refill from the shared heap
+  LockAllocationBuffers();
+  
+  // account for allocations made since the last collection
+  if(alloc_buffers.gc_cycle == gc_cycle) {
+    allocation_size += alloc_buffers.allocated;
+  }
+  allocated_bytes += alloc_buffers.allocated;
+  alloc_buffers.total_allocated += alloc_buffers.allocated;
+  alloc_buffers.allocated = 0;
+  alloc_buffers.gc_cycle = gc_cycle;
+
+  ReleaseAllocationBuffer(buffer);
+
+  HeapChunk* chunk = nullptr;
+  std::vector<HeapChunk*> &available = class_chunks[size_class];
+  while(!chunk && !available.empty()) {
+    chunk = available.back();
+    available.pop_back();
+    if(chunk->sweep_cycle != gc_cycle) {
+      SweepChunk(chunk);
+    }
+    if(!NextFreeRun(chunk, start, end)) {
+      chunk = nullptr;
+    }
+  }
+
+  if(!chunk) {
+    chunk = NewChunk(1, ClassBlockSize(size_class), size_class);
+    NextFreeRun(chunk, start, end);
+  }
+  chunk->is_owned = true;
+  buffer_refills++;
+
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&allocated_lock);
+#endif
+
+  buffer.chunk = chunk;
+  buffer.next_block = start;
+  buffer.end_block = end;
+}
+
+inline int MemoryManager::SizeClass(size_t size)
+{
+  // 16-byte steps
+  if(size <= HEAP_SMALL_BLOCK) {
+    return size ? (int)((size - 1) / HEAP_MIN_BLOCK) : 0;
+  }
+  
+  if(size > HEAP_MAX_BLOCK) {
+    return -1;
+  }
+
+  // four classes per doubling, picked by the two bits below the highest
+  const size_t value = size - 1;
+  const int bit = (int)BitScanReverse(value);
+  if(size <= HEAP_MEDIUM_BLOCK) {
+    return HEAP_SMALL_CLASSES + (bit - 8) * 4 + (int)((value >> (bit - 2)) & 3);
+  }
+
+  // powers of two
+  return HEAP_SMALL_CLASSES + HEAP_MEDIUM_CLASSES + (bit - 13);
+}
+
+size_t MemoryManager::ClassBlockSize(const int size_class)
+{
+  if(size_class < HEAP_SMALL_CLASSES) {
+    return (size_t)(size_class + 1) * HEAP_MIN_BLOCK;
+  }
+
+  if(size_class < HEAP_SMALL_CLASSES + HEAP_MEDIUM_CLASSES) {
+    const int step = size_class - HEAP_SMALL_CLASSES;
+    const size_t base = (size_t)HEAP_SMALL_BLOCK << (step / 4);
+    return base + (base >> 2) * (step % 4 + 1);
+  }
+
+  return (size_t)HEAP_MEDIUM_BLOCK << (size_class - HEAP_SMALL_CLASSES - HEAP_MEDIUM_CLASSES + 1);
+}
+
+size_t* MemoryManager::GetMemory(size_t size)
+{
+  const int size_class = SizeClass(size);
+  if(size_class < 0) {
+    return GetLargeMemory(size);
+  }
+
+  // bump allocate from this thread's buffer
+  AllocationBuffer &buffer = alloc_buffers.buffers[size_class];
+  if(buffer.next_block >= buffer.end_block) {
+    FillAllocationBuffer(buffer, size_class);
+  }
+
+  HeapChunk* chunk = buffer.chunk;
+  const size_t index = buffer.next_block++;
+  buffer.allocations++;
+  buffer.requested_bytes += size;
+  const size_t bit = (size_t)1 << (index % HEAP_BITS);
+  chunk->alloc_bits[index / HEAP_BITS].fetch_or(bit, std::memory_order_relaxed);
+
+  const size_t offset = index * chunk->block_size;
+  size_t* mem = (size_t*)(chunk->base + offset);
+
+  // allocated during a collection, treat as live. such objects start out
+  // old, so their cards are dirtied to have minor collections scan them.
+  if(gc_active.load(std::memory_order_relaxed)) {
+    chunk->mark_bits[index / HEAP_BITS].fetch_or(bit, std::memory_order_relaxed);
+    gc_marked_bytes.fetch_add(chunk->block_size, std::memory_order_relaxed);
+    if(gc_generational) {
+      MarkCards((char*)mem, (char*)mem + chunk->block_size);
+    }
+  }
+  alloc_buffers.allocated += chunk->block_size;
+
+  // untouched memory is already zeroed
+  if(offset < chunk->dirty_bytes) {
+    memset(mem, 0, size);
+  }
+  else {
+    chunk->dirty_bytes = offset + chunk->block_size;
+  }
+
+  return mem;
+}
+
+size_t* MemoryManager::GetLargeMemory(size_t size)
+{
+  LockAllocationBuffers();
+
+  // large block, spanning one or more chunks
+  const size_t span = (size + HEAP_CHUNK_SIZE - 1) >> HEAP_CHUNK_SHIFT;
+  HeapChunk* chunk = NewChunk(span, span << HEAP_CHUNK_SHIFT, -1);
+  chunk->alloc_bits[0] = 1;
+  if(gc_active) {
+    chunk->mark_bits[0] = 1;
+    gc_marked_bytes += chunk->block_size;
+    if(gc_generational) {
+      MarkCards(chunk->base, chunk->base + chunk->block_size);
+    }
+  }
+  chunk->live_blocks = 1;
+  allocation_size += chunk->block_size;
+  allocated_bytes += chunk->block_size;
+  alloc_buffers.total_allocated += chunk->block_size;
+
+  const bool is_dirty = chunk->dirty_bytes > 0;
+  chunk->dirty_bytes = chunk->block_size;
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&allocated_lock);
+#endif
+
+  size_t* mem = (size_t*)chunk->base;
+  if(is_dirty) {
+    memset(mem, 0, size);
+  }
+
+  return mem;
+}
+
+ThreadAllocationBuffers::~ThreadAllocationBuffers()
+{
+  if(!MemoryManager::chunk_table) {
+    return;
+  }
+
+  // return owned chunks to the shared heap
+  MemoryManager::LockAllocationBuffers();
+  if(gc_cycle == MemoryManager::gc_cycle) {
+    MemoryManager::allocation_size += allocated;
+  }
+  MemoryManager::allocated_bytes += allocated;
+  allocated = 0;
+  
+  for(int i = 0; i < HEAP_NUM_CLASSES; ++i) {
+    MemoryManager::ReleaseAllocationBuffer(buffers[i]);
+  }
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&MemoryManager::allocated_lock);
+#endif
+}
+
+void MemoryManager::SweepChunk(HeapChunk* chunk)
+{
+  size_t live_blocks = 0;
+  const size_t num_words = (chunk->num_blocks + HEAP_BITS - 1) / HEAP_BITS;
+  for(size_t i = 0; i < num_words; ++i) {
+    // owning threads may set allocation bits concurrently, only clear dead ones
+    const size_t alloc_bits = chunk->alloc_bits[i].load(std::memory_order_relaxed);
+    const size_t dead_bits = alloc_bits & ~chunk->mark_bits[i].load(std::memory_order_relaxed);
+    const size_t live_bits = chunk->alloc_bits[i].fetch_and(~dead_bits, std::memory_order_relaxed) & ~dead_bits;
+    // in generational mode, survivors stay marked as old
+    if(!gc_generational) {
+      chunk->mark_bits[i].store(0, std::memory_order_relaxed);
+    }
+    live_blocks += BitCount(live_bits);
+    
+#if defined(_MEM_LOGGING) || defined(_DEBUG_GC)
+    size_t log_bits = dead_bits;
+    while(log_bits) {
+      const size_t bit = BitScan(log_bits);
+      log_bits &= log_bits - 1;
+      size_t* mem = (size_t*)(chunk->base + (i * HEAP_BITS + bit) * chunk->block_size) + EXTRA_BUF_SIZE;
+#ifdef _MEM_LOGGING
+      mem_logger << mem_cycle << L", dealloc," << (mem[TYPE] == NIL_TYPE ? "obj," : "array,") << mem << L"," << chunk->block_size << std::endl;
+#endif
+#ifdef _DEBUG_GC
+      std::wcout << L"# freeing memory: addr=" << mem << L"(" << (size_t)mem
+                 << L"), size=" << chunk->block_size << L" byte(s) #" << std::endl;
+#endif
+    }
+#endif
+  }
+
+  chunk->live_blocks = live_blocks;
+  chunk->sweep_cycle = gc_cycle;
+  if(!chunk->is_owned) {
+    chunk->next_block = 0;
+  }
+}
+
+//
+// sweeps chunks not taken by allocating threads since the last collection,
+// called while other threads are stopped. empty chunks are freed.
+//
+void MemoryManager::FinishSweep()
+{
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&allocated_lock);
+#endif
+
+  for(int i = 0; i < HEAP_NUM_CLASSES; ++i) {
+    class_chunks[i].clear();
+  }
+
+  for(size_t i = 0; i < heap_chunks; ++i) {
+    HeapChunk* chunk = chunk_table[i];
+    if(chunk && chunk->base == heap_base + (i << HEAP_CHUNK_SHIFT)) {
+      if(chunk->sweep_cycle != gc_cycle) {
+        SweepChunk(chunk);
+      }
+
+      if(!chunk->is_owned) {
+        if(!chunk->live_blocks) {
+          FreeChunk(chunk);
+        }
+        else if(chunk->size_class > -1 && chunk->live_blocks < chunk->num_blocks) {
+          class_chunks[chunk->size_class].push_back(chunk);
+        }
+      }
+    }
+  }
+  ReleaseChunks();
+
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&allocated_lock);
+#endif
+}
+
+//
+// chunks found empty here were not needed by allocating threads since the
+// last collection. a few are kept, the pages of others are returned to the
+// operating system and read as zero when reused.
+// note: caller holds 'allocated_lock'
+//
+void MemoryManager::ReleaseChunks()
+{
+  std::vector<size_t> dirty_chunks;
+  free_chunks.clear();
+  for(size_t i = 0; i < heap_chunks; ++i) {
+    if(!chunk_table[i]) {
+      if(chunk_dirty[i]) {
+        dirty_chunks.push_back(i);
+      }
+      else {
+        free_chunks.push_back(i);
+      }
+    }
+  }
+
+  // chunks at the back are reused first
+  const size_t retained_chunks = MEM_START_MAX >> HEAP_CHUNK_SHIFT;
+  for(size_t i = 0; i < dirty_chunks.size(); ++i) {
+    const size_t index = dirty_chunks[i];
+    if(dirty_chunks.size() - i > retained_chunks) {
+      char* base = heap_base + (index << HEAP_CHUNK_SHIFT);
+#ifdef _WIN32
+      VirtualFree(base, HEAP_CHUNK_SIZE, MEM_DECOMMIT);
+#else
+      madvise(base, HEAP_CHUNK_SIZE, MADV_DONTNEED);
+#endif
+      chunk_dirty[index] = 0;
+      released_chunks++;
+    }
+    free_chunks.push_back(index);
+  }
+}
+
+void MemoryManager::ClearMarks()
+{
+  for(size_t i = 0; i < heap_chunks; ++i) {
+    HeapChunk* chunk = chunk_table[i];
+    if(chunk && chunk->base == heap_base + (i << HEAP_CHUNK_SHIFT)) {
+      const size_t num_words = (chunk->num_blocks + HEAP_BITS - 1) / HEAP_BITS;
+      for(size_t j = 0; j < num_words; ++j) {
+        chunk->mark_bits[j].store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+void MemoryManager::ClearCards()
+{
+  memset(card_table, 0, heap_chunks << (HEAP_CHUNK_SHIFT - HEAP_CARD_SHIFT));
+}
+
+//
+// traces from old blocks that overlap dirty cards within [start, end);
+// new blocks are only reached by tracing, so unmarked blocks are skipped
+//
+void MemoryManager::CheckCards(size_t start, size_t end)
+{
+  size_t* last_obj = nullptr;
+
+  size_t i = start;
+  while(i < end) {
+    // skip clean cards a word at a time
+    if(!(i % sizeof(size_t)) && !*(size_t*)(card_table + i)) {
+      i += sizeof(size_t);
+      continue;
+    }
+
+    if(!card_table[i]) {
+      i++;
+      continue;
+    }
+
+    // clear before scanning, a racing store dirties the card again
+    card_table[i] = 0;
+    const char* card_start = heap_base + (i << HEAP_CARD_SHIFT);
+    const char* card_end = card_start + HEAP_CARD_SIZE;
+    HeapChunk* chunk = chunk_table[i >> (HEAP_CHUNK_SHIFT - HEAP_CARD_SHIFT)];
+    i++;
+
+    if(!chunk) {
+      continue;
+    }
+
+    const size_t first = (card_start - chunk->base) / chunk->block_size;
+    size_t last = (card_end - 1 - chunk->base) / chunk->block_size + 1;
+    if(last > chunk->num_blocks) {
+      last = chunk->num_blocks;
+    }
+
+    for(size_t j = first; j < last; ++j) {
+      const size_t bit = (size_t)1 << (j % HEAP_BITS);
+      if((chunk->alloc_bits[j / HEAP_BITS].load(std::memory_order_relaxed) & bit) &&
+         (chunk->mark_bits[j / HEAP_BITS].load(std::memory_order_relaxed) & bit)) {
+        size_t* mem = (size_t*)(chunk->base + j * chunk->block_size) + EXTRA_BUF_SIZE;
+        // objects spanning several dirty cards are checked once
+        if(mem[TYPE] == NIL_TYPE) {
+          if(mem != last_obj) {
+            CheckCardBlock(mem, card_start, card_end);
+            last_obj = mem;
+          }
+        }
+        else {
+          const char* block_end = chunk->base + (j + 1) * chunk->block_size;
+          CheckCardBlock(mem, card_start, card_end < block_end ? card_end : block_end);
+        }
+      }
+    }
+  }
+}
+
+void MemoryManager::CheckCardBlock(size_t* mem, const char* card_start, const char* card_end)
+{
+  switch(mem[TYPE]) {
+  case NIL_TYPE: {
+    StackClass* cls = (StackClass*)mem[SIZE_OR_CLS];
+    if(cls) {
+      CheckMemory(mem, cls->GetInstanceDeclarations(), cls->GetNumberInstanceDeclarations());
+    }
+  }
+    break;
+
+    // conservatively check words within the card, closures are byte arrays
+  case INT_TYPE:
+  case BYTE_ARY_TYPE: {
+    size_t* start = (char*)mem > card_start ? mem : (size_t*)card_start;
+    size_t* end = (size_t*)card_end;
+    for(size_t* check_mem = start; check_mem < end; ++check_mem) {
+      if(IsHeapMemory((size_t*)*check_mem)) {
+        CheckObject((size_t*)*check_mem, false);
+      }
+    }
+  }
+    break;
+
+  default:
+    break;
+  }
+}
+
+void MemoryManager::WriteBarrierObject(size_t* mem)
+{
+  if(gc_marking.load(std::memory_order_relaxed)) {
+    SatbObject(mem);
+  }
+
+  if(!gc_generational) {
+    return;
+  }
+
+  size_t index;
+  HeapChunk* chunk = FindChunk(mem, index);
+  if(chunk && (mem[TYPE] == NIL_TYPE || mem[TYPE] == INT_TYPE)) {
+    const char* block = chunk->base + index * chunk->block_size;
+    MarkCards(block, block + chunk->block_size);
+  }
+}
+
+void MemoryManager::WriteBarrierStack(size_t* op_stack, long stack_pos)
+{
+  if(!gc_generational && !gc_marking.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  while(stack_pos > -1) {
+    WriteBarrierObject((size_t*)op_stack[stack_pos--]);
+  }
+}
+
+SizeClassStats MemoryManager::GetSizeClassStats(const int size_class)
+{
+  LockAllocationBuffers();
+  SizeClassStats stats = class_stats[size_class];
+  stats.chunks = 0;
+  for(size_t i = 0; i < heap_chunks; ++i) {
+    HeapChunk* chunk = chunk_table[i];
+    if(chunk && chunk->size_class == size_class && chunk->base == heap_base + (i << HEAP_CHUNK_SHIFT)) {
+      stats.chunks++;
+    }
+  }
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&allocated_lock);
+#endif
+
+  return stats;
+}
+
+size_t* MemoryManager::ValidObjectCast(size_t* mem, long to_id, long* cls_hierarchy, long** cls_interfaces)
+{
+  // invalid array cast  
+  long id = GetObjectID(mem);
+  if(id < 0) {
+    return nullptr;
+  }
+
+  // upcast
+  long virtual_cls_id = id;
+  while(virtual_cls_id != -1) {
+    if (virtual_cls_id == to_id) {
+      return mem;
+    }
+    // update
+    virtual_cls_id = cls_hierarchy[virtual_cls_id];
+  }
+
+  // check interfaces
+  virtual_cls_id = id;
+  while(virtual_cls_id != -1) {
+    long* interfaces = cls_interfaces[virtual_cls_id];
+    if(interfaces) {
+      int i = 0;
+      long inf_id = interfaces[i];
+      while(inf_id > INF_ENDING) {
+        if (inf_id == to_id) {
+          return mem;
+        }
+        inf_id = interfaces[++i];
+      }
+    }
+    // update
+    virtual_cls_id = cls_hierarchy[virtual_cls_id];
+  }
+
+  return nullptr;
+}
+
+void MemoryManager::CollectAllMemory(size_t* op_stack, long stack_pos)
+{
+  // concurrent marking is underway, keep allocating until it is done
+  if(gc_marking && gc_running_workers && allocation_size < mem_max_size * GC_CONCURRENT_LIMIT) {
+    return;
+  }
+
+#ifdef _TIMING
+  std::wcout << L"=========================================" << std::endl;
+  clock_t start = clock();
+#endif
+
+#ifndef _GC_SERIAL
+#ifdef _WIN32
+  // only one thread at a time can invoke the gargabe collector
+  if(!TryEnterCriticalSection(&marked_sweep_lock)) {
+    ParkMutator(stack_pos);
+    return;
+  }
+#else
+  if(pthread_mutex_trylock(&marked_sweep_lock)) {
+    ParkMutator(stack_pos);
+    return;
+  }
+#endif
+#endif
+
+  // concurrent marking runs between two short pauses
+  if(gc_concurrent) {
+    if(gc_marking) {
+      // wait for the collector threads before stopping other threads
+      WaitMarkPhase();
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      StopMutators(stack_pos);
+      FinishConcurrentMark();
+      SweepMemory();
+      gc_active = false;
+      RecordPause(start, "remark");
+    }
+    else {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      StopMutators(stack_pos);
+      FinishSweep();
+      CollectionInfo info;
+      info.op_stack = op_stack;
+      info.stack_pos = stack_pos;
+      gc_active = true;
+      StartConcurrentMark(&info);
+      RecordPause(start, "initial-mark");
+    }
+  }
+  else {
+    // wait for other threads to reach a safepoint, marks left by the last
+    // collection are cleared by sweeping
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    StopMutators(stack_pos);
+    FinishSweep();
+
+    // minor collections trace from roots and dirty cards, keeping old marks
+    if(gc_generational) {
+      gc_minor = gc_minor_count < GC_MINOR_MAX;
+      if(gc_minor) {
+        gc_minor_count++;
+      }
+      else {
+        gc_minor_count = 0;
+        ClearMarks();
+        ClearCards();
+      }
+    }
+
+    CollectionInfo info;
+    info.op_stack = op_stack;
+    info.stack_pos = stack_pos;
+    gc_active = true;
+
+    // marking is done by the collector threads, this thread waits
+    CollectMemory(&info);
+    gc_active = false;
+    RecordPause(start, gc_minor ? "minor" : "full");
+  }
+  ResumeMutators();
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&marked_sweep_lock);
+#endif
+
+#ifdef _TIMING
+  clock_t end = clock();
+  std::wcout << L"Collection: size=" << mem_max_size << L", time=" << (double)(end - start) / CLOCKS_PER_SEC << L" second(s)." << std::endl;
+  std::wcout << L"Allocation buffers: refills=" << buffer_refills << L", contended=" << buffer_lock_contention << std::endl;
+  std::wcout << L"Released chunks: " << released_chunks << std::endl;
+  std::wcout << L"Size classes (block: allocations, used):";
+  for(int i = 0; i < HEAP_NUM_CLASSES; ++i) {
+    const SizeClassStats &stats = class_stats[i];
+    if(stats.allocations) {
+      std::wcout << L" " << stats.block_size << L": " << stats.allocations << L", " 
+                 << (stats.requested_bytes * 100 / (stats.allocations * stats.block_size)) << L"%;";
+    }
+  }
+  std::wcout << std::endl;
+  std::wcout << L"=========================================" << std::endl << std::endl;
+#endif
+}
+
+void MemoryManager::CollectMemory(CollectionInfo* info)
+{
+#ifdef _TIMING
+  clock_t start = clock();
+#endif
+
+#ifdef _DEBUG_GC
+  std::wcout << std::dec << std::endl << L"=========================================" << std::endl;
+#ifdef _WIN32
+  std::wcout << L"Starting Garbage Collection; thread=" << GetCurrentThread() << std::endl;
+#else
+  std::wcout << L"Starting Garbage Collection; thread=" << pthread_self() << std::endl;
+#endif
+  std::wcout << L"=========================================" << std::endl;
+  std::wcout << L"## Marking memory ##" << std::endl;
+#endif
+
+  CheckRoots(info);
+  
+#ifdef _TIMING
+  clock_t end = clock();
+  std::wcout << dec << L"Mark time: " << (double)(end - start) / CLOCKS_PER_SEC << L" second(s)." << std::endl;
+#endif
+
+  SweepMemory();
+}
+
+void MemoryManager::SweepMemory()
+{
+#ifdef _TIMING
+  clock_t start = clock();
+#endif
+  
+  // sweep memory
+#ifdef _DEBUG_GC
+  size_t start = allocation_size;
+  std::wcout << L"## Sweeping memory ##" << std::endl;
+#endif
+
+  // sweep chunks
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&allocated_lock);
+#endif
+
+#ifdef _DEBUG_GC
+  std::wcout << L"-----------------------------------------" << std::endl;
+  std::wcout << L"Sweeping..." << std::endl;
+  std::wcout << L"-----------------------------------------" << std::endl;
+#endif
+
+  // chunks are swept lazily, by allocating threads as they take them or
+  // before the next marking. chunks owned by allocation buffers are swept
+  // now, as their owners allocate from them without sweeping. live memory
+  // is what was marked, including old memory kept by minor collections.
+  for(int i = 0; i < HEAP_NUM_CLASSES; ++i) {
+    class_chunks[i].clear();
+  }
+  gc_cycle++;
+
+  for(size_t i = 0; i < heap_chunks; ++i) {
+    HeapChunk* chunk = chunk_table[i];
+    if(chunk && chunk->base == heap_base + (i << HEAP_CHUNK_SHIFT)) {
+      if(chunk->is_owned) {
+        SweepChunk(chunk);
+      }
+      else if(chunk->size_class > -1) {
+        class_chunks[chunk->size_class].push_back(chunk);
+      }
+    }
+  }
+
+  gc_collections++;
+  const size_t allocated_size = allocation_size;
+  gc_live_bytes = gc_minor ? gc_live_bytes + gc_marked_bytes : gc_marked_bytes.load();
+  gc_marked_bytes = 0;
+  allocation_size = gc_live_bytes;
+
+  // old objects fill most of the heap, run a full collection next
+  if(gc_minor && allocation_size > mem_max_size - (mem_max_size >> 2)) {
+    gc_minor_count = GC_MINOR_MAX;
+  }
+
+  // did not collect memory; adjust constraints
+  if(gc_live_bytes + HEAP_MIN_BLOCK >= allocated_size) {
+    if(uncollected_count < UNCOLLECTED_COUNT) {
+      uncollected_count++;
+    } 
+    else {
+      mem_max_size <<= 3;
+      gc_max_size_changes++;
+      uncollected_count = 0;
+    }
+  }
+  // collected memory; adjust constraints
+  else if(mem_max_size != MEM_START_MAX) {
+    if(collected_count < COLLECTED_COUNT) {
+      collected_count++;
+    } 
+    else {
+      mem_max_size >>= 2;
+      if(mem_max_size <= 0) {
+        mem_max_size = MEM_START_MAX;
+      }
+      gc_max_size_changes++;
+      collected_count = 0;
+    }
+  }
+
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&allocated_lock);
+#endif
+
+#ifdef _MEM_LOGGING
+  mem_cycle++;
+#endif
+
+#ifdef _DEBUG_GC
+  std::wcout << L"===============================================================" << std::endl;
+  std::wcout << L"Finished Collection: collected=" << (start - allocation_size)
+        << L" of " << start << L" byte(s) - " << std::showpoint << std::setprecision(3)
+        << (((double)(start - allocation_size) / (double)start) * 100.0)
+        << L"%" << std::endl;
+  std::wcout << L"===============================================================" << std::endl;
+#endif
+  
+#ifdef _TIMING
+  clock_t end = clock();
+  std::wcout << dec << L"Sweep time: " << (double)(end - start) / CLOCKS_PER_SEC << L" second(s)." << std::endl;
+#endif
+}
+
+void MemoryManager::RecordPause(const std::chrono::steady_clock::time_point &start, const char* type)
+{
+  const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  const size_t pause = (size_t)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+  gc_pauses++;
+  gc_pause_total += pause;
+  if(pause > gc_pause_max) {
+    gc_pause_max = pause;
+  }
+
+  // bucket i counts pauses of 2^i up to 2^(i+1) microseconds
+  size_t bucket = BitScanReverse(pause | 1);
+  if(bucket >= GC_PAUSE_BUCKETS) {
+    bucket = GC_PAUSE_BUCKETS - 1;
+  }
+  gc_pause_histogram[bucket]++;
+
+  // other threads are still stopped, heap counters are stable
+  if(gc_log.is_open()) {
+    const size_t time = (size_t)std::chrono::duration_cast<std::chrono::milliseconds>(end - gc_start_time).count();
+    gc_log << time << ',' << gc_collections << ',' << type << ',' << pause << ',' << gc_live_bytes << ','
+           << allocation_size << ',' << mem_max_size << ',' << (free_chunks.size() << HEAP_CHUNK_SHIFT) << std::endl;
+  }
+}
+
+size_t MemoryManager::GetStatistic(const long id)
+{
+  switch(id) {
+  case GC_STAT_COLLECTIONS:
+    return gc_collections;
+
+  case GC_STAT_PAUSES:
+    return gc_pauses;
+
+  case GC_STAT_PAUSE_TOTAL:
+    return gc_pause_total;
+
+  case GC_STAT_PAUSE_MAX:
+    return gc_pause_max;
+
+  case GC_STAT_LIVE_BYTES:
+    return gc_live_bytes;
+
+  case GC_STAT_HEAP_SIZE:
+    return allocation_size;
+
+  case GC_STAT_MAX_SIZE:
+    return mem_max_size;
+
+  case GC_STAT_MAX_SIZE_CHANGES:
+    return gc_max_size_changes;
+
+  case GC_STAT_ALLOCATED:
+    return allocated_bytes + alloc_buffers.allocated;
+
+  case GC_STAT_THREAD_ALLOCATED:
+    return alloc_buffers.total_allocated + alloc_buffers.allocated;
+
+  case GC_STAT_FREE_CACHE: {
+#ifndef _GC_SERIAL
+    MUTEX_LOCK(&allocated_lock);
+#endif
+    const size_t free_size = free_chunks.size() << HEAP_CHUNK_SHIFT;
+#ifndef _GC_SERIAL
+    MUTEX_UNLOCK(&allocated_lock);
+#endif
+    return free_size;
+  }
+
+  case GC_STAT_RELEASED_CHUNKS:
+    return released_chunks;
+
+  case GC_STAT_PAUSE_BUCKETS:
+    return GC_PAUSE_BUCKETS;
+
+  default:
+    if(id >= GC_STAT_PAUSE_HISTOGRAM && id < GC_STAT_PAUSE_HISTOGRAM + GC_PAUSE_BUCKETS) {
+      return gc_pause_histogram[id - GC_STAT_PAUSE_HISTOGRAM];
+    }
+    return 0;
+  }
+}
+
+void MemoryManager::AddMutator(size_t* op_stack, long* stack_pos, long stack_size)
+{
+  MutatorThread* thread = new MutatorThread;
+  thread->op_stack = op_stack;
+  thread->stack_pos = stack_pos;
+  thread->stack_size = stack_size;
+  thread->park_pos = 0;
+  thread->state = MUTATOR_RUNNING;
+
+  // new threads wait for a running collection to finish
+  MUTEX_LOCK(&safepoint_lock);
+  while(safepoint_requested) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&safepoint_resume, &safepoint_lock, INFINITE);
+#else
+    pthread_cond_wait(&safepoint_resume, &safepoint_lock);
+#endif
+  }
+  mutators.insert(thread);
+  running_mutators++;
+  MUTEX_UNLOCK(&safepoint_lock);
+
+  mutator = thread;
+}
+
+void MemoryManager::RemoveMutator()
+{
+  if(!mutator) {
+    return;
+  }
+
+  // hand off references recorded during concurrent marking
+  if(!mutator->satb_buffer.empty()) {
+    MUTEX_LOCK(&satb_lock);
+    satb_queue.insert(satb_queue.end(), mutator->satb_buffer.begin(), mutator->satb_buffer.end());
+    MUTEX_UNLOCK(&satb_lock);
+  }
+
+  MUTEX_LOCK(&safepoint_lock);
+  mutators.erase(mutator);
+  running_mutators--;
+#ifdef _WIN32
+  WakeAllConditionVariable(&safepoint_parked);
+#else
+  pthread_cond_broadcast(&safepoint_parked);
+#endif
+  MUTEX_UNLOCK(&safepoint_lock);
+
+  delete mutator;
+  mutator = nullptr;
+
+  // class metadata may be released once threads exit, finish tracing first
+  if(gc_marking) {
+    WaitMarkPhase();
+  }
+}
+
+void MemoryManager::Safepoint()
+{
+  if(mutator) {
+    ParkMutator(*mutator->stack_pos);
+  }
+}
+
+void MemoryManager::ParkMutator(long stack_pos)
+{
+  if(!mutator) {
+    return;
+  }
+
+  MUTEX_LOCK(&safepoint_lock);
+  if(safepoint_requested && mutator->state == MUTATOR_RUNNING) {
+    mutator->park_pos = stack_pos;
+    mutator->state = MUTATOR_PARKED;
+    running_mutators--;
+#ifdef _WIN32
+    WakeAllConditionVariable(&safepoint_parked);
+#else
+    pthread_cond_broadcast(&safepoint_parked);
+#endif
+
+    while(safepoint_requested) {
+#ifdef _WIN32
+      SleepConditionVariableCS(&safepoint_resume, &safepoint_lock, INFINITE);
+#else
+      pthread_cond_wait(&safepoint_resume, &safepoint_lock);
+#endif
+    }
+
+    mutator->state = MUTATOR_RUNNING;
+    running_mutators++;
+  }
+  MUTEX_UNLOCK(&safepoint_lock);
+}
+
+void MemoryManager::EnterSafeRegion()
+{
+  if(!mutator) {
+    return;
+  }
+
+  MUTEX_LOCK(&safepoint_lock);
+  mutator->park_pos = *mutator->stack_pos;
+  mutator->state = MUTATOR_BLOCKED;
+  running_mutators--;
+#ifdef _WIN32
+  WakeAllConditionVariable(&safepoint_parked);
+#else
+  pthread_cond_broadcast(&safepoint_parked);
+#endif
+  MUTEX_UNLOCK(&safepoint_lock);
+}
+
+void MemoryManager::LeaveSafeRegion()
+{
+  if(!mutator) {
+    return;
+  }
+
+  // do not resume while memory is being collected
+  MUTEX_LOCK(&safepoint_lock);
+  while(safepoint_requested) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&safepoint_resume, &safepoint_lock, INFINITE);
+#else
+    pthread_cond_wait(&safepoint_resume, &safepoint_lock);
+#endif
+  }
+  mutator->state = MUTATOR_RUNNING;
+  running_mutators++;
+  MUTEX_UNLOCK(&safepoint_lock);
+}
+
+//
+// requests a safepoint and waits until all other threads are parked or
+// blocked. the collecting thread counts as parked.
+//
+void MemoryManager::StopMutators(long stack_pos)
+{
+  MUTEX_LOCK(&safepoint_lock);
+  safepoint_requested = true;
+  if(mutator && mutator->state == MUTATOR_RUNNING) {
+    mutator->park_pos = stack_pos;
+    mutator->state = MUTATOR_PARKED;
+    running_mutators--;
+  }
+
+  while(running_mutators > 0) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&safepoint_parked, &safepoint_lock, INFINITE);
+#else
+    pthread_cond_wait(&safepoint_parked, &safepoint_lock);
+#endif
+  }
+  MUTEX_UNLOCK(&safepoint_lock);
+}
+
+void MemoryManager::ResumeMutators()
+{
+  MUTEX_LOCK(&safepoint_lock);
+  safepoint_requested = false;
+  if(mutator && mutator->state == MUTATOR_PARKED) {
+    mutator->state = MUTATOR_RUNNING;
+    running_mutators++;
+  }
+#ifdef _WIN32
+  WakeAllConditionVariable(&safepoint_resume);
+#else
+  pthread_cond_broadcast(&safepoint_resume);
+#endif
+  MUTEX_UNLOCK(&safepoint_lock);
+}
+
+//
+// operand stacks of stopped threads, the collecting thread's stack is
+// checked by the caller
+//
+void MemoryManager::CheckMutators()
+{
+  int id = 0;
+
+  MUTEX_LOCK(&safepoint_lock);
+  for(std::unordered_set<MutatorThread*>::iterator iter = mutators.begin(); iter != mutators.end(); ++iter) {
+    MutatorThread* thread = *iter;
+    if(thread != mutator) {
+      long stack_size = thread->park_pos + SAFEPOINT_STACK_SLACK;
+      if(stack_size > thread->stack_size) {
+        stack_size = thread->stack_size;
+      }
+
+      for(long i = 0; i < stack_size; i += GC_STACK_SLICE) {
+        const long count = stack_size - i < GC_STACK_SLICE ? stack_size - i : GC_STACK_SLICE;
+        PushMarkTask(id++ % gc_num_workers, MARK_STACK, thread->op_stack + i, count);
+      }
+    }
+  }
+  MUTEX_UNLOCK(&safepoint_lock);
+}
+
+//
+// marks memory referenced by roots while other threads are stopped, then
+// traces from it on the collector threads once they are resumed
+//
+void MemoryManager::StartConcurrentMark(CollectionInfo* info)
+{
+  gc_roots_only = true;
+  CheckRoots(info);
+  gc_roots_only = false;
+
+  gc_marking = true;
+  StartMarkPhase();
+}
+
+//
+// called while other threads are stopped, traces overwritten references
+// recorded by the snapshot barrier
+//
+void MemoryManager::FinishConcurrentMark()
+{
+  MUTEX_LOCK(&satb_lock);
+  CheckSatbBuffers();
+  StartMarkPhase();
+  WaitMarkPhase();
+
+  gc_marking = false;
+  satb_queue.clear();
+  MUTEX_UNLOCK(&satb_lock);
+}
+
+void MemoryManager::CheckSatbBuffers()
+{
+  int id = 0;
+
+  MUTEX_LOCK(&safepoint_lock);
+  for(std::unordered_set<MutatorThread*>::iterator iter = mutators.begin(); iter != mutators.end(); ++iter) {
+    std::vector<size_t> &satb_buffer = (*iter)->satb_buffer;
+    satb_queue.insert(satb_queue.end(), satb_buffer.begin(), satb_buffer.end());
+    satb_buffer.clear();
+  }
+  MUTEX_UNLOCK(&safepoint_lock);
+
+  // recorded references are checked like stack values
+  const size_t queue_size = satb_queue.size();
+  for(size_t i = 0; i < queue_size; i += GC_STACK_SLICE) {
+    const size_t count = queue_size - i < GC_STACK_SLICE ? queue_size - i : GC_STACK_SLICE;
+    PushMarkTask(id++ % gc_num_workers, MARK_STACK, satb_queue.data() + i, count);
+  }
+}
+
+void MemoryManager::SatbRecord(size_t* mem)
+{
+  // marked memory is traced by the thread that marked it
+  size_t index;
+  HeapChunk* chunk = FindChunk(mem, index);
+  if(!chunk || (chunk->mark_bits[index / HEAP_BITS].load(std::memory_order_relaxed) & ((size_t)1 << (index % HEAP_BITS)))) {
+    return;
+  }
+
+  if(mutator) {
+    mutator->satb_buffer.push_back((size_t)mem);
+  }
+  else {
+    MUTEX_LOCK(&satb_lock);
+    satb_queue.push_back((size_t)mem);
+    MUTEX_UNLOCK(&satb_lock);
+  }
+}
+
+//
+// records every value held by an object or array that native code
+// may overwrite
+//
+void MemoryManager::SatbObject(size_t* mem)
+{
+  size_t index;
+  HeapChunk* chunk = FindChunk(mem, index);
+  if(chunk && (mem[TYPE] == NIL_TYPE || mem[TYPE] == INT_TYPE || mem[TYPE] == BYTE_ARY_TYPE)) {
+    size_t* end = (size_t*)(chunk->base + (index + 1) * chunk->block_size);
+    for(size_t* check_mem = mem; check_mem < end; ++check_mem) {
+      SatbRecord((size_t*)*check_mem);
+    }
+  }
+}
+
+void MemoryManager::StartMarkWorkers()
+{
+  // size the pool to the machine unless configured
+  long num_workers = 0;
+  const std::wstring gc_threads = StackProgram::GetProperty(L"gc-threads");
+  if(!gc_threads.empty()) {
+    num_workers = wcstol(gc_threads.c_str(), nullptr, 10);
+  }
+  else {
+#ifdef _WIN32
+    SYSTEM_INFO sys_info;
+    GetSystemInfo(&sys_info);
+    num_workers = sys_info.dwNumberOfProcessors;
+#else
+    num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  }
+
+#ifdef _GC_SERIAL
+  num_workers = 1;
+#endif
+
+  if(num_workers < 1) {
+    num_workers = 1;
+  }
+  else if(num_workers > GC_MAX_WORKERS) {
+    num_workers = GC_MAX_WORKERS;
+  }
+
+  gc_num_workers = (int)num_workers;
+  mark_deques = new MarkDeque[gc_num_workers];
+  for(int i = 0; i < gc_num_workers; ++i) {
+    mark_deques[i].count = 0;
+#ifdef _WIN32
+    InitializeCriticalSection(&mark_deques[i].lock);
+#else
+    pthread_mutex_init(&mark_deques[i].lock, nullptr);
+#endif
+  }
+
+  gc_phase = 0;
+  gc_running_workers = 0;
+  gc_workers_exit = false;
+
+#ifndef _GC_SERIAL
+  for(int i = 0; i < gc_num_workers; ++i) {
+#ifdef _WIN32
+    HANDLE worker = (HANDLE)_beginthreadex(nullptr, 0, MarkWorker, (void*)(size_t)i, 0, nullptr);
+    if(!worker) {
+      std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
+      exit(-1);
+    }
+#else
+    pthread_t worker;
+    if(pthread_create(&worker, nullptr, MarkWorker, (void*)(size_t)i)) {
+      std::wcerr << L"Unable to create garbage collection thread!" << std::endl;
+      exit(-1);
+    }
+#endif
+    gc_workers.push_back(worker);
+  }
+#endif
+}
+
+void MemoryManager::StopMarkWorkers()
+{
+  if(!mark_deques) {
+    return;
+  }
+
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&gc_pool_lock);
+  gc_workers_exit = true;
+#ifdef _WIN32
+  WakeAllConditionVariable(&gc_pool_start);
+#else
+  pthread_cond_broadcast(&gc_pool_start);
+#endif
+  MUTEX_UNLOCK(&gc_pool_lock);
+
+  for(size_t i = 0; i < gc_workers.size(); ++i) {
+#ifdef _WIN32
+    if(WaitForSingleObject(gc_workers[i], INFINITE) != WAIT_OBJECT_0) {
+      std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
+      exit(-1);
+    }
+    CloseHandle(gc_workers[i]);
+#else
+    void* status;
+    if(pthread_join(gc_workers[i], &status)) {
+      std::wcerr << L"Unable to join garbage collection threads!" << std::endl;
+      exit(-1);
+    }
+#endif
+  }
+  gc_workers.clear();
+#endif
+
+  for(int i = 0; i < gc_num_workers; ++i) {
+#ifdef _WIN32
+    DeleteCriticalSection(&mark_deques[i].lock);
+#else
+    pthread_mutex_destroy(&mark_deques[i].lock);
+#endif
+  }
+  delete[] mark_deques;
+  mark_deques = nullptr;
+}
+
+//
+// collector thread, parked between marking phases
+//
+#ifdef _WIN32
+unsigned int MemoryManager::MarkWorker(void* arg)
+#else
+void* MemoryManager::MarkWorker(void* arg)
+#endif
+{
+  gc_worker_id = (int)(size_t)arg;
+  size_t phase = 0;
+
+  while(true) {
+    MUTEX_LOCK(&gc_pool_lock);
+    while(phase == gc_phase && !gc_workers_exit) {
+#ifdef _WIN32
+      SleepConditionVariableCS(&gc_pool_start, &gc_pool_lock, INFINITE);
+#else
+      pthread_cond_wait(&gc_pool_start, &gc_pool_lock);
+#endif
+    }
+
+    if(gc_workers_exit) {
+      MUTEX_UNLOCK(&gc_pool_lock);
+      break;
+    }
+    phase = gc_phase;
+    MUTEX_UNLOCK(&gc_pool_lock);
+
+    RunMarkTasks(gc_worker_id);
+
+    // last worker out wakes the collecting thread
+    MUTEX_LOCK(&gc_pool_lock);
+    if(!--gc_running_workers) {
+#ifdef _WIN32
+      WakeAllConditionVariable(&gc_pool_done);
+#else
+      pthread_cond_broadcast(&gc_pool_done);
+#endif
+    }
+    MUTEX_UNLOCK(&gc_pool_lock);
+  }
+
+  return 0;
+}
+
+//
+// starts a marking phase on the collector threads
+//
+void MemoryManager::StartMarkPhase()
+{
+#ifdef _GC_SERIAL
+  RunMarkTasks(0);
+#else
+  MUTEX_LOCK(&gc_pool_lock);
+  gc_idle_workers = 0;
+  gc_running_workers = gc_num_workers;
+  gc_phase++;
+#ifdef _WIN32
+  WakeAllConditionVariable(&gc_pool_start);
+#else
+  pthread_cond_broadcast(&gc_pool_start);
+#endif
+  MUTEX_UNLOCK(&gc_pool_lock);
+#endif
+}
+
+//
+// waits for all collector threads to finish the current phase
+//
+void MemoryManager::WaitMarkPhase()
+{
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&gc_pool_lock);
+  while(gc_running_workers) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&gc_pool_done, &gc_pool_lock, INFINITE);
+#else
+    pthread_cond_wait(&gc_pool_done, &gc_pool_lock);
+#endif
+  }
+  MUTEX_UNLOCK(&gc_pool_lock);
+#endif
+}
+
+void MemoryManager::PushMarkTask(int id, MarkTaskType type, void* data, size_t size, StackDclr** dclrs)
+{
+  MarkDeque &deque = mark_deques[id];
+  const MarkTask task = { type, data, size, dclrs };
+
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&deque.lock);
+#endif
+  deque.tasks.push_back(task);
+  deque.count++;
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&deque.lock);
+#endif
+}
+
+//
+// owner takes the most recent task, keeping traced memory hot
+//
+bool MemoryManager::PopMarkTask(int id, MarkTask &task)
+{
+  MarkDeque &deque = mark_deques[id];
+  if(!deque.count) {
+    return false;
+  }
+
+  bool found = false;
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&deque.lock);
+#endif
+  if(!deque.tasks.empty()) {
+    task = deque.tasks.back();
+    deque.tasks.pop_back();
+    deque.count--;
+    found = true;
+  }
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&deque.lock);
+#endif
+
+  return found;
+}
+
+//
+// thieves take the oldest task, which tends to be the largest
+//
+bool MemoryManager::StealMarkTask(int id, MarkTask &task)
+{
+  for(int i = 1; i < gc_num_workers; ++i) {
+    MarkDeque &deque = mark_deques[(id + i) % gc_num_workers];
+    if(!deque.count) {
+      continue;
+    }
+
+    bool found = false;
+    MUTEX_LOCK(&deque.lock);
+    if(!deque.tasks.empty()) {
+      task = deque.tasks.front();
+      deque.tasks.pop_front();
+      deque.count--;
+      found = true;
+    }
+    MUTEX_UNLOCK(&deque.lock);
+
+    if(found) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool MemoryManager::HasMarkTasks()
+{
+  for(int i = 0; i < gc_num_workers; ++i) {
+    if(mark_deques[i].count) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//
+// runs tasks until every worker is out of work. only busy workers push
+// tasks, so once all workers are idle the deques are empty.
+//
+void MemoryManager::RunMarkTasks(int id)
+{
+  // root phases only mark memory referenced by roots, it is traced later
+  if(!gc_roots_only) {
+    DrainMarkStack();
+  }
+
+  MarkTask task;
+  while(true) {
+    if(PopMarkTask(id, task) || StealMarkTask(id, task)) {
+      RunMarkTask(task);
+      if(!gc_roots_only) {
+        DrainMarkStack();
+      }
+      continue;
+    }
+
+    gc_idle_workers++;
+    while(true) {
+      if(gc_idle_workers == gc_num_workers) {
+        gc_marked_bytes += mark_bytes;
+        mark_bytes = 0;
+        return;
+      }
+
+      if(HasMarkTasks()) {
+        gc_idle_workers--;
+        break;
+      }
+
+#ifdef _WIN32
+      SwitchToThread();
+#else
+      sched_yield();
+#endif
+    }
+  }
+}
+
+//
+// traces memory queued by the current task. while other workers are
+// idle the oldest entry, which tends to lead to the most work, is moved
+// to this worker's deque where it can be stolen.
+//
+void MemoryManager::DrainMarkStack()
+{
+  while(!mark_stack.empty()) {
+#ifndef _GC_SERIAL
+    if(mark_stack.size() > 1 && gc_idle_workers.load(std::memory_order_relaxed) && !mark_deques[gc_worker_id].count) {
+      const MarkTask &shared = mark_stack.front();
+      PushMarkTask(gc_worker_id, shared.type, shared.data, shared.size, shared.dclrs);
+      mark_stack.pop_front();
+    }
+#endif
+
+    const MarkTask task = mark_stack.back();
+    mark_stack.pop_back();
+    RunMarkTask(task);
+  }
+}
+
+void MemoryManager::RunMarkTask(const MarkTask &task)
+{
+  switch(task.type) {
+  case MARK_STATIC:
+    CheckStatic((StackClass**)task.data, task.size);
+    break;
+
+  case MARK_STACK:
+    CheckStack((size_t*)task.data, task.size);
+    break;
+
+  case MARK_PDA_FRAME:
+    CheckPdaFrame((StackFrame*)task.data);
+    break;
+
+  case MARK_JIT_FRAME:
+    CheckJitFrame((StackFrame*)task.data);
+    break;
+
+  case MARK_ARRAY:
+    ScanArray((size_t*)task.data, task.size);
+    break;
+
+  case MARK_CARDS:
+    CheckCards((size_t)task.data, (size_t)task.data + task.size);
+    break;
+
+  case MARK_MEMORY:
+    CheckMemory((size_t*)task.data, task.dclrs, (long)task.size);
+    break;
+  }
+}
+
+//
+// splits roots into mark tasks, dealt round-robin to the collector
+// threads, and waits for marking to finish
+//
+void MemoryManager::CheckRoots(CollectionInfo* info)
+{
+  int id = 0;
+
+  // class memory
+  StackClass** clss = prgm->GetClasses();
+  const size_t cls_num = prgm->GetClassNumber();
+  for(size_t i = 0; i < cls_num; i += GC_CLASS_SLICE) {
+    const size_t count = cls_num - i < GC_CLASS_SLICE ? cls_num - i : GC_CLASS_SLICE;
+    PushMarkTask(id++ % gc_num_workers, MARK_STATIC, clss + i, count);
+  }
+
+  // operand stack
+#ifdef _DEBUG_GC
+  std::wcout << L"----- Marking Stack: std::stack: pos=" << info->stack_pos << L" -----" << std::endl;
+#endif
+  const size_t stack_size = info->stack_pos + 1;
+  for(size_t i = 0; i < stack_size; i += GC_STACK_SLICE) {
+    const size_t count = stack_size - i < GC_STACK_SLICE ? stack_size - i : GC_STACK_SLICE;
+    PushMarkTask(id++ % gc_num_workers, MARK_STACK, info->op_stack + i, count);
+  }
+
+  // stopped threads
+  CheckMutators();
+
+  // method frames
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&pda_frame_lock);
+#endif
+
+#ifdef _DEBUG_GC
+  std::wcout << L"----- PDA frames(s): num=" << pda_frames.size() << L" -----" << std::endl;
+#endif
+
+  for(std::unordered_set<StackFrame**>::iterator iter = pda_frames.begin(); iter != pda_frames.end(); ++iter) {
+    StackFrame* frame = **iter;
+    if(frame) {
+      PushMarkTask(id++ % gc_num_workers, frame->jit_mem ? MARK_JIT_FRAME : MARK_PDA_FRAME, frame, 1);
+    }
+  }
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&pda_frame_lock);
+#endif
+
+  // ------
+#ifndef _GC_SERIAL
+  MUTEX_LOCK(&pda_monitor_lock);
+#endif
+
+#ifdef _DEBUG_GC
+  std::wcout << L"----- PDA method root(s): num=" << pda_monitors.size() << L" -----" << std::endl;
+#endif
+
+  // look at pda methods
+  std::unordered_set<StackFrameMonitor*>::iterator pda_iter;
+  for(pda_iter = pda_monitors.begin(); pda_iter != pda_monitors.end(); ++pda_iter) {
+    StackFrameMonitor* monitor = *pda_iter;
+    // gather stack frames
+    long call_stack_pos = *(monitor->call_stack_pos);
+
+    // note: the current frame is live once execution starts (position 0)
+    StackFrame* cur_frame = *(monitor->cur_frame);
+    if(call_stack_pos > -1 && cur_frame) {
+      StackFrame** call_stack = monitor->call_stack;
+      PushMarkTask(id++ % gc_num_workers, cur_frame->jit_mem ? MARK_JIT_FRAME : MARK_PDA_FRAME, cur_frame, 1);
+
+      while(--call_stack_pos > -1) {
+        StackFrame* frame = call_stack[call_stack_pos];
+        PushMarkTask(id++ % gc_num_workers, frame->jit_mem ? MARK_JIT_FRAME : MARK_PDA_FRAME, frame, 1);
+      }
+    }
+  }
+
+#ifndef _GC_SERIAL
+  MUTEX_UNLOCK(&pda_monitor_lock);
+#endif
+
+  // old objects may reference new ones, cards are scanned in word-aligned slices
+  if(gc_minor) {
+    const size_t num_cards = heap_chunks << (HEAP_CHUNK_SHIFT - HEAP_CARD_SHIFT);
+    size_t slice = num_cards / (gc_num_workers * GC_CARD_SLICES);
+    slice = (slice + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+    if(!slice) {
+      slice = sizeof(size_t);
+    }
+
+    for(size_t i = 0; i < num_cards; i += slice) {
+      const size_t count = num_cards - i < slice ? num_cards - i : slice;
+      PushMarkTask(id++ % gc_num_workers, MARK_CARDS, (void*)i, count);
+    }
+  }
+
+  StartMarkPhase();
+  WaitMarkPhase();
+}
+
+void MemoryManager::CheckStatic(StackClass** clss, size_t cls_num)
+{
+  for(size_t i = 0; i < cls_num; ++i) {
+    StackClass* cls = clss[i];
+    CheckMemory(cls->GetClassMemory(), cls->GetClassDeclarations(), cls->GetNumberClassDeclarations());
+  }
+}
+
+void MemoryManager::CheckStack(size_t* op_stack, size_t stack_size)
+{
+  for(size_t i = 0; i < stack_size; ++i) {
+    size_t* check_mem = (size_t*)op_stack[i];
+    if(IsHeapMemory(check_mem)) {
+      CheckObject(check_mem, false);
+    }
+  }
+}
+
+void MemoryManager::CheckJitFrame(StackFrame* frame)
+{
+  StackMethod* method = frame->method;
+  size_t* mem = frame->jit_mem;
+  size_t* self = (size_t*)frame->mem[0];
+  const long dclrs_num = method->GetNumberDeclarations();
+
+#ifdef _DEBUG_GC
+  std::wcout << L"\t===== JIT method: name=" << method->GetName() << L", id=" << method->GetClass()->GetId()
+    << L"," << method->GetId() << L"; addr=" << method << L"; mem=" << mem << L"; self=" << self
+    << L"; num=" << method->GetNumberDeclarations() << L" =====" << std::endl;
+#endif
+
+  if(mem) {
+#ifdef _ARM64
+    size_t* start = mem - 1;
+#endif
+    
+    // check self
+    if(!method->IsLambda()) {
+      CheckObject(self, true);
+    }
+
+    StackDclr** dclrs = method->GetDeclarations();
+#ifdef _ARM64
+    // front to back...
+    if(method->HasAndOr()) {
+      mem++;
+    }
+    
+    for(int j = 0; j < dclrs_num; ++j) {
+#else
+    // front to back...
+    for(int j = dclrs_num - 1; j > -1; --j) {
+#endif
+      // update address based upon type
+      switch(dclrs[j]->type) {
+      case FUNC_PARM: {
+        size_t* lambda_mem = (size_t*) * (mem + 1);
+        const size_t mthd_cls_id = *mem;
+        const long virtual_cls_id = (mthd_cls_id >> (16 * (1))) & 0xFFFF;
+        const long mthd_id = (mthd_cls_id >> (16 * (0))) & 0xFFFF;
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": FUNC_PARM: id=(" << virtual_cls_id << L"," << mthd_id << L"), mem=" << lambda_mem << std::endl;
+#endif
+        std::pair<int, StackDclr**> closure_dclrs = prgm->GetClass(virtual_cls_id)->GetClosureDeclarations(mthd_id);
+        if(MarkMemory(lambda_mem)) {
+          PushMarkStack(MARK_MEMORY, lambda_mem, closure_dclrs.first, closure_dclrs.second);
+        }
+        // update
+        mem += 2;
+      }
+        break;
+
+      case CHAR_PARM:
+      case INT_PARM:
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": CHAR_PARM/INT_PARM: value=" << (*mem) << std::endl;
+#endif
+        // update
+        mem++;
+        break;
+
+      case FLOAT_PARM: {
+#ifdef _DEBUG_GC
+        FLOAT_VALUE value;
+        memcpy(&value, mem, sizeof(FLOAT_VALUE));
+        std::wcout << L"\t" << j << L": FLOAT_PARM: value=" << value << std::endl;
+#endif
+        // update
+        mem++;
+      }
+        break;
+
+      case BYTE_ARY_PARM:
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": BYTE_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
+          << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
+          << L" byte(s)" << std::endl;
+#endif
+        // mark data
+        MarkMemory((size_t*)(*mem));
+        // update
+        mem++;
+        break;
+
+      case CHAR_ARY_PARM:
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": CHAR_ARY_PARM: addr=" << (size_t*)(*mem) << L"(" << (size_t)(*mem)
+          << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
+          << L" byte(s)" << std::endl;
+#endif
+        // mark data
+        MarkMemory((size_t*)(*mem));
+        // update
+        mem++;
+        break;
+
+      case INT_ARY_PARM:
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": INT_ARY_PARM: addr=" << (size_t*)(*mem)
+          << L"(" << (size_t)(*mem) << L"), size="
+          << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
+          << L" byte(s)" << std::endl;
+#endif
+        // mark data
+        MarkMemory((size_t*)(*mem));
+        // update
+        mem++;
+        break;
+
+      case FLOAT_ARY_PARM:
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": FLOAT_ARY_PARM: addr=" << (size_t*)(*mem)
+          << L"(" << (size_t)(*mem) << L"), size=" << L" byte(s)"
+          << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) << std::endl;
+#endif
+        // mark data
+        MarkMemory((size_t*)(*mem));
+        // update
+        mem++;
+        break;
+
+      case OBJ_PARM: {
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": OBJ_PARM: addr=" << (size_t*)(*mem)
+          << L"(" << (size_t)(*mem) << L"), id=";
+        if(*mem) {
+          StackClass* tmp = (StackClass*)((size_t*)(*mem))[SIZE_OR_CLS];
+          std::wcout << L"'" << tmp->GetName() << L"'" << std::endl;
+        }
+        else {
+          std::wcout << L"Unknown" << std::endl;
+        }
+#endif
+        // check object
+        CheckObject((size_t*)(*mem), true);
+        // update
+        mem++;
+      }
+        break;
+
+      case OBJ_ARY_PARM:
+#ifdef _DEBUG_GC
+        std::wcout << L"\t" << j << L": OBJ_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
+          << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
+          << L" byte(s)" << std::endl;
+#endif
+        // mark data
+        if(MarkValidMemory((size_t*)(*mem))) {
+          size_t* array = (size_t*)(*mem);
+          const size_t size = array[0];
+          const size_t dim = array[1];
+          size_t* objects = (size_t*)(array + 2 + dim);
+          CheckArray(objects, size);
+        }
+        // update
+        mem++;
+        break;
+
+      default:
+        break;
+      }
+    }
+
+    // NOTE: this marks temporary variables that are stored in JIT memory
+    // during some method calls. There are 6 integer temp addresses
+    // TODO: for non-ARM64 targets, skip 'has_and_or' variable addressed
+#ifdef _ARM32
+    // for ARM32, skip the link register
+    for(int i = 1; i <= 6; ++i) {
+#elif _ARM64
+    mem = start;
+    for(int i = 0; i > -6; --i) {
+#else
+    for(int i = 0; i < 6; ++i) {
+#endif
+      size_t* check_mem = (size_t*)mem[i];
+      if(IsHeapMemory(check_mem)) {
+        CheckObject(check_mem, false);
+      }
+    }
+  }
+#ifdef _DEBUG_GC
+  else {
+    std::wcout << L"\t\t--- Nil memory ---" << std::endl;
+  }
+#endif
+}
+
+void MemoryManager::CheckPdaFrame(StackFrame* frame)
+{
+  StackMethod* method = frame->method;
+  size_t* mem = frame->mem;
+
+#ifdef _DEBUG_GC
+  std::wcout << L"\t===== PDA method: name=" << method->GetName() << L", addr="
+    << method << L", num=" << method->GetNumberDeclarations() << L" =====" << std::endl;
+#endif
+
+  // mark self
+  if(!method->IsLambda()) {
+    CheckObject((size_t*)(*mem), true);
+  }
+
+  if(method->HasAndOr()) {
+    mem += 2;
+  }
+  else {
+    mem++;
+  }
+
+  // mark rest of memory
+  CheckMemory(mem, method->GetDeclarations(), method->GetNumberDeclarations());
+}
+
+//
+// queues array elements, large arrays are queued in slices that can be
+// shared with idle collector threads
+//
+void MemoryManager::CheckArray(size_t* objects, size_t size)
+{
+  while(size > GC_ARRAY_SLICE) {
+    size -= GC_ARRAY_SLICE;
+    PushMarkStack(MARK_ARRAY, objects + size, GC_ARRAY_SLICE, nullptr);
+  }
+
+  if(size) {
+    PushMarkStack(MARK_ARRAY, objects, size, nullptr);
+  }
+}
+
+void MemoryManager::ScanArray(size_t* objects, size_t size)
+{
+  for(size_t i = 0; i < size; ++i) {
+    CheckObject((size_t*)objects[i], false);
+  }
+}
+
+//
+// checks a block of declared variables, referenced memory is marked and
+// queued on the mark stack rather than traced recursively
+//
+void MemoryManager::CheckMemory(size_t* mem, StackDclr** dclrs, const long dcls_size)
+{
+  // check method
+  for(long i = 0; i < dcls_size; ++i) {
+    // update address based upon type
+    switch(dclrs[i]->type) {
+    case FUNC_PARM: {
+      size_t* lambda_mem = (size_t*) * (mem + 1);
+      const size_t mthd_cls_id = *mem;
+      const long virtual_cls_id = (mthd_cls_id >> (16 * (1))) & 0xFFFF;
+      const long mthd_id = (mthd_cls_id >> (16 * (0))) & 0xFFFF;
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": FUNC_PARM: id=(" << virtual_cls_id << L"," << mthd_id << L"), mem=" << lambda_mem << std::endl;
+#endif
+      std::pair<int, StackDclr**> closure_dclrs = prgm->GetClass(virtual_cls_id)->GetClosureDeclarations(mthd_id);
+      if(MarkMemory(lambda_mem)) {
+        PushMarkStack(MARK_MEMORY, lambda_mem, closure_dclrs.first, closure_dclrs.second);
+      }
+      // update
+      mem += 2;
+    }
+      break;
+
+  case CHAR_PARM:
+    case INT_PARM:
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": CHAR_PARM/INT_PARM: value=" << (*mem) << std::endl;
+#endif
+      // update
+      mem++;
+      break;
+
+    case FLOAT_PARM: {
+#ifdef _DEBUG_GC
+      FLOAT_VALUE value;
+      memcpy(&value, mem, sizeof(FLOAT_VALUE));
+      std::wcout << L"\t" << i << L": FLOAT_PARM: value=" << value << std::endl;
+#endif
+      // update
+      mem++;
+    }
+      break;
+
+    case BYTE_ARY_PARM:
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": BYTE_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
+            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
+            << L" byte(s)" << std::endl;
+#endif
+      // mark data
+      MarkMemory((size_t*)(*mem));
+      // update
+      mem++;
+      break;
+
+    case CHAR_ARY_PARM:
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": CHAR_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
+            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) 
+            << L" byte(s)" << std::endl;
+#endif
+      // mark data
+      MarkMemory((size_t*)(*mem));
+      // update
+      mem++;
+      break;
+
+    case INT_ARY_PARM:
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": INT_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
+            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) 
+            << L" byte(s)" << std::endl;
+#endif
+      // mark data
+      MarkMemory((size_t*)(*mem));
+      // update
+      mem++;
+      break;
+
+    case FLOAT_ARY_PARM:
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": FLOAT_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
+            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0) 
+            << L" byte(s)" << std::endl;
+#endif
+      // mark data
+      MarkMemory((size_t*)(*mem));
+      // update
+      mem++;
+      break;
+
+    case OBJ_PARM: {
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": OBJ_PARM: addr=" << (size_t*)(*mem) << L"(" << (size_t)(*mem) << L"), id=";
+      if(*mem) {
+        StackClass* tmp = (StackClass*)((size_t*)(*mem))[SIZE_OR_CLS];
+        std::wcout << L"'" << tmp->GetName() << L"'" << std::endl;
+      }
+      else {
+        std::wcout << L"Unknown" << std::endl;
+      }
+#endif
+      // check object
+      CheckObject((size_t*)(*mem), true);
+      // update
+      mem++;
+    }
+      break;
+
+    case OBJ_ARY_PARM:
+#ifdef _DEBUG_GC
+      std::wcout << L"\t" << i << L": OBJ_ARY_PARM: addr=" << (size_t*)(*mem) << L"("
+            << (size_t)(*mem) << L"), size=" << ((*mem) ? ((size_t*)(*mem))[SIZE_OR_CLS] : 0)
+            << L" byte(s)" << std::endl;
+#endif
+      // mark data
+      if(MarkValidMemory((size_t*)(*mem))) {
+        size_t* array = (size_t*)(*mem);
+        const size_t size = array[0];
+        const size_t dim = array[1];
+        size_t* objects = (size_t*)(array + 2 + dim);
+        CheckArray(objects, size);
+      }
+      // update
+      mem++;
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+void MemoryManager::CheckObject(size_t* mem, bool is_obj)
+{
+  if(IsHeapMemory(mem)) {
+    StackClass* cls;
+    if(is_obj) {
+      cls = GetClass(mem);
+    }
+    else {
+      cls = GetClassMapping(mem);
+    }
+
+    if(cls) {
+#ifdef _DEBUG_GC
+      std::wcout << L"\t----- object: addr=" << mem << L"(" << (size_t)mem << L"), name='"
+            << cls->GetName() << L"', num=" << cls->GetNumberInstanceDeclarations() << L" -----" << std::endl;
+#endif
+
+      // mark data, fields are checked from the mark stack
+      if(MarkMemory(mem)) {
+        PushMarkStack(MARK_MEMORY, mem, cls->GetNumberInstanceDeclarations(), cls->GetInstanceDeclarations());
+      }
+    } 
+    else {
+      // NOTE: this happens when we are trying to mark unidentified memory
+      // segments. these segments may be parts of that stack or temp for
+      // register variables
+#ifdef _DEBUG_GC
+      std::wcout <<"$: addr/value=" << mem << std::endl;
+      if(is_obj) {
+        assert(cls);
+      }
+#endif
+      // primitive or object array
+      if(MarkValidMemory(mem)) {
+        // ensure we're only checking int and obj arrays
+        if(mem[TYPE] == NIL_TYPE || mem[TYPE] == INT_TYPE) {
+            size_t* array = mem;
+            const size_t size = array[0];
+            const size_t dim = array[1];
+            size_t* objects = (size_t*)(array + 2 + dim);
+            CheckArray(objects, size);
+        }
+      }
+    }
+  }
+}
@@ -1,261 +1,709 @@
-/***************************************************************************
- * Implements a caching "mark and sweep" collector
- *
- * Copyright (c) 2023, Randy Hollines
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions are met:
- *
- * - Redistributions of source code must retain the above copyright
- * notice, this list of conditions and the following disclaimer.
- * - Redistributions in binary form must reproduce the above copyright
- * notice, this list of conditions and the following disclaimer in
- * the documentation and/or other materials provided with the distribution.
- * - Neither the name of the Objeck Team nor the names of its
- * contributors may be used to endorse or promote products derived
- * from this software without specific prior written permission.
- *
- * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
- * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
- * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
- * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
- * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
- * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
- * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
- *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
- * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
- * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
- * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- ***************************************************************************/
-
-#ifndef __MEM_MGR_H__
-#define __MEM_MGR_H__
-
-#include "../common.h"
-
-// basic VM tuning parameters
-
-/* FOR DEBUGGING ONLY
-#define MEM_MAX 4096 * 2
-*/
-
-#define MEM_START_MAX 4096 * 512
-
-#define UNCOLLECTED_COUNT 11
-#define COLLECTED_COUNT 29
-
-#define EXTRA_BUF_SIZE 3
-#define MARKED_FLAG -1
-#define SIZE_OR_CLS -2
-#define TYPE -3
-
-struct StackOperMemory {
-  size_t* op_stack;
-  long* stack_pos;
-};
-
-// used to monitor the state of active stack frames
-struct StackFrameMonitor {
-  StackFrame** call_stack;
-  long* call_stack_pos;
-  StackFrame** cur_frame;
-};
-
-// holders
-struct CollectionInfo {
-  size_t* op_stack;
-  long stack_pos;
-};
-
-struct ClassMethodId {
-  size_t* self;
-  size_t* mem;
-  long cls_id;
-  long mthd_id;
-};
-
-class MemoryManager {
-  static bool initialized;
-  static StackProgram* prgm;
-  static std::unordered_set<StackFrameMonitor*> pda_monitors; // deleted elsewhere
-  static std::unordered_set<StackFrame**> pda_frames;
-  static std::vector<StackFrame*> jit_frames; // deleted elsewhere
-  static std::set<size_t*> allocated_memory;
-  static std::unordered_map<size_t, std::list<size_t*>*> free_memory_cache;
-  static size_t free_memory_cache_size;
-  
-#ifdef _WIN32
-  static CRITICAL_SECTION jit_frame_lock;
-  static CRITICAL_SECTION pda_frame_lock;
-  static CRITICAL_SECTION pda_monitor_lock;
-  static CRITICAL_SECTION allocated_lock;
-  static CRITICAL_SECTION marked_lock;
-  static CRITICAL_SECTION marked_sweep_lock;
-  static CRITICAL_SECTION free_memory_cache_lock;
-#else
-  static pthread_mutex_t pda_monitor_lock;
-  static pthread_mutex_t pda_frame_lock;
-  static pthread_mutex_t jit_frame_lock;
-  static pthread_mutex_t allocated_lock;
-  static pthread_mutex_t marked_lock;
-  static pthread_mutex_t marked_sweep_lock;
-	static pthread_mutex_t free_memory_cache_lock;
-#endif
-    
-  // note: protected by 'allocated_lock'
-  static size_t allocation_size;
-  static size_t mem_max_size;
-  static size_t uncollected_count;
-  static size_t collected_count;
-
-  // if return true, trace memory otherwise do not
-  static inline bool MarkMemory(size_t* mem);
-  static inline bool MarkValidMemory(size_t* mem);
-
-#ifdef _MEM_LOGGING
-  static ofstream mem_logger;
-  static long mem_cycle;
-#endif
-  
-#ifdef _WIN32
-  // mark memory
-  static unsigned int WINAPI CheckStatic(LPVOID arg);
-  static unsigned int WINAPI CheckStack(LPVOID arg);
-  static unsigned int WINAPI CheckPdaRoots(LPVOID arg);
-  static unsigned int WINAPI CheckJitRoots(LPVOID arg);
-  
-  // recover memory
-  static void CollectAllMemory(size_t* op_stack, long stack_pos);
-  static unsigned int WINAPI CollectMemory(LPVOID arg);
-#else  
-  // mark memory
-  static void* CheckStatic(void* arg);
-  static void* CheckStack(void* arg);
-  static void* CheckPdaRoots(void* arg);
-  static void* CheckJitRoots(void* arg);
-  // recover memory
-  static void CollectAllMemory(size_t* op_stack, long stack_pos);
-  static void* CollectMemory(void* arg);
-#endif
-
-  static inline StackClass* GetClassMapping(size_t* mem) {
-    if(!mem) {
-      return nullptr;
-    }
-
-#ifndef _GC_SERIAL
-    MUTEX_LOCK(&allocated_lock);
-#endif
-    std::set<size_t*>::iterator found = allocated_memory.find(mem);
-    if(found != allocated_memory.end() && mem[TYPE] == instructions::MemoryType::NIL_TYPE) {
-#ifndef _GC_SERIAL
-      MUTEX_UNLOCK(&allocated_lock);
-#endif
-      return (StackClass*)mem[SIZE_OR_CLS];
-    }
-#ifndef _GC_SERIAL
-    MUTEX_UNLOCK(&allocated_lock);
-#endif
-    
-    return nullptr;
-  }
-
-  static size_t* GetMemory(size_t alloc_size);
-  static void AddFreeMemory(size_t* raw_mem);
-  void static inline AddFreeCache(size_t pool, size_t* raw_mem);
-  static size_t* GetFreeMemory(size_t size);
-  static size_t AlignMemorySize(size_t size);
-  static void ClearFreeMemory(size_t* op_stack = nullptr, long stack_pos = 0, bool all = false);
-  
- public:
-  static void Initialize(StackProgram* p);
-
-  static void Clear(size_t* op_stack, long stack_pos) {
-#ifdef _MEM_LOGGING
-    mem_logger.close();
-#endif
-
-    if(!free_memory_cache.empty()) {
-      ClearFreeMemory(op_stack, stack_pos, true);
-      free_memory_cache.clear();
-    }
-
-    for(std::set<size_t*>::iterator iter = allocated_memory.begin(); iter != allocated_memory.end(); ++iter) {
-      size_t* mem = *iter;
-      mem -= EXTRA_BUF_SIZE + 1;
-      free(mem);
-      mem = nullptr;
-    }
-    allocated_memory.clear();
-
-#ifdef _WIN32
-    DeleteCriticalSection(&jit_frame_lock);
-    DeleteCriticalSection(&pda_monitor_lock);
-    DeleteCriticalSection(&allocated_lock);
-    DeleteCriticalSection(&marked_lock);
-    DeleteCriticalSection(&marked_sweep_lock);
-    DeleteCriticalSection(&free_memory_cache_lock);
-#endif
-      
-    initialized = false;
-  }
-  
-  // add and remove pda roots
-  static void AddPdaMethodRoot(StackFrame** frame);
-  static void RemovePdaMethodRoot(StackFrame** frame);
-  static void AddPdaMethodRoot(StackFrameMonitor* monitor);  
-  static void RemovePdaMethodRoot(StackFrameMonitor* monitor);
-  
-  static void CheckMemory(size_t* mem, StackDclr** dclrs, const long dcls_size, const long depth);
-  static void CheckObject(size_t* mem, bool is_obj, const long depth);
-  
-  static size_t* AllocateObject(const wchar_t* obj_name, size_t* op_stack, long stack_pos, bool collect = true) {
-    StackClass* cls = prgm->GetClass(obj_name);
-    if(cls) {
-      return AllocateObject(cls->GetId(), op_stack, stack_pos, collect);
-    }
-    
-    return nullptr;
-  }
-  
-  static size_t* AllocateObject(const long obj_id, size_t* op_stack, long stack_pos, bool collect = true);
-  static size_t* AllocateArray(const size_t size, const MemoryType type, size_t* op_stack, long stack_pos, bool collect = true);
-  
-  // object verification
-  static size_t* ValidObjectCast(size_t* mem, long to_id, long* cls_hierarchy, long** cls_interfaces);
-  
-  //
-  // returns the class reference for an object instance
-  //
-  static inline StackClass* GetClass(size_t* mem) {
-    if(mem && mem[TYPE] == instructions::MemoryType::NIL_TYPE) {
-      return (StackClass*)mem[SIZE_OR_CLS];
-    }
-    return nullptr;
-  }
-
-  //
-  // returns a unique object id for an instance
-  //
-  static inline long GetObjectID(size_t* mem) {
-    StackClass* klass = GetClass(mem);
-    if(klass) {
-      return klass->GetId();
-    }
-    
-    return -1;
-  }
-
-#ifdef _DEBUGGER
-  static size_t GetAllocationSize() {
-    return allocation_size;
-  }
-
-  static size_t GetMaxMemory() {
-    return mem_max_size;
-  }
-#endif
-};
-
-#endif
+/***************************************************************************
+ * Implements a caching "mark and sweep" collector
+ *
+ * Copyright (c) 2023, Randy Hollines
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in
+ * the documentation and/or other materials provided with the distribution.
+ * - Neither the name of the Objeck Team nor the names of its
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef __MEM_MGR_H__
+#define __MEM_MGR_H__
+
+#include "../common.h"
+#include <atomic>
+#include <deque>
+#include <chrono>
+
+// basic VM tuning parameters
+
+/* FOR DEBUGGING ONLY
+#define MEM_MAX 4096 * 2
+*/
+
+#define MEM_START_MAX 4096 * 512
+
+#define UNCOLLECTED_COUNT 11
+#define COLLECTED_COUNT 29
+
+// block header: type and size (or class) precede the payload
+#define EXTRA_BUF_SIZE 2
+#define SIZE_OR_CLS -1
+#define TYPE -2
+
+// heap layout: a single reserved address range carved into fixed-size
+// chunks. every chunk holds blocks of one size class and is described
+// by a side-table entry holding its allocation and mark bitmaps.
+#define HEAP_CHUNK_SHIFT 18
+#define HEAP_CHUNK_SIZE ((size_t)1 << HEAP_CHUNK_SHIFT)
+#define HEAP_MIN_BLOCK 16
+#define HEAP_MAX_BLOCK (HEAP_CHUNK_SIZE >> 1)
+#define HEAP_BITS (sizeof(size_t) * 8)
+#define HEAP_BITMAP_WORDS (HEAP_CHUNK_SIZE / HEAP_MIN_BLOCK / HEAP_BITS)
+#define HEAP_RESERVE_SIZE ((size_t)32 << 30)
+#define HEAP_MIN_RESERVE_SIZE ((size_t)256 << 20)
+
+// size classes: 16-byte steps up to HEAP_SMALL_BLOCK, four classes per
+// doubling up to HEAP_MEDIUM_BLOCK, then powers of two. larger classes
+// are coarse so the unused tail of a chunk stays small.
+#define HEAP_SMALL_BLOCK 256
+#define HEAP_SMALL_CLASSES (HEAP_SMALL_BLOCK / HEAP_MIN_BLOCK)
+#define HEAP_MEDIUM_BLOCK 8192
+#define HEAP_MEDIUM_CLASSES 20
+#define HEAP_NUM_CLASSES (HEAP_SMALL_CLASSES + HEAP_MEDIUM_CLASSES + 4)
+
+// lazy sweeping: a collection only queues chunks, they are swept by
+// allocating threads on demand or before the next marking. chunks that
+// are still empty by then are returned to the operating system.
+
+// generational mode: a card table with one byte per card is dirtied by
+// the write barrier, minor collections rescan dirty cards. after
+// GC_MINOR_MAX minor collections a full collection is run.
+#define HEAP_CARD_SHIFT 9
+#define HEAP_CARD_SIZE ((size_t)1 << HEAP_CARD_SHIFT)
+#define GC_MINOR_MAX 16
+
+// parallel marking: a long-lived pool of collector threads, each owning
+// a deque of mark tasks. workers pop from the back of their own deque
+// and steal from the front of others once it is empty.
+#define GC_MAX_WORKERS 32
+#define GC_CLASS_SLICE 32
+#define GC_STACK_SLICE 64
+#define GC_ARRAY_SLICE 1024
+#define GC_CARD_SLICES 4
+
+// concurrent marking: collector threads trace from a snapshot taken in a
+// short pause while program threads keep running. references about to be
+// overwritten are recorded by a snapshot-at-the-beginning barrier and
+// traced in a final pause. allocating threads wait for marking once
+// allocations reach GC_CONCURRENT_LIMIT times the collection threshold.
+#define GC_CONCURRENT_LIMIT 2
+
+// telemetry: pause times are counted in power-of-two microsecond buckets,
+// the last bucket holds pauses of GC_PAUSE_BUCKETS - 1 or more doublings
+#define GC_PAUSE_BUCKETS 24
+
+// statistic ids, read by programs through the GC_STAT trap. pause
+// histogram buckets follow GC_STAT_PAUSE_HISTOGRAM.
+enum GcStatistic {
+  GC_STAT_COLLECTIONS = 0,
+  GC_STAT_PAUSES,
+  GC_STAT_PAUSE_TOTAL,
+  GC_STAT_PAUSE_MAX,
+  GC_STAT_LIVE_BYTES,
+  GC_STAT_HEAP_SIZE,
+  GC_STAT_MAX_SIZE,
+  GC_STAT_MAX_SIZE_CHANGES,
+  GC_STAT_ALLOCATED,
+  GC_STAT_THREAD_ALLOCATED,
+  GC_STAT_FREE_CACHE,
+  GC_STAT_RELEASED_CHUNKS,
+  GC_STAT_PAUSE_BUCKETS,
+  GC_STAT_PAUSE_HISTOGRAM
+};
+
+struct StackOperMemory {
+  size_t* op_stack;
+  long* stack_pos;
+};
+
+// used to monitor the state of active stack frames
+struct StackFrameMonitor {
+  StackFrame** call_stack;
+  long* call_stack_pos;
+  StackFrame** cur_frame;
+};
+
+// holders
+struct CollectionInfo {
+  size_t* op_stack;
+  long stack_pos;
+};
+
+// safepoints: threads running program code poll a flag at backward
+// jumps and calls, and park while the collector marks and sweeps.
+// threads blocked in the runtime (sleeping, joining, locking or reading)
+// count as stopped. operand stack slots just above the recorded top are
+// also checked, covering values popped by the blocked operation.
+#define SAFEPOINT_STACK_SLACK 8
+
+enum MutatorState {
+  MUTATOR_RUNNING = 0,
+  MUTATOR_PARKED,
+  MUTATOR_BLOCKED
+};
+
+struct MutatorThread {
+  size_t* op_stack;
+  long* stack_pos;
+  long stack_size;
+  long park_pos;
+  MutatorState state;
+  std::vector<size_t> satb_buffer;
+};
+
+// unit of marking work
+enum MarkTaskType {
+  MARK_STATIC = 0,
+  MARK_STACK,
+  MARK_PDA_FRAME,
+  MARK_JIT_FRAME,
+  MARK_ARRAY,
+  MARK_CARDS,
+  MARK_MEMORY
+};
+
+// memory and declarations are set for MARK_MEMORY
+struct MarkTask {
+  MarkTaskType type;
+  void* data;
+  size_t size;
+  StackDclr** dclrs;
+};
+
+struct MarkDeque {
+  std::deque<MarkTask> tasks;
+  std::atomic<size_t> count;
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+#else
+  pthread_mutex_t lock;
+#endif
+};
+
+// side-table entry for a heap chunk. large blocks span several
+// chunks; the trailing chunks map to the entry of the first.
+struct HeapChunk {
+  char* base;
+  size_t block_size;
+  size_t num_blocks;
+  size_t span;
+  size_t live_blocks;
+  size_t next_block;
+  size_t dirty_bytes;
+  size_t sweep_cycle;
+  int size_class;
+  bool is_owned;
+  std::atomic<size_t> alloc_bits[HEAP_BITMAP_WORDS];
+  std::atomic<size_t> mark_bits[HEAP_BITMAP_WORDS];
+};
+
+// thread-local allocation buffer: a run of free blocks within a chunk
+// owned by one thread, allocated from by bumping an index
+struct AllocationBuffer {
+  HeapChunk* chunk;
+  size_t next_block;
+  size_t end_block;
+  size_t allocations;
+  size_t requested_bytes;
+};
+
+// per size class counters, requested bytes against allocated blocks
+// shows how well requests fit the class
+struct SizeClassStats {
+  size_t block_size;
+  size_t allocations;
+  size_t requested_bytes;
+  size_t chunks;
+};
+
+struct ThreadAllocationBuffers {
+  AllocationBuffer buffers[HEAP_NUM_CLASSES];
+  size_t allocated;
+  size_t total_allocated;
+  size_t gc_cycle;
+  
+  ~ThreadAllocationBuffers();
+};
+
+struct ClassMethodId {
+  size_t* self;
+  size_t* mem;
+  long cls_id;
+  long mthd_id;
+};
+
+class MemoryManager {
+  static bool initialized;
+  static StackProgram* prgm;
+  static std::unordered_set<StackFrameMonitor*> pda_monitors; // deleted elsewhere
+  static std::unordered_set<StackFrame**> pda_frames;
+
+  // chunked heap, indexed by (address - heap_base) >> HEAP_CHUNK_SHIFT
+  static char* heap_base;
+  static size_t heap_chunks;
+  static size_t heap_max_chunks;
+  static HeapChunk** chunk_table;
+  static unsigned char* chunk_dirty;
+  static std::vector<size_t> free_chunks;
+  static std::vector<HeapChunk*> class_chunks[HEAP_NUM_CLASSES];
+  static SizeClassStats class_stats[HEAP_NUM_CLASSES];
+  static thread_local ThreadAllocationBuffers alloc_buffers;
+  static std::atomic<bool> gc_active;
+  static size_t gc_cycle;
+  static std::atomic<size_t> gc_marked_bytes;
+  static thread_local size_t mark_bytes;
+  static size_t gc_live_bytes;
+
+  // generational collection, mark bits are sticky between minor collections
+  static bool gc_generational;
+  static bool gc_minor;
+  static size_t gc_minor_count;
+  static unsigned char* card_table;
+  static size_t card_bias;
+
+  // collector thread pool, phases are started by the collecting thread
+  static int gc_num_workers;
+  static MarkDeque* mark_deques;
+  static thread_local int gc_worker_id;
+  static thread_local std::deque<MarkTask> mark_stack;
+  static std::atomic<int> gc_idle_workers;
+  static size_t gc_phase;
+  static std::atomic<int> gc_running_workers;
+  static bool gc_workers_exit;
+
+  // concurrent marking, the snapshot barrier is enabled while 'gc_marking' is set
+  static bool gc_concurrent;
+  static bool gc_roots_only;
+  static std::atomic<bool> gc_marking;
+  static std::vector<size_t> satb_queue;
+
+  // stop-the-world safepoints, thread states are protected by 'safepoint_lock'
+  static std::atomic<bool> safepoint_requested;
+  static std::unordered_set<MutatorThread*> mutators;
+  static thread_local MutatorThread* mutator;
+  static long running_mutators;
+
+  // allocation buffer counters
+  static size_t buffer_refills;
+  static std::atomic<size_t> buffer_lock_contention;
+  static size_t released_chunks;
+
+  // telemetry
+  static size_t gc_collections;
+  static size_t gc_pauses;
+  static size_t gc_pause_total;
+  static size_t gc_pause_max;
+  static size_t gc_pause_histogram[GC_PAUSE_BUCKETS];
+  static size_t gc_max_size_changes;
+  static size_t allocated_bytes;
+  static std::ofstream gc_log;
+  static std::chrono::steady_clock::time_point gc_start_time;
+  
+#ifdef _WIN32
+  static CRITICAL_SECTION pda_frame_lock;
+  static CRITICAL_SECTION pda_monitor_lock;
+  static CRITICAL_SECTION allocated_lock;
+  static CRITICAL_SECTION marked_sweep_lock;
+  static CRITICAL_SECTION gc_pool_lock;
+  static CONDITION_VARIABLE gc_pool_start;
+  static CONDITION_VARIABLE gc_pool_done;
+  static std::vector<HANDLE> gc_workers;
+  static CRITICAL_SECTION safepoint_lock;
+  static CONDITION_VARIABLE safepoint_parked;
+  static CONDITION_VARIABLE safepoint_resume;
+  static CRITICAL_SECTION satb_lock;
+#else
+  static pthread_mutex_t pda_monitor_lock;
+  static pthread_mutex_t pda_frame_lock;
+  static pthread_mutex_t allocated_lock;
+  static pthread_mutex_t marked_sweep_lock;
+  static pthread_mutex_t gc_pool_lock;
+  static pthread_cond_t gc_pool_start;
+  static pthread_cond_t gc_pool_done;
+  static std::vector<pthread_t> gc_workers;
+  static pthread_mutex_t safepoint_lock;
+  static pthread_cond_t safepoint_parked;
+  static pthread_cond_t safepoint_resume;
+  static pthread_mutex_t satb_lock;
+#endif
+    
+  // note: protected by 'allocated_lock'
+  static size_t allocation_size;
+  static size_t mem_max_size;
+  static size_t uncollected_count;
+  static size_t collected_count;
+
+  // if return true, trace memory otherwise do not
+  static inline bool MarkMemory(size_t* mem);
+  static inline bool MarkValidMemory(size_t* mem);
+
+#ifdef _MEM_LOGGING
+  static ofstream mem_logger;
+  static long mem_cycle;
+#endif
+  
+  // safepoints
+  static void StopMutators(long stack_pos);
+  static void ResumeMutators();
+  static void ParkMutator(long stack_pos);
+  static void CheckMutators();
+
+  // collector threads
+  static void StartMarkWorkers();
+  static void StopMarkWorkers();
+#ifdef _WIN32
+  static unsigned int WINAPI MarkWorker(LPVOID arg);
+#else
+  static void* MarkWorker(void* arg);
+#endif
+
+  // mark tasks
+  static void PushMarkTask(int id, MarkTaskType type, void* data, size_t size, StackDclr** dclrs = nullptr);
+  static bool PopMarkTask(int id, MarkTask &task);
+  static bool StealMarkTask(int id, MarkTask &task);
+  static bool HasMarkTasks();
+  static void StartMarkPhase();
+  static void WaitMarkPhase();
+  static void RunMarkTasks(int id);
+  static void RunMarkTask(const MarkTask &task);
+  static void DrainMarkStack();
+
+  // queues marked memory to be traced by the current thread
+  static inline void PushMarkStack(MarkTaskType type, void* data, size_t size, StackDclr** dclrs) {
+    const MarkTask task = { type, data, size, dclrs };
+    mark_stack.push_back(task);
+  }
+
+  // mark memory
+  static void CheckRoots(CollectionInfo* info);
+  static void CheckStatic(StackClass** clss, size_t cls_num);
+  static void CheckStack(size_t* op_stack, size_t stack_size);
+  static void CheckPdaFrame(StackFrame* frame);
+  static void CheckJitFrame(StackFrame* frame);
+  static void CheckArray(size_t* objects, size_t size);
+  static void ScanArray(size_t* objects, size_t size);
+
+  // concurrent marking
+  static void StartConcurrentMark(CollectionInfo* info);
+  static void FinishConcurrentMark();
+  static void CheckSatbBuffers();
+
+  // recover memory
+  static void CollectAllMemory(size_t* op_stack, long stack_pos);
+  static void CollectMemory(CollectionInfo* info);
+  static void SweepMemory();
+  static void RecordPause(const std::chrono::steady_clock::time_point &start, const char* type);
+
+  static inline size_t BitScan(size_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+  }
+
+  static inline size_t BitScanReverse(size_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, bits);
+    return index;
+#else
+    return HEAP_BITS - 1 - __builtin_clzll(bits);
+#endif
+  }
+
+  static inline size_t BitCount(size_t bits) {
+#ifdef _MSC_VER
+    return __popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
+  }
+
+  //
+  // maps an address to its chunk if it is the start of an allocated block
+  //
+  static inline HeapChunk* FindChunk(size_t* mem, size_t &index) {
+    const char* addr = (const char*)mem;
+    if(addr < heap_base || addr >= heap_base + (heap_chunks << HEAP_CHUNK_SHIFT)) {
+      return nullptr;
+    }
+
+    HeapChunk* chunk = chunk_table[(addr - heap_base) >> HEAP_CHUNK_SHIFT];
+    if(!chunk) {
+      return nullptr;
+    }
+
+    const size_t offset = addr - chunk->base - EXTRA_BUF_SIZE * sizeof(size_t);
+    if(offset % chunk->block_size) {
+      return nullptr;
+    }
+
+    index = offset / chunk->block_size;
+    if(index >= chunk->num_blocks || 
+       !(chunk->alloc_bits[index / HEAP_BITS].load(std::memory_order_relaxed) & ((size_t)1 << (index % HEAP_BITS)))) {
+      return nullptr;
+    }
+
+    return chunk;
+  }
+
+  static inline bool IsHeapMemory(size_t* mem) {
+    size_t index;
+    return FindChunk(mem, index) != nullptr;
+  }
+
+  static inline StackClass* GetClassMapping(size_t* mem) {
+    if(IsHeapMemory(mem) && mem[TYPE] == instructions::MemoryType::NIL_TYPE) {
+      return (StackClass*)mem[SIZE_OR_CLS];
+    }
+    
+    return nullptr;
+  }
+
+  // heap management
+  static void InitializeHeap();
+  static void ReleaseHeap();
+  static HeapChunk* NewChunk(const size_t span, const size_t block_size, const int size_class);
+  static void FreeChunk(HeapChunk* chunk);
+  static inline bool NextFreeRun(HeapChunk* chunk, size_t &start, size_t &end);
+  static void FillAllocationBuffer(AllocationBuffer &buffer, const int size_class);
+  static void ReleaseAllocationBuffer(AllocationBuffer &buffer);
+  static void LockAllocationBuffers();
+  static size_t* GetMemory(size_t size);
+  static size_t* GetLargeMemory(size_t size);
+  static void SweepChunk(HeapChunk* chunk);
+  static void FinishSweep();
+  static void ReleaseChunks();
+  static inline int SizeClass(size_t size);
+  static size_t ClassBlockSize(const int size_class);
+
+  // generational collection
+  static void ClearMarks();
+  static void ClearCards();
+  static void CheckCards(size_t start, size_t end);
+  static void CheckCardBlock(size_t* mem, const char* card_start, const char* card_end);
+  
+  static inline void MarkCards(const char* start, const char* end) {
+    const size_t first = (start - heap_base) >> HEAP_CARD_SHIFT;
+    const size_t last = (end - 1 - heap_base) >> HEAP_CARD_SHIFT;
+    memset(card_table + first, 1, last - first + 1);
+  }
+  
+ public:
+  static void Initialize(StackProgram* p);
+
+  static void Clear(size_t* op_stack, long stack_pos) {
+#ifdef _MEM_LOGGING
+    mem_logger.close();
+#endif
+
+    StopMarkWorkers();
+    ReleaseHeap();
+
+    if(gc_log.is_open()) {
+      gc_log.close();
+    }
+
+#ifdef _WIN32
+    DeleteCriticalSection(&pda_frame_lock);
+    DeleteCriticalSection(&pda_monitor_lock);
+    DeleteCriticalSection(&allocated_lock);
+    DeleteCriticalSection(&marked_sweep_lock);
+    DeleteCriticalSection(&gc_pool_lock);
+    DeleteCriticalSection(&safepoint_lock);
+    DeleteCriticalSection(&satb_lock);
+#endif
+      
+    initialized = false;
+  }
+  
+  // add and remove pda roots
+  static void AddPdaMethodRoot(StackFrame** frame);
+  static void RemovePdaMethodRoot(StackFrame** frame);
+  static void AddPdaMethodRoot(StackFrameMonitor* monitor);  
+  static void RemovePdaMethodRoot(StackFrameMonitor* monitor);
+  
+  static void CheckMemory(size_t* mem, StackDclr** dclrs, const long dcls_size);
+  static void CheckObject(size_t* mem, bool is_obj);
+  
+  static size_t* AllocateObject(const wchar_t* obj_name, size_t* op_stack, long stack_pos, bool collect = true) {
+    StackClass* cls = prgm->GetClass(obj_name);
+    if(cls) {
+      return AllocateObject(cls->GetId(), op_stack, stack_pos, collect);
+    }
+    
+    return nullptr;
+  }
+  
+  static size_t* AllocateObject(const long obj_id, size_t* op_stack, long stack_pos, bool collect = true);
+  static size_t* AllocateArray(const size_t size, const MemoryType type, size_t* op_stack, long stack_pos, bool collect = true);
+  
+  // object verification
+  static size_t* ValidObjectCast(size_t* mem, long to_id, long* cls_hierarchy, long** cls_interfaces);
+  
+  //
+  // returns the class reference for an object instance
+  //
+  static inline StackClass* GetClass(size_t* mem) {
+    if(mem && mem[TYPE] == instructions::MemoryType::NIL_TYPE) {
+      return (StackClass*)mem[SIZE_OR_CLS];
+    }
+    return nullptr;
+  }
+
+  //
+  // returns a unique object id for an instance
+  //
+  static inline long GetObjectID(size_t* mem) {
+    StackClass* klass = GetClass(mem);
+    if(klass) {
+      return klass->GetId();
+    }
+    
+    return -1;
+  }
+
+  friend struct ThreadAllocationBuffers;
+
+  //
+  // write barrier, records a reference stored into heap memory
+  //
+  static inline void WriteBarrier(size_t* addr) {
+    if(gc_generational) {
+      const size_t offset = (char*)addr - heap_base;
+      if(offset < (heap_chunks << HEAP_CHUNK_SHIFT)) {
+        card_table[offset >> HEAP_CARD_SHIFT] = 1;
+      }
+    }
+  }
+
+  // register and remove the calling thread as a mutator
+  static void AddMutator(size_t* op_stack, long* stack_pos, long stack_size);
+  static void RemoveMutator();
+
+  //
+  // parks the calling thread if a collection is waiting for it
+  //
+  static inline void SafepointPoll() {
+    if(safepoint_requested.load(std::memory_order_relaxed)) {
+      Safepoint();
+    }
+  }
+
+  static void Safepoint();
+
+  // brackets an operation that may block without touching the heap
+  static void EnterSafeRegion();
+  static void LeaveSafeRegion();
+
+  //
+  // address of the flag polled by JIT'ed code
+  //
+  static std::atomic<bool>* GetSafepointFlag() {
+    return &safepoint_requested;
+  }
+
+  //
+  // snapshot barrier, records the reference about to be overwritten
+  // at 'addr' while memory is concurrently marked
+  //
+  static inline void SatbBarrier(size_t* addr) {
+    if(gc_marking.load(std::memory_order_relaxed)) {
+      SatbRecord((size_t*)*addr);
+    }
+  }
+
+  static void SatbRecord(size_t* mem);
+  static void SatbObject(size_t* mem);
+
+  static bool IsConcurrent() {
+    return gc_concurrent;
+  }
+
+  static bool IsMarking() {
+    return gc_marking.load(std::memory_order_relaxed);
+  }
+
+  //
+  // address of the flag checked by JIT'ed snapshot barriers
+  //
+  static std::atomic<bool>* GetMarkingFlag() {
+    return &gc_marking;
+  }
+
+  // write barriers for native code that updates objects directly
+  static void WriteBarrierObject(size_t* mem);
+  static void WriteBarrierStack(size_t* op_stack, long stack_pos);
+  
+  static bool IsGenerational() {
+    return gc_generational;
+  }
+
+  //
+  // card table address biased by the heap base, such that the card
+  // for an address is at 'bias + (address >> HEAP_CARD_SHIFT)'
+  //
+  static size_t GetCardTableBias() {
+    return card_bias;
+  }
+
+  //
+  // number of times threads refilled allocation buffers from the shared heap
+  //
+  static size_t GetBufferRefills() {
+    return buffer_refills;
+  }
+
+  //
+  // number of free chunks whose pages were returned to the operating system
+  //
+  static size_t GetReleasedChunks() {
+    return released_chunks;
+  }
+
+  //
+  // allocation counters for a size class, counts from running threads
+  // are added when they refill their allocation buffers
+  //
+  static SizeClassStats GetSizeClassStats(const int size_class);
+
+  //
+  // number of refills that waited on the heap lock
+  //
+  static size_t GetBufferLockContention() {
+    return buffer_lock_contention;
+  }
+
+  //
+  // collector telemetry by GcStatistic id, pause times are in microseconds
+  //
+  static size_t GetStatistic(const long id);
+
+#ifdef _DEBUGGER
+  static size_t GetAllocationSize() {
+    return allocation_size;
+  }
+
+  static size_t GetMaxMemory() {
+    return mem_max_size;
+  }
+#endif
+};
+
+#endif
@@ -338,6 +338,227 @@ StackClass* StackClass::GetParent() {
   return parent;
 }
 
+//
+// instructions shared between methods by the loader's cache
+//
+static bool IsSharedInstruction(StackInstr* instr)
+{
+  switch(instr->GetType()) {
+  case RTRN:
+    // int operations
+  case ADD_INT:
+  case SUB_INT:
+  case MUL_INT:
+  case DIV_INT:
+  case MOD_INT:
+  case LES_INT:
+  case GTR_INT:
+  case EQL_INT:
+  case NEQL_INT:
+  case LES_EQL_INT:
+  case GTR_EQL_INT:
+  case OR_INT:
+  case AND_INT:
+  case SWAP_INT:
+  case BIT_AND_INT:
+  case BIT_OR_INT:
+  case BIT_XOR_INT:
+  case SHL_INT:
+  case SHR_INT:
+    // float operations
+  case ADD_FLOAT:
+  case SUB_FLOAT:
+  case MUL_FLOAT:
+  case DIV_FLOAT:
+  case MOD_FLOAT:
+  case LES_FLOAT:
+  case GTR_FLOAT:
+  case EQL_FLOAT:
+  case NEQL_FLOAT:
+  case LES_EQL_FLOAT:
+  case GTR_EQL_FLOAT:
+  case SQRT_FLOAT:
+  case RAND_FLOAT:
+  case ASIN_FLOAT:
+  case ACOS_FLOAT:
+  case ATAN_FLOAT:
+  case LOG2_FLOAT:
+  case CBRT_FLOAT:
+  case ATAN2_FLOAT:
+  case ACOSH_FLOAT:
+  case ASINH_FLOAT:
+  case ATANH_FLOAT:
+  case COSH_FLOAT:
+  case SINH_FLOAT:
+  case TANH_FLOAT:
+  case LOG_FLOAT:
+  case ROUND_FLOAT:
+  case EXP_FLOAT:
+  case LOG10_FLOAT:
+  case POW_FLOAT:
+  case GAMMA_FLOAT:
+  case NAN_INT:
+  case INF_INT:
+  case NEG_INF_INT:
+  case NAN_FLOAT:
+  case INF_FLOAT:
+  case NEG_INF_FLOAT:
+  case CEIL_FLOAT:
+  case TRUNC_FLOAT:
+  case FLOR_FLOAT:
+  case SIN_FLOAT:
+  case COS_FLOAT:
+  case TAN_FLOAT:
+    // conversions
+  case I2F:
+  case F2I:
+  case S2I:
+  case S2F:
+  case I2S:
+  case F2S:
+    // shared libraries
+  case LOAD_ARY_SIZE:
+  case EXT_LIB_LOAD:
+  case EXT_LIB_UNLOAD:
+  case EXT_LIB_FUNC_CALL:
+    // thread
+  case THREAD_JOIN:
+  case THREAD_SLEEP:
+  case THREAD_MUTEX:
+  case CRITICAL_START:
+  case CRITICAL_END:
+    // copy and clear
+  case CPY_BYTE_ARY:
+  case CPY_CHAR_ARY:
+  case CPY_INT_ARY:
+  case CPY_FLOAT_ARY:
+  case ZERO_BYTE_ARY:
+  case ZERO_CHAR_ARY:
+  case ZERO_INT_ARY:
+  case ZERO_FLOAT_ARY:
+    // program flow
+  case POP_INT:
+  case POP_FLOAT:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+void StackMethod::SetInstructions(StackInstr** ii, int ic)
+{
+  // copy instructions into one block, so dispatch walks contiguous memory
+  FreeCode();
+  instrs = ii;
+  instr_count = ic;
+  code = new StackInstr[ic];
+  has_traps = has_calls = false;
+  rtrn_index = -1;
+  for(int i = 0; i < ic; ++i) {
+    code[i] = *instrs[i];
+    switch(code[i].GetType()) {
+    case TRAP:
+    case TRAP_RTRN:
+      has_traps = true;
+      break;
+
+    case MTHD_CALL:
+      code[i].SetInlineCache(new InlineCache);
+      has_calls = true;
+      break;
+
+    case DYN_MTHD_CALL:
+      has_calls = true;
+      break;
+
+    case RTRN:
+      rtrn_index = i;
+      break;
+
+    default:
+      break;
+    }
+    if(!IsSharedInstruction(instrs[i])) {
+      delete instrs[i];
+    }
+    instrs[i] = code + i;
+  }
+
+  CalculateFrameSize();
+  lazy_code.store(nullptr, std::memory_order_release);
+}
+
+void StackMethod::LoadLazyCode() const
+{
+  Loader::LoadLazyStatements(const_cast<StackMethod*>(this), lazy_code.load(std::memory_order_acquire), lazy_debug);
+}
+
+void StackMethod::FreeCode()
+{
+  if(code) {
+    for(int i = 0; i < instr_count; ++i) {
+      delete code[i].GetInlineCache();
+    }
+    delete[] code;
+    code = nullptr;
+  }
+}
+
+void StackMethod::CalculateFrameSize()
+{
+  // declared space does not count every temporary, such as lambda references
+  long slots = (mem_size + (long)sizeof(size_t) - 1) / (long)sizeof(size_t) + 1;
+
+  // locals read through declarations by the garbage collector and debugger
+  long dclr_slots = has_and_or ? 2 : 1;
+  for(long i = 0; i < num_dclrs; ++i) {
+    dclr_slots += dclrs[i]->type == FLOAT_PARM || dclrs[i]->type == FUNC_PARM ? 2 : 1;
+  }
+  if(dclr_slots > slots) {
+    slots = dclr_slots;
+  }
+
+  // locals referenced by instructions
+  for(int i = 0; i < instr_count; ++i) {
+    StackInstr* instr = instrs[i];
+    long instr_slots = 0;
+    switch(instr->GetType()) {
+    case LOAD_LOCL_INT_VAR:
+    case STOR_LOCL_INT_VAR:
+    case COPY_LOCL_INT_VAR:
+    case INC_LOCL_INT_VAR:
+    case CMP_JMP_LOCL_INT_VAR:
+      instr_slots = instr->GetOperand() + 2;
+      break;
+
+    case LOAD_FLOAT_VAR:
+    case STOR_FLOAT_VAR:
+    case COPY_FLOAT_VAR:
+      if(instr->GetOperand2() == LOCL) {
+        instr_slots = instr->GetOperand() + 2;
+      }
+      break;
+
+    case LOAD_FUNC_VAR:
+    case STOR_FUNC_VAR:
+      if(instr->GetOperand2() == LOCL) {
+        instr_slots = instr->GetOperand() + 3;
+      }
+      break;
+
+    default:
+      break;
+    }
+
+    if(instr_slots > slots) {
+      slots = instr_slots;
+    }
+  }
+
+  frame_size = slots * sizeof(size_t);
+}
+
 const std::wstring StackMethod::ParseName(const std::wstring& name) const
 {
   int state;
@@ -1932,6 +2153,10 @@ void TrapProcessor::DeserializeObject(size_t* inst, size_t* &op_stack, long* &st
  ********************************/
 bool TrapProcessor::ProcessTrap(StackProgram* program, size_t* inst,
                                 size_t* &op_stack, long* &stack_pos, StackFrame* frame) {
+  // traps may store references into objects passed on the stack
+  MemoryManager::WriteBarrierObject(inst);
+  MemoryManager::WriteBarrierStack(op_stack, *stack_pos);
+
   const INT64_VALUE id = (INT64_VALUE)PopInt(op_stack, stack_pos);
   switch(id) {
   case LOAD_CLS_INST_ID:
@@ -2057,6 +2282,9 @@ bool TrapProcessor::ProcessTrap(StackProgram* program, size_t* inst,
   case  SYS_CMD_OUT:
     return SysCmdOut(program, inst, op_stack, stack_pos, frame);
 
+  case GC_STAT:
+    return GcStat(program, inst, op_stack, stack_pos, frame);
+
   case EXIT:
     return Exit(program, inst, op_stack, stack_pos, frame);
 
@@ -2958,7 +3186,10 @@ bool TrapProcessor::StdInByteAryLen(StackProgram* program, size_t* inst, size_t*
 
   if(array && offset > -1 && offset + num <= (long)array[0]) {
     char* buffer = (char*)(array + 3);
-    PushInt(fread(buffer + offset, num, 1, stdin), op_stack, stack_pos);
+    MemoryManager::EnterSafeRegion();
+    const size_t read = fread(buffer + offset, num, 1, stdin);
+    MemoryManager::LeaveSafeRegion();
+    PushInt(read, op_stack, stack_pos);
   }
   else {
     PushInt(-1, op_stack, stack_pos);
@@ -2981,7 +3212,9 @@ bool TrapProcessor::StdInCharAryLen(StackProgram* program, size_t* inst, size_t*
     wchar_t* buffer = (wchar_t*)(array + 3);
     // allocate temporary buffer
     char* byte_buffer = new char[num * 2 + 1];
+    MemoryManager::EnterSafeRegion();
     size_t read = fread(byte_buffer + offset, 1, num, stdin);
+    MemoryManager::LeaveSafeRegion();
     if(read) {
       byte_buffer[read] = '\0';
       std::wstring in = BytesToUnicode(byte_buffer);
@@ -3011,6 +3244,7 @@ bool TrapProcessor::StdInString(StackProgram* program, size_t* inst, size_t*& op
   size_t* array = (size_t*)PopInt(op_stack, stack_pos);
   if(array) {
     std::wstring wbuffer;
+    MemoryManager::EnterSafeRegion();
     if(Runtime::StackInterpreter::IsBinaryStdio()) {
       std::string buffer;
       std::getline(std::cin, buffer);
@@ -3019,6 +3253,7 @@ bool TrapProcessor::StdInString(StackProgram* program, size_t* inst, size_t*& op
     else {
       std::getline(std::wcin, wbuffer);
     }
+    MemoryManager::LeaveSafeRegion();
 
     // copy to dest
     wchar_t* dest = (wchar_t*)(array + 3);
@@ -3492,6 +3727,14 @@ bool TrapProcessor::GetVersion(StackProgram* program, size_t* inst, size_t* &op_
   return true;
 }
 
+bool TrapProcessor::GcStat(StackProgram* program, size_t* inst, size_t* &op_stack, long* &stack_pos, StackFrame* frame)
+{
+  const long id = (long)PopInt(op_stack, stack_pos);
+  PushInt(MemoryManager::GetStatistic(id), op_stack, stack_pos);
+
+  return true;
+}
+
 bool TrapProcessor::GetSysProp(StackProgram* program, size_t* inst, size_t* &op_stack, long* &stack_pos, StackFrame* frame)
 {
   size_t* key_array = (size_t*)PopInt(op_stack, stack_pos);
@@ -3729,7 +3972,9 @@ bool TrapProcessor::SockTcpAccept(StackProgram* program, size_t* inst, size_t* &
     SOCKET server = (SOCKET)instance[0];
     char client_address[SMALL_BUFFER_MAX] = {0};
     int client_port;
+    MemoryManager::EnterSafeRegion();
     SOCKET client = IPSocket::Accept(server, client_address, client_port);
+    MemoryManager::LeaveSafeRegion();
 #ifdef _DEBUG
     std::wcout << L"# socket accept: instance=" << instance << L"(" << (size_t)instance << L")" << L"; ip="
       << BytesToUnicode(client_address) << L"; port=" << client_port << L"; addr=" << server << L"("
@@ -5137,7 +5382,10 @@ bool TrapProcessor::SockTcpInByte(StackProgram* program, size_t* inst, size_t* &
   if(instance && (long)instance[0] > -1) {
     SOCKET sock = (SOCKET)instance[0];
     int status;
-    PushInt(IPSocket::ReadByte(sock, status), op_stack, stack_pos);
+    MemoryManager::EnterSafeRegion();
+    const char value = IPSocket::ReadByte(sock, status);
+    MemoryManager::LeaveSafeRegion();
+    PushInt(value, op_stack, stack_pos);
   }
   else {
     PushInt(0, op_stack, stack_pos);
@@ -5156,7 +5404,10 @@ bool TrapProcessor::SockTcpInByteAry(StackProgram* program, size_t* inst, size_t
   if(array && instance && (long)instance[0] > -1 && offset > -1 && offset + num <= (long)array[0]) {
     SOCKET sock = (SOCKET)instance[0];
     char* buffer = (char*)(array + 3);
-    PushInt(IPSocket::ReadBytes(buffer + offset, num, sock), op_stack, stack_pos);
+    MemoryManager::EnterSafeRegion();
+    const int read = IPSocket::ReadBytes(buffer + offset, num, sock);
+    MemoryManager::LeaveSafeRegion();
+    PushInt(read, op_stack, stack_pos);
   }
   else {
     PushInt(-1, op_stack, stack_pos);
@@ -5177,7 +5428,9 @@ bool TrapProcessor::SockTcpInCharAry(StackProgram* program, size_t* inst, size_t
     wchar_t* buffer = (wchar_t*)(array + 3);
     // allocate temporary buffer
     char* byte_buffer = new char[num * 2 + 1];
+    MemoryManager::EnterSafeRegion();
     int read = IPSocket::ReadBytes(byte_buffer + offset, num, sock);
+    MemoryManager::LeaveSafeRegion();
     if(read > -1) {
       byte_buffer[read] = '\0';
       std::wstring in = BytesToUnicode(byte_buffer);
@@ -42,6 +42,7 @@
 #include <list>
 #include <set>
 #include <string>
+#include <atomic>
 #include <ctime>
 #include <string.h>
 #include <stdlib.h>
@@ -109,6 +110,7 @@ enum {
 };
 
 class StackClass;
+class StackMethod;
 
 inline const std::wstring IntToString(int v)
 {
@@ -125,12 +127,78 @@ struct StackDclr
   long id;
 };
 
+/********************************
+ * Inline cache for a method call
+ * site, receiver classes and the
+ * methods they are bound to. Entries
+ * are only added, once full the site
+ * is megamorphic.
+ ********************************/
+#define INLINE_CACHE_SIZE 4
+
+class InlineCache {
+  struct Entry {
+    StackClass* cls;
+    StackMethod* mthd;
+  };
+  std::atomic<Entry*> entries[INLINE_CACHE_SIZE];
+
+ public:
+  InlineCache() {
+    for(int i = 0; i < INLINE_CACHE_SIZE; ++i) {
+      entries[i] = nullptr;
+    }
+  }
+
+  ~InlineCache() {
+    for(int i = 0; i < INLINE_CACHE_SIZE; ++i) {
+      delete entries[i].load();
+    }
+  }
+
+  inline StackMethod* GetMethod(StackClass* cls) {
+    for(int i = 0; i < INLINE_CACHE_SIZE; ++i) {
+      Entry* entry = entries[i].load(std::memory_order_acquire);
+      if(!entry) {
+        return nullptr;
+      }
+
+      if(entry->cls == cls) {
+        return entry->mthd;
+      }
+    }
+
+    return nullptr;
+  }
+
+  void AddMethod(StackClass* cls, StackMethod* mthd) {
+    Entry* entry = new Entry;
+    entry->cls = cls;
+    entry->mthd = mthd;
+
+    // threads may race to add the same class
+    for(int i = 0; i < INLINE_CACHE_SIZE; ++i) {
+      Entry* expected = nullptr;
+      if(entries[i].compare_exchange_strong(expected, entry, std::memory_order_release)) {
+        return;
+      }
+
+      if(expected->cls == cls) {
+        break;
+      }
+    }
+
+    delete entry;
+  }
+};
+
 /********************************
  * StackInstr class
  ********************************/
 class StackInstr 
 {
   InstructionType type;
+  int line_num;
   long operand;
   union {
     long operand2;
@@ -139,19 +207,30 @@ class StackInstr
   } alt_operand;
   long operand3;
   long native_offset;
-  int line_num;
+  // set for method calls once laid out by their method
+  InlineCache* inline_cache;
 
  public:
+  StackInstr() {
+    line_num = -1;
+    type = END_STMTS;
+    operand = operand3 = native_offset = 0;
+    alt_operand.int64_operand = 0;
+    inline_cache = nullptr;
+  }
+
   StackInstr(int l, INT64_VALUE v) {
     line_num = l;
     type = LOAD_INT_LIT;
     alt_operand.int64_operand = v;
+    inline_cache = nullptr;
   }
 
   StackInstr(int l, InstructionType t) {
     line_num = l;
     type = t;
     operand = operand3 = native_offset = 0;
+    inline_cache = nullptr;
   }
 
   StackInstr(int l, InstructionType t, long o) {
@@ -159,6 +238,7 @@ class StackInstr
     type = t;
     operand = o;
     operand3 = native_offset = 0;
+    inline_cache = nullptr;
   }
 
   StackInstr(int l, InstructionType t, FLOAT_VALUE fo) {
@@ -166,6 +246,7 @@ class StackInstr
     type = t;
     alt_operand.float_operand = fo;
     operand = operand3 = native_offset = 0;
+    inline_cache = nullptr;
   }
 
   StackInstr(int l, InstructionType t, long o, long o2) {
@@ -174,6 +255,7 @@ class StackInstr
     operand = o;
     alt_operand.operand2 = o2;
     operand3 = native_offset = 0;
+    inline_cache = nullptr;
   }
 
   StackInstr(int l, InstructionType t, long o, long o2, long o3) {
@@ -183,6 +265,7 @@ class StackInstr
     alt_operand.operand2 = o2;
     operand3 = o3;
     native_offset = 0;
+    inline_cache = nullptr;
   }
 
   ~StackInstr() {
@@ -227,6 +310,14 @@ class StackInstr
   inline void SetOffset(long o) {
     native_offset = o;
   }
+
+  inline InlineCache* GetInlineCache() const {
+    return inline_cache;
+  }
+
+  inline void SetInlineCache(InlineCache* c) {
+    inline_cache = c;
+  }
 };
 
 /********************************
@@ -242,6 +333,8 @@ class NativeCode {
 
   long size;
   FLOAT_VALUE* floats;
+  // loop header instruction to code offset, for on-stack replacement
+  std::unordered_map<long, long> osr_entries;
   
  public:
 #ifdef _ARM64
@@ -294,6 +387,19 @@ class NativeCode {
   inline FLOAT_VALUE* GetFloats() const {
     return floats;
   }
+
+  inline void AddOsrEntry(long ip, long offset) {
+    osr_entries[ip] = offset;
+  }
+
+  inline long GetOsrEntry(long ip) const {
+    std::unordered_map<long, long>::const_iterator result = osr_entries.find(ip);
+    if(result != osr_entries.end()) {
+      return result->second;
+    }
+
+    return -1;
+  }
 };
 
 /********************************
@@ -306,16 +412,37 @@ class StackMethod {
   bool has_and_or;
   bool is_lambda;
   StackInstr** instrs;  
+  StackInstr* code;
   int instr_count;  
   long param_count;
   long mem_size;
+  long frame_size;
   NativeCode* native_code;
+  // tiered compilation
+  long call_count;
+  long loop_count;
+  bool jit_failed;
+  bool has_traps;
+  bool has_calls;
+  long rtrn_index;
   MemoryType rtrn_type;
   StackDclr** dclrs;
   long num_dclrs;
   StackClass* cls;
+  // encoded instructions of a mapped executable, decoded on first use
+  std::atomic<const char*> lazy_code;
+  bool lazy_debug;
 
   const std::wstring ParseName(const std::wstring &name) const;
+  void CalculateFrameSize();
+  void FreeCode();
+  void LoadLazyCode() const;
+
+  inline void CheckCode() const {
+    if(lazy_code.load(std::memory_order_acquire)) {
+      LoadLazyCode();
+    }
+  }
 
  public:
   StackMethod(long i, const std::wstring &n, bool v, bool h, bool l, StackDclr** d, long nd, long p, long m, MemoryType r, StackClass* k) {
@@ -325,6 +452,9 @@ class StackMethod {
     has_and_or = h;
     is_lambda = l;
     native_code = nullptr;
+    call_count = loop_count = 0;
+    jit_failed = has_traps = has_calls = false;
+    rtrn_index = -1;
     dclrs = d;
     num_dclrs = nd;
     param_count = p;
@@ -332,7 +462,11 @@ class StackMethod {
     rtrn_type = r;
     cls = k;
     instrs = nullptr;
+    code = nullptr;
     instr_count = 0;
+    lazy_code = nullptr;
+    lazy_debug = false;
+    CalculateFrameSize();
   }
 
   ~StackMethod() {
@@ -353,114 +487,9 @@ class StackMethod {
       native_code = nullptr;
     }
 
-    // clean up
-    for(int i = 0; i < instr_count; ++i) {
-      StackInstr* tmp = instrs[i];
-
-      switch(tmp->GetType()) {
-      case RTRN:
-        // int operations
-      case ADD_INT:
-      case SUB_INT:
-      case MUL_INT:
-      case DIV_INT:
-      case MOD_INT:
-      case LES_INT:
-      case GTR_INT:
-      case EQL_INT:
-      case NEQL_INT:
-      case LES_EQL_INT:
-      case GTR_EQL_INT:
-      case OR_INT:
-      case AND_INT:
-      case SWAP_INT:
-      case BIT_AND_INT:
-      case BIT_OR_INT:
-      case BIT_XOR_INT:
-      case SHL_INT:
-      case SHR_INT:
-        // float operations
-      case ADD_FLOAT:
-      case SUB_FLOAT:
-      case MUL_FLOAT:
-      case DIV_FLOAT:
-      case MOD_FLOAT:
-      case LES_FLOAT:
-      case GTR_FLOAT:
-      case EQL_FLOAT:
-      case NEQL_FLOAT:
-      case LES_EQL_FLOAT:
-      case GTR_EQL_FLOAT:
-      case SQRT_FLOAT:
-      case RAND_FLOAT:
-      case ASIN_FLOAT:
-      case ACOS_FLOAT:
-      case ATAN_FLOAT:
-      case LOG2_FLOAT:
-      case CBRT_FLOAT:
-      case ATAN2_FLOAT:
-      case ACOSH_FLOAT:
-      case ASINH_FLOAT:
-      case ATANH_FLOAT:
-      case COSH_FLOAT:
-      case SINH_FLOAT:
-      case TANH_FLOAT:
-      case LOG_FLOAT:
-      case ROUND_FLOAT:
-      case EXP_FLOAT:
-      case LOG10_FLOAT:
-      case POW_FLOAT:
-      case GAMMA_FLOAT:
-      case NAN_INT:
-      case INF_INT:
-      case NEG_INF_INT:
-      case NAN_FLOAT:
-      case INF_FLOAT:
-      case NEG_INF_FLOAT:
-      case CEIL_FLOAT:
-      case TRUNC_FLOAT:
-      case FLOR_FLOAT:
-      case SIN_FLOAT:
-      case COS_FLOAT:
-      case TAN_FLOAT:
-        // conversions
-      case I2F:
-      case F2I:
-      case S2I:
-      case S2F:
-      case I2S:
-      case F2S:
-        // shared libraries
-      case LOAD_ARY_SIZE:
-      case EXT_LIB_LOAD:
-      case EXT_LIB_UNLOAD:
-      case EXT_LIB_FUNC_CALL:
-        // thread
-      case THREAD_JOIN:
-      case THREAD_SLEEP:
-      case THREAD_MUTEX:
-      case CRITICAL_START:
-      case CRITICAL_END:
-        // copy and clear
-      case CPY_BYTE_ARY:
-      case CPY_CHAR_ARY:
-      case CPY_INT_ARY:
-      case CPY_FLOAT_ARY:
-      case ZERO_BYTE_ARY:
-      case ZERO_CHAR_ARY:
-      case ZERO_INT_ARY:
-      case ZERO_FLOAT_ARY:
-        // program flow
-      case POP_INT:
-      case POP_FLOAT:
-        break;
+    // clean up, instructions are held in one block
+    FreeCode();
 
-      default:
-        delete tmp;
-        tmp = nullptr;
-        break;
-      }
-    }
     delete[] instrs;
     instrs = nullptr;
   }
@@ -528,13 +557,58 @@ class StackMethod {
     return native_code;
   }
 
+  //
+  // invocation and backward jump counts, used to find methods to JIT compile
+  //
+  inline long CountCall() {
+    return ++call_count;
+  }
+
+  inline long CountLoop() {
+    return ++loop_count;
+  }
+
+  inline long GetLoopCount() const {
+    return loop_count;
+  }
+
+  inline void SetJitFailed() {
+    jit_failed = true;
+  }
+
+  inline bool IsJitFailed() const {
+    return jit_failed;
+  }
+
+  inline bool HasTraps() const {
+    CheckCode();
+    return has_traps;
+  }
+
+  inline bool HasCalls() const {
+    CheckCode();
+    return has_calls;
+  }
+
+  // last return, where the interpreter resumes after on-stack replacement
+  inline long GetReturnIndex() const {
+    CheckCode();
+    return rtrn_index;
+  }
+
   MemoryType GetReturn() const {
     return rtrn_type;
   }
 
-  void SetInstructions(StackInstr** ii, int ic) {
-    instrs = ii;
-    instr_count = ic;
+  void SetInstructions(StackInstr** ii, int ic);
+
+  void SetLazyCode(const char* c, bool d) {
+    lazy_debug = d;
+    lazy_code.store(c, std::memory_order_release);
+  }
+
+  inline bool HasLazyCode() const {
+    return lazy_code.load(std::memory_order_acquire) != nullptr;
   }
 
   long GetId() const {
@@ -562,17 +636,37 @@ class StackMethod {
     return mem_size;
   }
 
+  //
+  // bytes of frame memory, the instance followed by every local
+  // referenced by the method's instructions or declarations
+  //
+  inline long GetFrameSize() const {
+    CheckCode();
+    return frame_size;
+  }
+
   inline long GetInstructionCount() const {
+    CheckCode();
     return instr_count;
   }
 
   inline StackInstr* GetInstruction(long i) const {
+    CheckCode();
     return instrs[i];
   }
 
   inline StackInstr** GetInstructions() const {
+    CheckCode();
     return instrs;
   }
+
+  //
+  // instructions laid out contiguously, instrs[i] points to code[i]
+  //
+  inline StackInstr* GetCode() const {
+    CheckCode();
+    return code;
+  }
 };
 
 /********************************
@@ -926,6 +1020,11 @@ class StackProgram {
   wchar_t** char_strings;
   int num_char_strings;
 
+  // hash of the executable file, 0 if loaded from memory
+  uint64_t file_hash;
+  const char* file_image;
+  size_t file_image_size;
+
 #ifdef _WIN32
   static CRITICAL_SECTION program_cs;
   static CRITICAL_SECTION prop_cs;
@@ -945,6 +1044,9 @@ class StackProgram {
     classes = nullptr;
     char_strings = nullptr;
     string_cls_id = cls_cls_id = mthd_cls_id = sock_cls_id = data_type_cls_id = command_output_cls_id = -1;
+    file_hash = 0;
+    file_image = nullptr;
+    file_image_size = 0;
 #ifdef _WIN32
     InitializeCriticalSection(&program_cs);
     InitializeCriticalSection(&prop_cs);
@@ -1107,6 +1209,24 @@ class StackProgram {
     string_cls_id = id;
   }
 
+  uint64_t GetFileHash() {
+    if(!file_hash && file_image) {
+      file_hash = HashBytes(file_image, file_image_size);
+    }
+
+    return file_hash;
+  }
+
+  void SetFileHash(uint64_t h) {
+    file_hash = h;
+  }
+
+  // executable image hashed on demand
+  void SetFileImage(const char* b, size_t s) {
+    file_image = b;
+    file_image_size = s;
+  }
+
    const long GetClassObjectId() {
     if(cls_cls_id < 0) {
       StackClass* cls = GetClass(L"System.Introspection.Class");
@@ -1659,6 +1779,7 @@ class TrapProcessor {
 	static bool RaiseSignal(StackProgram* program, size_t* inst, size_t*& op_stack, long*& stack_pos, StackFrame* frame);
   static bool SysCmdOut(StackProgram* program, size_t* inst, size_t*& op_stack, long*& stack_pos, StackFrame* frame);
   static bool Exit(StackProgram* program, size_t* inst, size_t* &op_stack, long* &stack_pos, StackFrame* frame);
+  static bool GcStat(StackProgram* program, size_t* inst, size_t* &op_stack, long* &stack_pos, StackFrame* frame);
   static bool GmtTime(StackProgram* program, size_t* inst, size_t* &op_stack, long* &stack_pos, StackFrame* frame);
   static bool SysTime(StackProgram* program, size_t* inst, size_t* &op_stack, long* &stack_pos, StackFrame* frame);
   static bool DateTimeSet1(StackProgram* program, size_t* inst, size_t* &op_stack, long* &stack_pos, StackFrame* frame);
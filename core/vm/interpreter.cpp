@@ -56,7 +56,7 @@
 using namespace Runtime;
 
 StackProgram* StackInterpreter::program;
-std::stack<StackFrame*> StackInterpreter::cached_frames;
+thread_local FrameStack StackInterpreter::frame_stack;
 std::set<StackInterpreter*> StackInterpreter::intpr_threads;
 
 #ifdef _WIN32
@@ -64,13 +64,19 @@ bool StackInterpreter::is_stdio_binary;
 #endif
 
 #ifdef _WIN32
-CRITICAL_SECTION StackInterpreter::cached_frames_cs;
 CRITICAL_SECTION StackInterpreter::intpr_threads_cs;
 #else
-pthread_mutex_t StackInterpreter::cached_frames_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t StackInterpreter::intpr_threads_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
+long StackInterpreter::jit_call_threshold;
+long StackInterpreter::jit_loop_threshold;
+#ifdef _WIN32
+CRITICAL_SECTION StackInterpreter::jit_cs;
+#else
+pthread_mutex_t StackInterpreter::jit_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /********************************
  * VM initialization
  ********************************/
@@ -79,17 +85,18 @@ void StackInterpreter::Initialize(StackProgram* p)
   program = p;
   
 #ifdef _WIN32
-  InitializeCriticalSection(&cached_frames_cs);
   InitializeCriticalSection(&intpr_threads_cs);
+  InitializeCriticalSection(&jit_cs);
 #endif
 
-#ifndef _SANITIZE
-  // allocate frames
-  for(size_t i = 0; i < FRAME_CACHE_SIZE; ++i) {
-    StackFrame* frame = new StackFrame();
-    frame->mem = (size_t*)calloc(LOCAL_SIZE, sizeof(char));
-    cached_frames.push(frame);
-  }
+  // automatic JIT compilation of frequently called methods and loops
+#if defined(_DEBUGGER) || defined(_NO_JIT)
+  jit_call_threshold = jit_loop_threshold = 0;
+#else
+  const std::wstring call_threshold = program->GetProperty(L"jit-threshold");
+  jit_call_threshold = call_threshold.empty() ? JIT_CALL_THRESHOLD : wcstol(call_threshold.c_str(), nullptr, 10);
+  const std::wstring loop_threshold = program->GetProperty(L"jit-loop-threshold");
+  jit_loop_threshold = loop_threshold.empty() ? JIT_LOOP_THRESHOLD : wcstol(loop_threshold.c_str(), nullptr, 10);
 #endif
 
 #ifndef _NO_JIT
@@ -129,7 +136,7 @@ void StackInterpreter::Execute(size_t* op_stack, long* stack_pos, long i, StackM
   std::wcout << L"creating frame=" << (*frame) << std::endl;
 #endif
   (*frame)->jit_called = jit_called;
-  StackInstr** instrs = (*frame)->method->GetInstructions();
+  StackInstr* instrs = (*frame)->method->GetCode();
   long ip = i;
 
 #ifdef _TIMING
@@ -143,424 +150,586 @@ void StackInterpreter::Execute(size_t* op_stack, long* stack_pos, long i, StackM
         << L"' ---------\n" << std::endl;
 #endif
 
+#ifdef _THREADED
+  // instruction labels for threaded dispatch, set up by the first
+  // (single-threaded) call, other types are dispatched by the switch
+  static void* dispatch_table[END_STMTS + 1];
+  static bool dispatch_ready = false;
+  if(!dispatch_ready) {
+    for(int j = 0; j <= END_STMTS; ++j) {
+      dispatch_table[j] = &&dispatch_switch;
+    }
+    dispatch_table[STOR_LOCL_INT_VAR] = &&STOR_LOCL_INT_VAR_LABEL;
+    dispatch_table[STOR_CLS_INST_INT_VAR] = &&STOR_CLS_INST_INT_VAR_LABEL;
+    dispatch_table[STOR_FUNC_VAR] = &&STOR_FUNC_VAR_LABEL;
+    dispatch_table[STOR_FLOAT_VAR] = &&STOR_FLOAT_VAR_LABEL;
+    dispatch_table[COPY_LOCL_INT_VAR] = &&COPY_LOCL_INT_VAR_LABEL;
+    dispatch_table[COPY_CLS_INST_INT_VAR] = &&COPY_CLS_INST_INT_VAR_LABEL;
+    dispatch_table[COPY_FLOAT_VAR] = &&COPY_FLOAT_VAR_LABEL;
+    dispatch_table[LOAD_CHAR_LIT] = &&LOAD_CHAR_LIT_LABEL;
+    dispatch_table[LOAD_INT_LIT] = &&LOAD_INT_LIT_LABEL;
+    dispatch_table[SHL_INT] = &&SHL_INT_LABEL;
+    dispatch_table[SHR_INT] = &&SHR_INT_LABEL;
+    dispatch_table[LOAD_FLOAT_LIT] = &&LOAD_FLOAT_LIT_LABEL;
+    dispatch_table[LOAD_LOCL_INT_VAR] = &&LOAD_LOCL_INT_VAR_LABEL;
+    dispatch_table[LOAD_CLS_INST_INT_VAR] = &&LOAD_CLS_INST_INT_VAR_LABEL;
+    dispatch_table[LOAD_SELF_INT_VAR] = &&LOAD_SELF_INT_VAR_LABEL;
+    dispatch_table[INC_LOCL_INT_VAR] = &&INC_LOCL_INT_VAR_LABEL;
+    dispatch_table[CMP_JMP_LOCL_INT_VAR] = &&CMP_JMP_LOCL_INT_VAR_LABEL;
+    dispatch_table[LOAD_FUNC_VAR] = &&LOAD_FUNC_VAR_LABEL;
+    dispatch_table[LOAD_FLOAT_VAR] = &&LOAD_FLOAT_VAR_LABEL;
+    dispatch_table[AND_INT] = &&AND_INT_LABEL;
+    dispatch_table[OR_INT] = &&OR_INT_LABEL;
+    dispatch_table[ADD_INT] = &&ADD_INT_LABEL;
+    dispatch_table[ADD_FLOAT] = &&ADD_FLOAT_LABEL;
+    dispatch_table[SUB_INT] = &&SUB_INT_LABEL;
+    dispatch_table[SUB_FLOAT] = &&SUB_FLOAT_LABEL;
+    dispatch_table[MUL_INT] = &&MUL_INT_LABEL;
+    dispatch_table[DIV_INT] = &&DIV_INT_LABEL;
+    dispatch_table[MUL_FLOAT] = &&MUL_FLOAT_LABEL;
+    dispatch_table[DIV_FLOAT] = &&DIV_FLOAT_LABEL;
+    dispatch_table[MOD_INT] = &&MOD_INT_LABEL;
+    dispatch_table[BIT_AND_INT] = &&BIT_AND_INT_LABEL;
+    dispatch_table[BIT_OR_INT] = &&BIT_OR_INT_LABEL;
+    dispatch_table[BIT_XOR_INT] = &&BIT_XOR_INT_LABEL;
+    dispatch_table[LES_EQL_INT] = &&LES_EQL_INT_LABEL;
+    dispatch_table[GTR_EQL_INT] = &&GTR_EQL_INT_LABEL;
+    dispatch_table[LES_EQL_FLOAT] = &&LES_EQL_FLOAT_LABEL;
+    dispatch_table[GTR_EQL_FLOAT] = &&GTR_EQL_FLOAT_LABEL;
+    dispatch_table[EQL_INT] = &&EQL_INT_LABEL;
+    dispatch_table[NEQL_INT] = &&NEQL_INT_LABEL;
+    dispatch_table[LES_INT] = &&LES_INT_LABEL;
+    dispatch_table[GTR_INT] = &&GTR_INT_LABEL;
+    dispatch_table[EQL_FLOAT] = &&EQL_FLOAT_LABEL;
+    dispatch_table[NEQL_FLOAT] = &&NEQL_FLOAT_LABEL;
+    dispatch_table[LES_FLOAT] = &&LES_FLOAT_LABEL;
+    dispatch_table[GTR_FLOAT] = &&GTR_FLOAT_LABEL;
+    dispatch_table[LOAD_ARY_SIZE] = &&LOAD_ARY_SIZE_LABEL;
+    dispatch_table[CPY_BYTE_ARY] = &&CPY_BYTE_ARY_LABEL;
+    dispatch_table[CPY_CHAR_ARY] = &&CPY_CHAR_ARY_LABEL;
+    dispatch_table[CPY_INT_ARY] = &&CPY_INT_ARY_LABEL;
+    dispatch_table[CPY_FLOAT_ARY] = &&CPY_FLOAT_ARY_LABEL;
+    dispatch_table[ZERO_BYTE_ARY] = &&ZERO_BYTE_ARY_LABEL;
+    dispatch_table[ZERO_CHAR_ARY] = &&ZERO_CHAR_ARY_LABEL;
+    dispatch_table[ZERO_INT_ARY] = &&ZERO_INT_ARY_LABEL;
+    dispatch_table[ZERO_FLOAT_ARY] = &&ZERO_FLOAT_ARY_LABEL;
+    dispatch_table[CEIL_FLOAT] = &&CEIL_FLOAT_LABEL;
+    dispatch_table[TRUNC_FLOAT] = &&TRUNC_FLOAT_LABEL;
+    dispatch_table[FLOR_FLOAT] = &&FLOR_FLOAT_LABEL;
+    dispatch_table[SIN_FLOAT] = &&SIN_FLOAT_LABEL;
+    dispatch_table[COS_FLOAT] = &&COS_FLOAT_LABEL;
+    dispatch_table[TAN_FLOAT] = &&TAN_FLOAT_LABEL;
+    dispatch_table[ASIN_FLOAT] = &&ASIN_FLOAT_LABEL;
+    dispatch_table[ACOS_FLOAT] = &&ACOS_FLOAT_LABEL;
+    dispatch_table[ATAN_FLOAT] = &&ATAN_FLOAT_LABEL;
+    dispatch_table[LOG2_FLOAT] = &&LOG2_FLOAT_LABEL;
+    dispatch_table[CBRT_FLOAT] = &&CBRT_FLOAT_LABEL;
+    dispatch_table[LOG_FLOAT] = &&LOG_FLOAT_LABEL;
+    dispatch_table[ROUND_FLOAT] = &&ROUND_FLOAT_LABEL;
+    dispatch_table[EXP_FLOAT] = &&EXP_FLOAT_LABEL;
+    dispatch_table[LOG10_FLOAT] = &&LOG10_FLOAT_LABEL;
+    dispatch_table[SQRT_FLOAT] = &&SQRT_FLOAT_LABEL;
+    dispatch_table[GAMMA_FLOAT] = &&GAMMA_FLOAT_LABEL;
+    dispatch_table[NAN_INT] = &&NAN_INT_LABEL;
+    dispatch_table[INF_INT] = &&INF_INT_LABEL;
+    dispatch_table[NEG_INF_INT] = &&NEG_INF_INT_LABEL;
+    dispatch_table[NAN_FLOAT] = &&NAN_FLOAT_LABEL;
+    dispatch_table[INF_FLOAT] = &&INF_FLOAT_LABEL;
+    dispatch_table[NEG_INF_FLOAT] = &&NEG_INF_FLOAT_LABEL;
+    dispatch_table[RAND_FLOAT] = &&RAND_FLOAT_LABEL;
+    dispatch_table[ACOSH_FLOAT] = &&ACOSH_FLOAT_LABEL;
+    dispatch_table[ASINH_FLOAT] = &&ASINH_FLOAT_LABEL;
+    dispatch_table[ATANH_FLOAT] = &&ATANH_FLOAT_LABEL;
+    dispatch_table[COSH_FLOAT] = &&COSH_FLOAT_LABEL;
+    dispatch_table[SINH_FLOAT] = &&SINH_FLOAT_LABEL;
+    dispatch_table[TANH_FLOAT] = &&TANH_FLOAT_LABEL;
+    dispatch_table[ATAN2_FLOAT] = &&ATAN2_FLOAT_LABEL;
+    dispatch_table[MOD_FLOAT] = &&MOD_FLOAT_LABEL;
+    dispatch_table[POW_FLOAT] = &&POW_FLOAT_LABEL;
+    dispatch_table[I2F] = &&I2F_LABEL;
+    dispatch_table[F2I] = &&F2I_LABEL;
+    dispatch_table[S2I] = &&S2I_LABEL;
+    dispatch_table[S2F] = &&S2F_LABEL;
+    dispatch_table[I2S] = &&I2S_LABEL;
+    dispatch_table[F2S] = &&F2S_LABEL;
+    dispatch_table[SWAP_INT] = &&SWAP_INT_LABEL;
+    dispatch_table[POP_INT] = &&POP_INT_LABEL;
+    dispatch_table[POP_FLOAT] = &&POP_FLOAT_LABEL;
+    dispatch_table[RTRN] = &&RTRN_LABEL;
+    dispatch_table[DYN_MTHD_CALL] = &&DYN_MTHD_CALL_LABEL;
+    dispatch_table[MTHD_CALL] = &&MTHD_CALL_LABEL;
+    dispatch_table[JMP] = &&JMP_LABEL;
+    dispatch_table[OBJ_TYPE_OF] = &&OBJ_TYPE_OF_LABEL;
+    dispatch_table[OBJ_INST_CAST] = &&OBJ_INST_CAST_LABEL;
+    dispatch_table[ASYNC_MTHD_CALL] = &&ASYNC_MTHD_CALL_LABEL;
+    dispatch_table[THREAD_JOIN] = &&THREAD_JOIN_LABEL;
+    dispatch_table[THREAD_MUTEX] = &&THREAD_MUTEX_LABEL;
+    dispatch_table[CRITICAL_START] = &&CRITICAL_START_LABEL;
+    dispatch_table[CRITICAL_END] = &&CRITICAL_END_LABEL;
+    dispatch_table[NEW_BYTE_ARY] = &&NEW_BYTE_ARY_LABEL;
+    dispatch_table[NEW_CHAR_ARY] = &&NEW_CHAR_ARY_LABEL;
+    dispatch_table[NEW_INT_ARY] = &&NEW_INT_ARY_LABEL;
+    dispatch_table[NEW_FLOAT_ARY] = &&NEW_FLOAT_ARY_LABEL;
+    dispatch_table[NEW_OBJ_INST] = &&NEW_OBJ_INST_LABEL;
+    dispatch_table[NEW_FUNC_INST] = &&NEW_FUNC_INST_LABEL;
+    dispatch_table[STOR_BYTE_ARY_ELM] = &&STOR_BYTE_ARY_ELM_LABEL;
+    dispatch_table[STOR_CHAR_ARY_ELM] = &&STOR_CHAR_ARY_ELM_LABEL;
+    dispatch_table[LOAD_BYTE_ARY_ELM] = &&LOAD_BYTE_ARY_ELM_LABEL;
+    dispatch_table[LOAD_CHAR_ARY_ELM] = &&LOAD_CHAR_ARY_ELM_LABEL;
+    dispatch_table[STOR_INT_ARY_ELM] = &&STOR_INT_ARY_ELM_LABEL;
+    dispatch_table[LOAD_INT_ARY_ELM] = &&LOAD_INT_ARY_ELM_LABEL;
+    dispatch_table[STOR_FLOAT_ARY_ELM] = &&STOR_FLOAT_ARY_ELM_LABEL;
+    dispatch_table[LOAD_FLOAT_ARY_ELM] = &&LOAD_FLOAT_ARY_ELM_LABEL;
+    dispatch_table[THREAD_SLEEP] = &&THREAD_SLEEP_LABEL;
+    dispatch_table[LOAD_CLS_MEM] = &&LOAD_CLS_MEM_LABEL;
+    dispatch_table[LOAD_INST_MEM] = &&LOAD_INST_MEM_LABEL;
+    dispatch_table[EXT_LIB_LOAD] = &&EXT_LIB_LOAD_LABEL;
+    dispatch_table[EXT_LIB_UNLOAD] = &&EXT_LIB_UNLOAD_LABEL;
+    dispatch_table[EXT_LIB_FUNC_CALL] = &&EXT_LIB_FUNC_CALL_LABEL;
+    dispatch_table[TRAP] = &&TRAP_LABEL;
+    dispatch_table[TRAP_RTRN] = &&TRAP_RTRN_LABEL;
+    dispatch_table[END_STMTS] = &&END_STMTS_LABEL;
+    dispatch_ready = true;
+  }
+#endif
+
   // execute
+  StackInstr* instr;
   halt = false;
   do {
-    StackInstr* instr = instrs[ip++];
+    instr = instrs + ip++;
     
 #ifdef _DEBUGGER
     debugger->ProcessInstruction(instr, ip, call_stack, (*call_stack_pos), (*frame));
 #endif
     
+#ifdef _THREADED
+  dispatch_switch:
+#endif
     switch(instr->GetType()) {
-    case STOR_LOCL_INT_VAR:
+    DISPATCH_CASE(STOR_LOCL_INT_VAR):
       StorLoclIntVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case STOR_CLS_INST_INT_VAR:
+    DISPATCH_CASE(STOR_CLS_INST_INT_VAR):
       StorClsInstIntVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case STOR_FUNC_VAR:
+    DISPATCH_CASE(STOR_FUNC_VAR):
       ProcessStoreFunctionVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case STOR_FLOAT_VAR:
+    DISPATCH_CASE(STOR_FLOAT_VAR):
       ProcessStoreFloat(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case COPY_LOCL_INT_VAR:
+    DISPATCH_CASE(COPY_LOCL_INT_VAR):
       CopyLoclIntVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case COPY_CLS_INST_INT_VAR:
+    DISPATCH_CASE(COPY_CLS_INST_INT_VAR):
       CopyClsInstIntVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case COPY_FLOAT_VAR:
+    DISPATCH_CASE(COPY_FLOAT_VAR):
       ProcessCopyFloat(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
     
-    case LOAD_CHAR_LIT:
+    DISPATCH_CASE(LOAD_CHAR_LIT):
 #ifdef _DEBUG
       std::wcout << L"stack oper: LOAD_INT_LIT; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PushInt(instr->GetOperand(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_INT_LIT:
+    DISPATCH_CASE(LOAD_INT_LIT):
 #ifdef _DEBUG
       std::wcout << L"stack oper: LOAD_INT_LIT; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PushInt(instr->GetInt64Operand(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case SHL_INT:
+    DISPATCH_CASE(SHL_INT):
       ShlInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case SHR_INT:
+    DISPATCH_CASE(SHR_INT):
       ShrInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_FLOAT_LIT:
+    DISPATCH_CASE(LOAD_FLOAT_LIT):
 #ifdef _DEBUG
       std::wcout << L"stack oper: LOAD_FLOAT_LIT; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PushFloat(instr->GetFloatOperand(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_LOCL_INT_VAR:
+    DISPATCH_CASE(LOAD_LOCL_INT_VAR):
       LoadLoclIntVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case LOAD_CLS_INST_INT_VAR:
+    DISPATCH_CASE(LOAD_CLS_INST_INT_VAR):
       LoadClsInstIntVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
+
+      // superinstructions, skip the instructions they replace
+    DISPATCH_CASE(LOAD_SELF_INT_VAR):
+      LoadSelfIntVar(instr, op_stack, stack_pos);
+      ip++;
+      DISPATCH();
+
+    DISPATCH_CASE(INC_LOCL_INT_VAR):
+      IncLoclIntVar(instr);
+      ip += 3;
+      DISPATCH();
+
+    DISPATCH_CASE(CMP_JMP_LOCL_INT_VAR):
+      CmpJmpLoclIntVar(instr, ip, op_stack, stack_pos);
+      DISPATCH();
       
-    case LOAD_FUNC_VAR:
+    DISPATCH_CASE(LOAD_FUNC_VAR):
       ProcessLoadFunctionVar(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_FLOAT_VAR:
+    DISPATCH_CASE(LOAD_FLOAT_VAR):
       ProcessLoadFloat(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case AND_INT:
+    DISPATCH_CASE(AND_INT):
       AndInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case OR_INT:
+    DISPATCH_CASE(OR_INT):
       OrInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ADD_INT:
+    DISPATCH_CASE(ADD_INT):
       AddInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ADD_FLOAT:
+    DISPATCH_CASE(ADD_FLOAT):
       AddFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case SUB_INT:
+    DISPATCH_CASE(SUB_INT):
       SubInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case SUB_FLOAT:
+    DISPATCH_CASE(SUB_FLOAT):
       SubFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case MUL_INT:
+    DISPATCH_CASE(MUL_INT):
       MulInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case DIV_INT:
+    DISPATCH_CASE(DIV_INT):
       DivInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case MUL_FLOAT:
+    DISPATCH_CASE(MUL_FLOAT):
       MulFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case DIV_FLOAT:
+    DISPATCH_CASE(DIV_FLOAT):
       DivFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case MOD_INT:
+    DISPATCH_CASE(MOD_INT):
       ModInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case BIT_AND_INT:
+    DISPATCH_CASE(BIT_AND_INT):
       BitAndInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case BIT_OR_INT:
+    DISPATCH_CASE(BIT_OR_INT):
       BitOrInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case BIT_XOR_INT:
+    DISPATCH_CASE(BIT_XOR_INT):
       BitXorInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LES_EQL_INT:
+    DISPATCH_CASE(LES_EQL_INT):
       LesEqlInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case GTR_EQL_INT:
+    DISPATCH_CASE(GTR_EQL_INT):
       GtrEqlInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LES_EQL_FLOAT:
+    DISPATCH_CASE(LES_EQL_FLOAT):
       LesEqlFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case GTR_EQL_FLOAT:
+    DISPATCH_CASE(GTR_EQL_FLOAT):
       GtrEqlFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case EQL_INT:
+    DISPATCH_CASE(EQL_INT):
       EqlInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEQL_INT:
+    DISPATCH_CASE(NEQL_INT):
       NeqlInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LES_INT:
+    DISPATCH_CASE(LES_INT):
       LesInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case GTR_INT:
+    DISPATCH_CASE(GTR_INT):
       GtrInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case EQL_FLOAT:
+    DISPATCH_CASE(EQL_FLOAT):
       EqlFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEQL_FLOAT:
+    DISPATCH_CASE(NEQL_FLOAT):
       NeqlFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LES_FLOAT:
+    DISPATCH_CASE(LES_FLOAT):
       LesFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case GTR_FLOAT:
+    DISPATCH_CASE(GTR_FLOAT):
       GtrFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_ARY_SIZE:
+    DISPATCH_CASE(LOAD_ARY_SIZE):
       LoadArySize(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CPY_BYTE_ARY:
+    DISPATCH_CASE(CPY_BYTE_ARY):
       CpyByteAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CPY_CHAR_ARY:
+    DISPATCH_CASE(CPY_CHAR_ARY):
       CpyCharAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CPY_INT_ARY:
+    DISPATCH_CASE(CPY_INT_ARY):
       CpyIntAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CPY_FLOAT_ARY:
+    DISPATCH_CASE(CPY_FLOAT_ARY):
       CpyFloatAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ZERO_BYTE_ARY:
+    DISPATCH_CASE(ZERO_BYTE_ARY):
       ZeroByteAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ZERO_CHAR_ARY:
+    DISPATCH_CASE(ZERO_CHAR_ARY):
       ZeroCharAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ZERO_INT_ARY:
+    DISPATCH_CASE(ZERO_INT_ARY):
       ZeroIntAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ZERO_FLOAT_ARY:
+    DISPATCH_CASE(ZERO_FLOAT_ARY):
       ZeroFloatAry(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CEIL_FLOAT:
+    DISPATCH_CASE(CEIL_FLOAT):
       PushFloat(ceil(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case TRUNC_FLOAT:
+    DISPATCH_CASE(TRUNC_FLOAT):
       PushFloat(trunc(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case FLOR_FLOAT:
+    DISPATCH_CASE(FLOR_FLOAT):
       PushFloat(floor(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case SIN_FLOAT:
+    DISPATCH_CASE(SIN_FLOAT):
       PushFloat(sin(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case COS_FLOAT:
+    DISPATCH_CASE(COS_FLOAT):
       PushFloat(cos(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case TAN_FLOAT:
+    DISPATCH_CASE(TAN_FLOAT):
       PushFloat(tan(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ASIN_FLOAT:
+    DISPATCH_CASE(ASIN_FLOAT):
       PushFloat(asin(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ACOS_FLOAT:
+    DISPATCH_CASE(ACOS_FLOAT):
       PushFloat(acos(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ATAN_FLOAT:
+    DISPATCH_CASE(ATAN_FLOAT):
       PushFloat(atan(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOG2_FLOAT:
+    DISPATCH_CASE(LOG2_FLOAT):
       PushFloat(log2(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CBRT_FLOAT:
+    DISPATCH_CASE(CBRT_FLOAT):
       PushFloat(cbrt(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
     
-    case LOG_FLOAT:
+    DISPATCH_CASE(LOG_FLOAT):
       PushFloat(log(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ROUND_FLOAT:
+    DISPATCH_CASE(ROUND_FLOAT):
       PushFloat(round(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case EXP_FLOAT:
+    DISPATCH_CASE(EXP_FLOAT):
       PushFloat(exp(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOG10_FLOAT:
+    DISPATCH_CASE(LOG10_FLOAT):
       PushFloat(log10(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case SQRT_FLOAT:
+    DISPATCH_CASE(SQRT_FLOAT):
       PushFloat(sqrt(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case GAMMA_FLOAT:
+    DISPATCH_CASE(GAMMA_FLOAT):
       PushFloat(tgamma(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NAN_INT:
+    DISPATCH_CASE(NAN_INT):
       PushFloat(std::numeric_limits<INT_VALUE>::quiet_NaN(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case INF_INT:
+    DISPATCH_CASE(INF_INT):
       PushFloat(std::numeric_limits<INT_VALUE>::infinity(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEG_INF_INT:
+    DISPATCH_CASE(NEG_INF_INT):
       PushFloat(-1 * std::numeric_limits<INT_VALUE>::infinity(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NAN_FLOAT:
+    DISPATCH_CASE(NAN_FLOAT):
       PushFloat(std::numeric_limits<double>::quiet_NaN(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case INF_FLOAT:
+    DISPATCH_CASE(INF_FLOAT):
       PushFloat(std::numeric_limits<double>::infinity(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEG_INF_FLOAT:
+    DISPATCH_CASE(NEG_INF_FLOAT):
       PushFloat(-1.0 * std::numeric_limits<double>::infinity(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case RAND_FLOAT:
+    DISPATCH_CASE(RAND_FLOAT):
       PushFloat(GetRandomValue(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ACOSH_FLOAT:
+    DISPATCH_CASE(ACOSH_FLOAT):
       PushFloat(acosh(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ASINH_FLOAT:
+    DISPATCH_CASE(ASINH_FLOAT):
       PushFloat(asinh(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ATANH_FLOAT:
+    DISPATCH_CASE(ATANH_FLOAT):
       PushFloat(atanh(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case COSH_FLOAT:
+    DISPATCH_CASE(COSH_FLOAT):
       PushFloat(cosh(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case SINH_FLOAT:
+    DISPATCH_CASE(SINH_FLOAT):
       PushFloat(sinh(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case TANH_FLOAT:
+    DISPATCH_CASE(TANH_FLOAT):
       PushFloat(tanh(PopFloat(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
 
 
-    case ATAN2_FLOAT:
+    DISPATCH_CASE(ATAN2_FLOAT):
       left_double = *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 2]));
       right_double = *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 1]));
       *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 2])) = atan2(left_double, right_double);
       (*stack_pos)--;
-      break;
+      DISPATCH();
 
-    case MOD_FLOAT:
+    DISPATCH_CASE(MOD_FLOAT):
       left_double = *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 2]));
       right_double = *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 1]));
       *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 2])) = fmod(left_double, right_double);
       (*stack_pos)--;
-      break;
+      DISPATCH();
       
-    case POW_FLOAT:
+    DISPATCH_CASE(POW_FLOAT):
       left_double = *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 2]));
       right_double = *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 1]));
       *((FLOAT_VALUE*)(&op_stack[(*stack_pos) - 2])) = pow(left_double, right_double);
       (*stack_pos)--;
-      break;
+      DISPATCH();
 
-    case I2F:
+    DISPATCH_CASE(I2F):
 #ifdef _DEBUG
       std::wcout << L"stack oper: I2F; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PushFloat((double)((INT64_VALUE)PopInt(op_stack, stack_pos)), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case F2I:
+    DISPATCH_CASE(F2I):
 #ifdef _DEBUG
       std::wcout << L"stack oper: F2I; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PushInt((INT64_VALUE)PopFloat(op_stack, stack_pos), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case S2I:
+    DISPATCH_CASE(S2I):
       Str2Int(op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case S2F:
+    DISPATCH_CASE(S2F):
       Str2Float(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case I2S:
+    DISPATCH_CASE(I2S):
       Int2Str(op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case F2S:
+    DISPATCH_CASE(F2S):
       Float2Str(op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case SWAP_INT:
+    DISPATCH_CASE(SWAP_INT):
 #ifdef _DEBUG
       std::wcout << L"stack oper: SWAP_INT; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       SwapInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case POP_INT:
+    DISPATCH_CASE(POP_INT):
 #ifdef _DEBUG
       std::wcout << L"stack oper: PopInt; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PopInt(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case POP_FLOAT:
+    DISPATCH_CASE(POP_FLOAT):
 #ifdef _DEBUG
       std::wcout << L"stack oper: POP_FLOAT; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PopFloat(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case RTRN:
+    DISPATCH_CASE(RTRN):
       ProcessReturn(instrs, ip);
       // return directly back to JIT code
       if((*frame) && (*frame)->jit_called) {
@@ -568,9 +737,10 @@ void StackInterpreter::Execute(size_t* op_stack, long* stack_pos, long i, StackM
         ReleaseStackFrame(*frame);
         return;
       }
-      break;
+      DISPATCH();
 
-    case DYN_MTHD_CALL:
+    DISPATCH_CASE(DYN_MTHD_CALL):
+      MemoryManager::SafepointPoll();
       ProcessDynamicMethodCall(instr, instrs, ip, op_stack, stack_pos);
       // return directly back to JIT code
       if((*frame)->jit_called) {
@@ -578,9 +748,10 @@ void StackInterpreter::Execute(size_t* op_stack, long* stack_pos, long i, StackM
         ReleaseStackFrame(*frame);
         return;
       }
-      break;
+      DISPATCH();
 
-    case MTHD_CALL:
+    DISPATCH_CASE(MTHD_CALL):
+      MemoryManager::SafepointPoll();
       ProcessMethodCall(instr, instrs, ip, op_stack, stack_pos);
       // return directly back to JIT code
       if((*frame)->jit_called) {
@@ -588,109 +759,114 @@ void StackInterpreter::Execute(size_t* op_stack, long* stack_pos, long i, StackM
         ReleaseStackFrame(*frame);
         return;
       }
-      break;
+      DISPATCH();
 
-    case JMP:
+    DISPATCH_CASE(JMP):
 #ifdef _DEBUG
       std::wcout << L"stack oper: JMP; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
-      if(instr->GetOperand2() < 0) {
-        ip = instr->GetOperand();
+      if(instr->GetOperand2() < 0 || (INT64_VALUE)PopInt(op_stack, stack_pos) == instr->GetOperand2()) {
+        // poll and count backward jumps
+        if(instr->GetOperand() < ip) {
+          MemoryManager::SafepointPoll();
+          ip = ProcessLoopJump(instr->GetOperand(), op_stack, stack_pos);
+        }
+        else {
+          ip = instr->GetOperand();
+        }
       }
-      else if((INT64_VALUE)PopInt(op_stack, stack_pos) == instr->GetOperand2()) {
-        ip = instr->GetOperand();
-      }      
-      break;
+      DISPATCH();
 
-    case OBJ_TYPE_OF:
+    DISPATCH_CASE(OBJ_TYPE_OF):
       ObjTypeOf(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case OBJ_INST_CAST:
+    DISPATCH_CASE(OBJ_INST_CAST):
       ObjInstCast(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case ASYNC_MTHD_CALL:
+    DISPATCH_CASE(ASYNC_MTHD_CALL):
       AsyncMthdCall(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case THREAD_JOIN:
+    DISPATCH_CASE(THREAD_JOIN):
       ThreadJoin(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case THREAD_MUTEX:
+    DISPATCH_CASE(THREAD_MUTEX):
       ThreadMutex(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CRITICAL_START:
+    DISPATCH_CASE(CRITICAL_START):
       CriticalStart(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case CRITICAL_END:
+    DISPATCH_CASE(CRITICAL_END):
       CriticalEnd(op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEW_BYTE_ARY:
+    DISPATCH_CASE(NEW_BYTE_ARY):
       ProcessNewByteArray(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEW_CHAR_ARY:
+    DISPATCH_CASE(NEW_CHAR_ARY):
       ProcessNewCharArray(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case NEW_INT_ARY:
+    DISPATCH_CASE(NEW_INT_ARY):
       ProcessNewArray(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEW_FLOAT_ARY:
+    DISPATCH_CASE(NEW_FLOAT_ARY):
       ProcessNewArray(instr, op_stack, stack_pos, true);
-      break;
+      DISPATCH();
 
-    case NEW_OBJ_INST:
+    DISPATCH_CASE(NEW_OBJ_INST):
       ProcessNewObjectInstance(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case NEW_FUNC_INST:
+    DISPATCH_CASE(NEW_FUNC_INST):
       ProcessNewFunctionInstance(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case STOR_BYTE_ARY_ELM:
+    DISPATCH_CASE(STOR_BYTE_ARY_ELM):
       ProcessStoreByteArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case STOR_CHAR_ARY_ELM:
+    DISPATCH_CASE(STOR_CHAR_ARY_ELM):
       ProcessStoreCharArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case LOAD_BYTE_ARY_ELM:
+    DISPATCH_CASE(LOAD_BYTE_ARY_ELM):
       ProcessLoadByteArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case LOAD_CHAR_ARY_ELM:
+    DISPATCH_CASE(LOAD_CHAR_ARY_ELM):
       ProcessLoadCharArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case STOR_INT_ARY_ELM:
+    DISPATCH_CASE(STOR_INT_ARY_ELM):
       ProcessStoreIntArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_INT_ARY_ELM:
+    DISPATCH_CASE(LOAD_INT_ARY_ELM):
       ProcessLoadIntArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case STOR_FLOAT_ARY_ELM:
+    DISPATCH_CASE(STOR_FLOAT_ARY_ELM):
       ProcessStoreFloatArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_FLOAT_ARY_ELM:
+    DISPATCH_CASE(LOAD_FLOAT_ARY_ELM):
       ProcessLoadFloatArrayElement(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case THREAD_SLEEP:
+    DISPATCH_CASE(THREAD_SLEEP):
 #ifdef _DEBUG
       std::wcout << L"stack oper: THREAD_SLEEP; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
 
+      MemoryManager::EnterSafeRegion();
 #ifdef _WIN32
       left = (INT64_VALUE)PopInt(op_stack, stack_pos);
       Sleep((long)left);
@@ -698,37 +874,38 @@ void StackInterpreter::Execute(size_t* op_stack, long* stack_pos, long i, StackM
       left = PopInt(op_stack, stack_pos);
       usleep(left * 1000);
 #endif
-      break;
+      MemoryManager::LeaveSafeRegion();
+      DISPATCH();
 
-    case LOAD_CLS_MEM:
+    DISPATCH_CASE(LOAD_CLS_MEM):
 #ifdef _DEBUG
       std::wcout << L"stack oper: LOAD_CLS_MEM; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PushInt((size_t)(*frame)->method->GetClass()->GetClassMemory(), op_stack, stack_pos);
-      break;
+      DISPATCH();
 
-    case LOAD_INST_MEM:
+    DISPATCH_CASE(LOAD_INST_MEM):
 #ifdef _DEBUG
       std::wcout << L"stack oper: LOAD_INST_MEM; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
       PushInt((*frame)->mem[0], op_stack, stack_pos);
-      break;
+      DISPATCH();
 
       // shared library support
-    case EXT_LIB_LOAD:
+    DISPATCH_CASE(EXT_LIB_LOAD):
       SharedLibraryLoad(instr);
-      break;
+      DISPATCH();
 
-    case EXT_LIB_UNLOAD:
+    DISPATCH_CASE(EXT_LIB_UNLOAD):
       SharedLibraryUnload(instr);
-      break;
+      DISPATCH();
 
-    case EXT_LIB_FUNC_CALL:
+    DISPATCH_CASE(EXT_LIB_FUNC_CALL):
       SharedLibraryCall(instr, op_stack, stack_pos);
-      break;
+      DISPATCH();
       
-    case TRAP:
-    case TRAP_RTRN:
+    DISPATCH_CASE(TRAP):
+    DISPATCH_CASE(TRAP_RTRN):
 #ifdef _DEBUG
       std::wcout << L"stack oper: TRAP; call_pos=" << (*call_stack_pos) << std::endl;
 #endif
@@ -741,11 +918,11 @@ void StackInterpreter::Execute(size_t* op_stack, long* stack_pos, long i, StackM
         exit(1);
 #endif
       }
-      break;
+      DISPATCH();
 
       // note: just for debugger
-    case END_STMTS:
-      break;
+    DISPATCH_CASE(END_STMTS):
+      DISPATCH();
 
     default:
       break;
@@ -788,7 +965,9 @@ void StackInterpreter::StorClsInstIntVar(StackInstr* instr, size_t* &op_stack, l
   }
   size_t mem = op_stack[(*stack_pos) - 2];
   (*stack_pos) -= 2;
+  MemoryManager::SatbBarrier(cls_inst_mem + instr->GetOperand());
   cls_inst_mem[instr->GetOperand()] = mem;
+  MemoryManager::WriteBarrier(cls_inst_mem + instr->GetOperand());
 }
 
 void StackInterpreter::CopyLoclIntVar(StackInstr* instr, size_t* &op_stack, long* &stack_pos)
@@ -817,7 +996,9 @@ void StackInterpreter::CopyClsInstIntVar(StackInstr* instr, size_t* &op_stack, l
     exit(1);
 #endif
   }
+  MemoryManager::SatbBarrier(cls_inst_mem + instr->GetOperand());
   cls_inst_mem[instr->GetOperand()] = TopInt(op_stack, stack_pos);
+  MemoryManager::WriteBarrier(cls_inst_mem + instr->GetOperand());
 }
 
 void StackInterpreter::Str2Int(size_t* &op_stack, long* &stack_pos)
@@ -1117,6 +1298,88 @@ void StackInterpreter::LoadClsInstIntVar(StackInstr* instr, size_t* &op_stack, l
   op_stack[(*stack_pos) - 1] = cls_inst_mem[instr->GetOperand()];
 }
 
+//
+// superinstructions, operands of the replaced instructions
+// are read from the ones that follow
+//
+void StackInterpreter::LoadSelfIntVar(StackInstr* instr, size_t* &op_stack, long* &stack_pos)
+{
+#ifdef _DEBUG
+  std::wcout << L"stack oper: LOAD_SELF_INT_VAR; index=" << instr->GetOperand() << std::endl;
+#endif
+  size_t* cls_inst_mem = (size_t*)(*frame)->mem[0];
+  if(!cls_inst_mem) {
+    std::wcerr << L">>> Attempting to dereference a 'Nil' memory instance <<<" << std::endl;
+    StackErrorUnwind();
+#ifdef _NO_HALT
+    halt = true;
+    return;
+#else
+    exit(1);
+#endif
+  }
+  PushInt(cls_inst_mem[instr->GetOperand()], op_stack, stack_pos);
+}
+
+void StackInterpreter::IncLoclIntVar(StackInstr* instr)
+{
+#ifdef _DEBUG
+  std::wcout << L"stack oper: INC_LOCL_INT_VAR; index=" << instr->GetOperand() << std::endl;
+#endif
+  size_t* mem = (*frame)->mem;
+  mem[instr->GetOperand() + 1] += (size_t)instr[1].GetInt64Operand();
+}
+
+void StackInterpreter::CmpJmpLoclIntVar(StackInstr* instr, long &ip, size_t* &op_stack, long* &stack_pos)
+{
+#ifdef _DEBUG
+  std::wcout << L"stack oper: CMP_JMP_LOCL_INT_VAR; index=" << instr->GetOperand() << std::endl;
+#endif
+  size_t* mem = (*frame)->mem;
+  const INT64_VALUE right = (INT64_VALUE)mem[instr->GetOperand() + 1];
+  const INT64_VALUE left = (INT64_VALUE)mem[instr[1].GetOperand() + 1];
+
+  bool value;
+  switch(instr[2].GetType()) {
+  case EQL_INT:
+    value = left == right;
+    break;
+
+  case NEQL_INT:
+    value = left != right;
+    break;
+
+  case LES_INT:
+    value = left < right;
+    break;
+
+  case GTR_INT:
+    value = left > right;
+    break;
+
+  case LES_EQL_INT:
+    value = left <= right;
+    break;
+
+  default:
+    value = left >= right;
+    break;
+  }
+
+  StackInstr* jmp_instr = instr + 3;
+  ip += 3;
+  if((INT64_VALUE)value == jmp_instr->GetOperand2()) {
+    // poll and count backward jumps
+    if(jmp_instr->GetOperand() < ip) {
+      MemoryManager::SafepointPoll();
+      ip = ProcessLoopJump(jmp_instr->GetOperand(), op_stack, stack_pos);
+    }
+    else {
+      ip = jmp_instr->GetOperand();
+    }
+  }
+}
+
 void StackInterpreter::AndInt(size_t* &op_stack, long* &stack_pos)
 {
 #ifdef _DEBUG
@@ -1549,6 +1812,7 @@ void StackInterpreter::CpyIntAry(size_t* &op_stack, long* &stack_pos)
   if(length > 0 && src_offset + length <= src_array_len && dest_offset + length <= dest_array_len) {
     size_t* src_array_ptr = src_array + 3;
     size_t* dest_array_ptr = dest_array + 3;
+    MemoryManager::WriteBarrierObject(dest_array);
     if(src_array_ptr == dest_array_ptr) {
       memmove(dest_array_ptr + dest_offset, src_array_ptr + src_offset, length * sizeof(size_t));
     }
@@ -1623,6 +1887,7 @@ void StackInterpreter::ZeroIntAry(size_t*& op_stack, long*& stack_pos)
   size_t* array_ptr = (size_t*)PopInt(op_stack, stack_pos);
   const size_t array_len = array_ptr[0];
   size_t* buffer = (size_t*)(array_ptr + 3);
+  MemoryManager::WriteBarrierObject(array_ptr);
   memset(buffer, 0, array_len * sizeof(size_t));
 }
 
@@ -1734,11 +1999,13 @@ void StackInterpreter::ThreadJoin(size_t* &op_stack, long* &stack_pos)
 #endif
   }
 
+  MemoryManager::EnterSafeRegion();
 #ifdef _WIN32
   HANDLE vm_thread = (HANDLE)instance[0];
   if(WaitForSingleObject(vm_thread, INFINITE) != WAIT_OBJECT_0) {
     std::wcerr << L">>> Unable to join thread! <<<" << std::endl;
 #ifdef _NO_HALT
+    MemoryManager::LeaveSafeRegion();
     return;
 #else
     exit(1);
@@ -1750,12 +2017,14 @@ void StackInterpreter::ThreadJoin(size_t* &op_stack, long* &stack_pos)
   if(pthread_join(vm_thread, &status)) {
     std::wcerr << L">>> Unable to join thread! <<<" << std::endl;
 #ifdef _NO_HALT
+    MemoryManager::LeaveSafeRegion();
     return;
 #else
     exit(1);
 #endif
   }
 #endif
+  MemoryManager::LeaveSafeRegion();
 }
 
 void StackInterpreter::ThreadMutex(size_t* &op_stack, long* &stack_pos)
@@ -1797,11 +2066,13 @@ void StackInterpreter::CriticalStart(size_t* &op_stack, long* &stack_pos)
     exit(1);
 #endif        
   }
+  MemoryManager::EnterSafeRegion();
 #ifdef _WIN32
   EnterCriticalSection((CRITICAL_SECTION*)&instance[1]);
 #else
   pthread_mutex_lock((pthread_mutex_t*)&instance[1]);
 #endif
+  MemoryManager::LeaveSafeRegion();
 }
 
 void StackInterpreter::CriticalEnd(size_t* &op_stack, long* &stack_pos)
@@ -1915,8 +2186,10 @@ void StackInterpreter::ProcessStoreFunctionVar(StackInstr* instr, size_t* &op_st
       exit(1);
 #endif
     }
+    MemoryManager::SatbBarrier(cls_inst_mem + instr->GetOperand() + 1);
     cls_inst_mem[instr->GetOperand()] = PopInt(op_stack, stack_pos);
     cls_inst_mem[instr->GetOperand() + 1] = PopInt(op_stack, stack_pos);
+    MemoryManager::WriteBarrier(cls_inst_mem + instr->GetOperand() + 1);
   }
 }
 
@@ -2099,7 +2372,7 @@ void StackInterpreter::ProcessNewCharArray(StackInstr* instr, size_t* &op_stack,
  * Processes a return instruction, 
  * this modifies the call std::stack.
  ********************************/
-void StackInterpreter::ProcessReturn(StackInstr** &instrs, long &ip)
+void StackInterpreter::ProcessReturn(StackInstr* &instrs, long &ip)
 {
 #ifdef _DEBUG
   std::wcout << L"stack oper: RTRN; call_pos=" << (*call_stack_pos) << std::endl;
@@ -2115,7 +2388,7 @@ void StackInterpreter::ProcessReturn(StackInstr** &instrs, long &ip)
   // restore previous frame
   if(!StackEmpty()) {
     (*frame) = PopFrame();
-    instrs = (*frame)->method->GetInstructions();
+    instrs = (*frame)->method->GetCode();
     ip = (*frame)->ip;
   } 
   else {
@@ -2191,7 +2464,9 @@ unsigned int WINAPI StackInterpreter::AsyncMethodCall(LPVOID arg)
 
   Runtime::StackInterpreter* intpr = new Runtime::StackInterpreter;
   AddThread(intpr);
+  MemoryManager::AddMutator(thread_op_stack, thread_stack_pos, OP_STACK_SIZE);
   intpr->Execute(thread_op_stack, thread_stack_pos, 0, holder->called, holder->self, false);
+  MemoryManager::RemoveMutator();
   
 #ifdef _DEBUG
   std::wcout << L"# final std::stack: pos=" << (*thread_stack_pos) << L", thread=" << vm_thread << L" #" << std::endl;
@@ -2235,7 +2510,9 @@ void* StackInterpreter::AsyncMethodCall(void* arg)
 
   Runtime::StackInterpreter* intpr = new Runtime::StackInterpreter;
   AddThread(intpr);
+  MemoryManager::AddMutator(thread_op_stack, thread_stack_pos, OP_STACK_SIZE);
   intpr->Execute(thread_op_stack, thread_stack_pos, 0, holder->called, holder->self, false);
+  MemoryManager::RemoveMutator();
 
 #ifdef _DEBUG
   std::wcout << L"# final std::stack: pos=" << (*thread_stack_pos) << L", thread=" << pthread_self() << L" #" << std::endl;
@@ -2262,7 +2539,7 @@ void* StackInterpreter::AsyncMethodCall(void* arg)
 /********************************
  * Processes a synchronous dynamic method call.
  ********************************/
-void StackInterpreter::ProcessDynamicMethodCall(StackInstr* instr, StackInstr** &instrs, long &ip, size_t* &op_stack, long* &stack_pos)
+void StackInterpreter::ProcessDynamicMethodCall(StackInstr* instr, StackInstr* &instrs, long &ip, size_t* &op_stack, long* &stack_pos)
 {
   // save current method
   (*frame)->ip = ip;
@@ -2291,13 +2568,13 @@ void StackInterpreter::ProcessDynamicMethodCall(StackInstr* instr, StackInstr**
 
 #ifndef _NO_JIT
   // execute JIT call
-  if(instr->GetOperand3()) {
+  if(IsJitCall(instr, called)) {
     ProcessJitMethodCall(called, instance, instrs, ip, op_stack, stack_pos);
   }
   // execute interpreter
   else {
     (*frame) = GetStackFrame(called, instance);    
-    instrs = (*frame)->method->GetInstructions();
+    instrs = (*frame)->method->GetCode();
     ip = 0;
   }
 #else
@@ -2308,7 +2585,7 @@ void StackInterpreter::ProcessDynamicMethodCall(StackInstr* instr, StackInstr**
 /********************************
  * Processes a synchronous method call.
  ********************************/
-void StackInterpreter::ProcessMethodCall(StackInstr* instr, StackInstr** &instrs, long &ip, size_t* &op_stack, long* &stack_pos)
+void StackInterpreter::ProcessMethodCall(StackInstr* instr, StackInstr* &instrs, long &ip, size_t* &op_stack, long* &stack_pos)
 {
   // save current method
   (*frame)->ip = ip;
@@ -2334,32 +2611,12 @@ void StackInterpreter::ProcessMethodCall(StackInstr* instr, StackInstr** &instrs
 #endif
     }
 
-    StackMethod* virtual_call = concrete_class->GetVirtualMethod(instr->GetOperand(), instr->GetOperand2());
-    if(!virtual_call) {
-      // binding method
-      const std::wstring qualified_method_name = concrete_call->GetName();
-      const std::wstring method_ending = qualified_method_name.substr(qualified_method_name.find(L':'));
-
-      // check method cache
-      std::wstring method_name = concrete_class->GetName() + method_ending;
-      virtual_call = concrete_class->GetMethod(method_name);
-      while(!virtual_call) {
-        concrete_class = concrete_class->GetParent();
-        method_name = concrete_class->GetName() + method_ending;
-        virtual_call = concrete_class->GetMethod(method_name);
-      }
-      // bind method call
-      concrete_class->AddVirutalMethod(instr->GetOperand(), instr->GetOperand2(), virtual_call);
-    }
-#ifdef _DEBUG
-    assert(virtual_call);
-#endif
-    concrete_call = virtual_call;
+    concrete_call = BindVirtualCall(instr, concrete_call, concrete_class);
   }
 
 #ifndef _NO_JIT
   // execute JIT call
-  if(instr->GetOperand3()) {
+  if(IsJitCall(instr, concrete_call)) {
     ProcessJitMethodCall(concrete_call, instance, instrs, ip, op_stack, stack_pos);
   }
   // execute interpreter
@@ -2371,30 +2628,64 @@ void StackInterpreter::ProcessMethodCall(StackInstr* instr, StackInstr** &instrs
 #endif
 }
 
+/********************************
+ * Binds a virtual method call to
+ * the instance's class, cached
+ * per call site
+ ********************************/
+StackMethod* StackInterpreter::BindVirtualCall(StackInstr* instr, StackMethod* concrete_call, StackClass* concrete_class)
+{
+  // check the call site's inline cache
+  InlineCache* inline_cache = instr->GetInlineCache();
+  if(inline_cache) {
+    StackMethod* cached_call = inline_cache->GetMethod(concrete_class);
+    if(cached_call) {
+      return cached_call;
+    }
+  }
+
+  StackClass* receiver_class = concrete_class;
+  StackMethod* virtual_call = concrete_class->GetVirtualMethod(instr->GetOperand(), instr->GetOperand2());
+  if(!virtual_call) {
+    // binding method
+    const std::wstring qualified_method_name = concrete_call->GetName();
+    const std::wstring method_ending = qualified_method_name.substr(qualified_method_name.find(L':'));
+
+    // check method cache
+    std::wstring method_name = concrete_class->GetName() + method_ending;
+    virtual_call = concrete_class->GetMethod(method_name);
+    while(!virtual_call) {
+      concrete_class = concrete_class->GetParent();
+      method_name = concrete_class->GetName() + method_ending;
+      virtual_call = concrete_class->GetMethod(method_name);
+    }
+    // bind method call
+    concrete_class->AddVirutalMethod(instr->GetOperand(), instr->GetOperand2(), virtual_call);
+  }
+#ifdef _DEBUG
+  assert(virtual_call);
+#endif
+
+  if(inline_cache) {
+    inline_cache->AddMethod(receiver_class, virtual_call);
+  }
+
+  return virtual_call;
+}
+
 /********************************
  * Processes an interpreted
  * synchronous method call.
  ********************************/
-void StackInterpreter::ProcessJitMethodCall(StackMethod* called, size_t* instance, StackInstr** &instrs, long &ip, size_t* &op_stack, long* &stack_pos)
+void StackInterpreter::ProcessJitMethodCall(StackMethod* called, size_t* instance, StackInstr* &instrs, long &ip, size_t* &op_stack, long* &stack_pos)
 {
 #if defined(_DEBUGGER) || defined(_NO_JIT)
   ProcessInterpretedMethodCall(called, instance, instrs, ip);
 #else
   // compile, if needed
-  if(!called->GetNativeCode()) {    
-#if defined(_WIN64) || defined(_X64)
-    JitAmd64 jit_compiler;
-#else
-    JitArm64 jit_compiler;
-#endif
-
-    if(!jit_compiler.Compile(called)) {
-      ProcessInterpretedMethodCall(called, instance, instrs, ip);
-#ifdef _DEBUG
-      std::wcerr << L"### Unable to compile: " << called->GetName() << L" ###" << std::endl;
-#endif
-      return;
-    }
+  if(!called->GetNativeCode() && !JitCompile(called)) {
+    ProcessInterpretedMethodCall(called, instance, instrs, ip);
+    return;
   }
   
   // execute
@@ -2402,24 +2693,7 @@ void StackInterpreter::ProcessJitMethodCall(StackMethod* called, size_t* instanc
   JitRuntime jit_executor;
   const long status = jit_executor.Execute(called, instance, op_stack, stack_pos, call_stack, call_stack_pos, *frame);
   if(status < 0) {
-    switch(status) {
-    case -1:
-      std::wcerr << L">>> Attempting to dereference a 'Nil' memory instance in native JIT code <<<" << std::endl;
-      break;
-
-    case -2:
-      std::wcerr << L">>> Index under bounds in native JIT code <<<" << std::endl;
-      break;
-
-    case -3:
-      std::wcerr << L">>> Index over bounds in native JIT code <<<" << std::endl;
-      break;
-
-    case -4:
-      std::wcerr << L">>> Divide by zero in native JIT code <<<" << std::endl;
-      break;
-    }
-    StackErrorUnwind(called);
+    JitError(called, status);
 #ifdef _NO_HALT
     halt = true;
     return;
@@ -2431,23 +2705,247 @@ void StackInterpreter::ProcessJitMethodCall(StackMethod* called, size_t* instanc
   // restore previous state
   ReleaseStackFrame(*frame);
   (*frame) = PopFrame();
-  instrs = (*frame)->method->GetInstructions();
+  instrs = (*frame)->method->GetCode();
   ip = (*frame)->ip;
 #endif
 }
 
+/********************************
+ * Checks if a call runs JIT code,
+ * methods declared 'native' and
+ * methods called or looping often
+ ********************************/
+bool StackInterpreter::IsJitCall(StackInstr* instr, StackMethod* called)
+{
+  if(instr->GetOperand3() || called->GetNativeCode()) {
+    return true;
+  }
+
+  if(called->IsJitFailed()) {
+    return false;
+  }
+
+  // calls from JIT code to methods without native code go back through
+  // the interpreter, so methods that make calls are only compiled once they loop
+  if((jit_call_threshold > 0 && !called->HasCalls() && called->CountCall() >= jit_call_threshold) ||
+     (jit_loop_threshold > 0 && called->GetLoopCount() >= jit_loop_threshold)) {
+    // traps need the interpreter's frame, only compiled if declared 'native'
+    if(called->HasTraps()) {
+      called->SetJitFailed();
+      return false;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/********************************
+ * Counts a backward jump, methods
+ * that loop often continue in JIT
+ * code (on-stack replacement) and
+ * the interpreter resumes at the
+ * method's return
+ ********************************/
+long StackInterpreter::ProcessLoopJump(long target, size_t* &op_stack, long* &stack_pos)
+{
+  StackMethod* method = (*frame)->method;
+  if(jit_loop_threshold <= 0 || method->CountLoop() < jit_loop_threshold || method->IsJitFailed()) {
+    return target;
+  }
+
+#if defined(_DEBUGGER) || defined(_NO_JIT)
+  return target;
+#else
+  // traps need the interpreter's frame
+  if(method->HasTraps() || method->GetReturnIndex() < 0) {
+    method->SetJitFailed();
+    return target;
+  }
+
+  if(!method->GetNativeCode() && !JitCompile(method)) {
+    return target;
+  }
+
+  const long entry = method->GetNativeCode()->GetOsrEntry(target);
+  if(entry < 0) {
+    return target;
+  }
+
+  // run the rest of the method, its locals are copied from the frame
+  JitRuntime jit_executor;
+  const long status = jit_executor.Execute(method, (size_t*)(*frame)->mem[0], op_stack, stack_pos,
+                                           call_stack, call_stack_pos, *frame, entry);
+  if(status < 0) {
+    JitError(method, status);
+#ifdef _NO_HALT
+    halt = true;
+    return target;
+#else
+    exit(1);
+#endif
+  }
+
+  return method->GetReturnIndex();
+#endif
+}
+
+/********************************
+ * Reports an error raised in
+ * JIT code
+ ********************************/
+void StackInterpreter::JitError(StackMethod* called, const long status)
+{
+  switch(status) {
+  case -1:
+    std::wcerr << L">>> Attempting to dereference a 'Nil' memory instance in native JIT code <<<" << std::endl;
+    break;
+
+  case -2:
+    std::wcerr << L">>> Index under bounds in native JIT code <<<" << std::endl;
+    break;
+
+  case -3:
+    std::wcerr << L">>> Index over bounds in native JIT code <<<" << std::endl;
+    break;
+
+  case -4:
+    std::wcerr << L">>> Divide by zero in native JIT code <<<" << std::endl;
+    break;
+  }
+  StackErrorUnwind(called);
+}
+
+/********************************
+ * JIT compiles a method once, methods
+ * that cannot be compiled are
+ * interpreted from then on
+ ********************************/
+bool StackInterpreter::JitCompile(StackMethod* called)
+{
+#if defined(_DEBUGGER) || defined(_NO_JIT)
+  return false;
+#else
+#ifdef _WIN32
+  EnterCriticalSection(&jit_cs);
+#else
+  pthread_mutex_lock(&jit_mutex);
+#endif
+
+  bool compiled = called->GetNativeCode() != nullptr;
+  if(!compiled && !called->IsJitFailed()) {
+#if defined(_WIN64) || defined(_X64)
+    JitAmd64 jit_compiler;
+#else
+    JitArm64 jit_compiler;
+#endif
+    compiled = jit_compiler.Compile(called);
+    if(!compiled) {
+      called->SetJitFailed();
+#ifdef _DEBUG
+      std::wcerr << L"### Unable to compile: " << called->GetName() << L" ###" << std::endl;
+#endif
+    }
+  }
+
+#ifdef _WIN32
+  LeaveCriticalSection(&jit_cs);
+#else
+  pthread_mutex_unlock(&jit_mutex);
+#endif
+
+  return compiled;
+#endif
+}
+
+#ifndef _NO_JIT
+/********************************
+ * Calls a method from JIT code. Callees
+ * with native code are run directly,
+ * callees are linked once they are
+ * compiled, until then the caller
+ * runs the call in an interpreter
+ ********************************/
+bool StackInterpreter::JitMethodCall(StackInstr* instr, size_t* op_stack, long* stack_pos,
+                                     StackFrame** call_stack, long* call_stack_pos)
+{
+#ifdef _DEBUGGER
+  return false;
+#else
+  // find callee, the operands are left in place for the interpreter
+  StackMethod* called;
+  size_t* instance;
+  if(instr->GetType() == DYN_MTHD_CALL) {
+    const size_t mthd_cls_id = op_stack[(*stack_pos) - 1];
+    const long cls_id = (mthd_cls_id >> 16) & 0xFFFF;
+    const long mthd_id = mthd_cls_id & 0xFFFF;
+    instance = (size_t*)op_stack[(*stack_pos) - 2];
+    called = program->GetClass(cls_id)->GetMethod(mthd_id);
+  }
+  else {
+    instance = (size_t*)op_stack[(*stack_pos) - 1];
+    called = program->GetClass(instr->GetOperand())->GetMethod(instr->GetOperand2());
+    if(called->IsVirtual()) {
+      StackClass* concrete_class = MemoryManager::GetClass(instance);
+      if(!concrete_class) {
+        return false;
+      }
+      called = BindVirtualCall(instr, called, concrete_class);
+    }
+  }
+
+  if(!called->GetNativeCode() && (!IsJitCall(instr, called) || !JitCompile(called))) {
+    return false;
+  }
+  MemoryManager::SafepointPoll();
+
+  // pop operands
+  if(instr->GetType() == DYN_MTHD_CALL) {
+    (*stack_pos)--;
+  }
+  (*stack_pos)--;
+
+  if((*call_stack_pos) >= CALL_STACK_SIZE) {
+    std::wcerr << L">>> call std::stack bounds have been exceeded! <<<" << std::endl;
+    exit(1);
+  }
+
+  // callee's frame is on the call stack while running, so it's scanned by the collector
+  StackFrame* frame = GetStackFrame(called, instance);
+  call_stack[(*call_stack_pos)++] = frame;
+
+  JitRuntime jit_executor;
+  const long status = jit_executor.Execute(called, instance, op_stack, stack_pos, call_stack, call_stack_pos, frame);
+
+  (*call_stack_pos)--;
+  ReleaseStackFrame(frame);
+
+  if(status < 0) {
+    StackInterpreter intpr(call_stack, call_stack_pos);
+    intpr.JitError(called, status);
+#ifndef _NO_HALT
+    exit(1);
+#endif
+  }
+
+  return true;
+#endif
+}
+#endif
+
 /********************************
  * Processes an interpreted
  * synchronous method call.
  ********************************/
-void StackInterpreter::ProcessInterpretedMethodCall(StackMethod* called, size_t* instance, StackInstr** &instrs, long &ip)
+void StackInterpreter::ProcessInterpretedMethodCall(StackMethod* called, size_t* instance, StackInstr* &instrs, long &ip)
 {
 #ifdef _DEBUG
   std::wcout << L"=== MTHD_CALL: id=" << called->GetClass()->GetId() << L","
         << called->GetId() << L"; name='" << called->GetName() << L"' ===" << std::endl;
 #endif  
   (*frame) = GetStackFrame(called, instance);
-  instrs = (*frame)->method->GetInstructions();
+  instrs = (*frame)->method->GetCode();
   ip = 0;
 #ifdef _DEBUG
   std::wcout << L"creating frame=" << (*frame) << std::endl;
@@ -2515,7 +3013,9 @@ void StackInterpreter::ProcessStoreIntArrayElement(StackInstr* instr, size_t* &o
     return;
   }
 #endif
+  MemoryManager::SatbBarrier(array + index + instr->GetOperand());
   array[index + instr->GetOperand()] = PopInt(op_stack, stack_pos);
+  MemoryManager::WriteBarrier(array + index + instr->GetOperand());
 }
 
 /********************************
@@ -2935,6 +3435,17 @@ void StackInterpreter::SharedLibraryCall(StackInstr* instr, size_t* &op_stack, l
   std::wcout << L"stack oper: shared LIBRARY_FUNC_CALL; call_pos=" << (*call_stack_pos) << "; function='" << wstr << L"'" << std::endl;
 #endif
 
+  // record references native functions may overwrite during concurrent marking
+  if(MemoryManager::IsMarking() && args) {
+    MemoryManager::SatbObject(args);
+    const size_t size = args[0];
+    const size_t dim = args[1];
+    size_t* objects = args + 2 + dim;
+    for(size_t i = 0; i < size; ++i) {
+      MemoryManager::SatbObject((size_t*)objects[i]);
+    }
+  }
+
 #ifdef _WIN32
   HINSTANCE dll_handle = (HINSTANCE)instance[1];
   if(dll_handle) {
@@ -2988,27 +3499,36 @@ void StackInterpreter::SharedLibraryCall(StackInstr* instr, size_t* &op_stack, l
     (*ext_func)(context);
   }  
 #endif
+
+  // native functions may store references into their arguments
+  if(MemoryManager::IsGenerational() && args) {
+    MemoryManager::WriteBarrierObject(args);
+    const size_t size = args[0];
+    const size_t dim = args[1];
+    size_t* objects = args + 2 + dim;
+    for(size_t i = 0; i < size; ++i) {
+      MemoryManager::WriteBarrierObject((size_t*)objects[i]);
+    }
+  }
 }
 
 StackFrame* Runtime::StackInterpreter::GetStackFrame(StackMethod* method, size_t* instance)
 {
-#ifdef _WIN32
-  EnterCriticalSection(&cached_frames_cs);
-#else
-  pthread_mutex_lock(&cached_frames_mutex);
-#endif
-  if(cached_frames.empty()) {
-    // load cache
-    for(int i = 0; i < CALL_STACK_SIZE; ++i) {
-      StackFrame* frame = new StackFrame();
-      frame->mem = (size_t*)calloc(LOCAL_SIZE, sizeof(char));
-      cached_frames.push(frame);
-    }
+  // locals follow the frame, the first slot holds the instance
+  const size_t mem_size = method->GetFrameSize();
+  const size_t frame_size = sizeof(StackFrame) + mem_size;
+
+  FrameSegment* segment = frame_stack.segment;
+  if(!segment || segment->top + frame_size > segment->end) {
+    segment = NextFrameSegment();
   }
-  StackFrame* frame = cached_frames.top();
-  cached_frames.pop();
+  StackFrame* frame = (StackFrame*)segment->top;
+  segment->top += frame_size;
 
+  // only the slots used by the method are cleared
   frame->method = method;
+  frame->mem = (size_t*)(frame + 1);
+  memset(frame->mem, 0, mem_size);
   frame->mem[0] = (size_t)instance;
   frame->ip = -1;
   frame->jit_called = false;
@@ -3018,35 +3538,63 @@ StackFrame* Runtime::StackInterpreter::GetStackFrame(StackMethod* method, size_t
   std::wcout << L"fetching frame=" << frame << std::endl;
 #endif
 
-#ifdef _WIN32
-  LeaveCriticalSection(&cached_frames_cs);
-#else
-  pthread_mutex_unlock(&cached_frames_mutex);
-#endif
   return frame;
 }
 
 void Runtime::StackInterpreter::ReleaseStackFrame(StackFrame* frame)
 {
-#ifdef _WIN32
-  EnterCriticalSection(&cached_frames_cs);
-#else
-  pthread_mutex_lock(&cached_frames_mutex);
-#endif      
-
-  // load cache
-  frame->jit_mem = nullptr;
-  memset(frame->mem, 0, LOCAL_SIZE * sizeof(char));
-  cached_frames.push(frame);
+  // the released frame becomes the top of the stack, segments holding
+  // frames above it are emptied
+  FrameSegment* segment = frame_stack.segment;
+  while((char*)frame < (char*)(segment + 1) || (char*)frame >= segment->top) {
+    segment->top = (char*)(segment + 1);
+    segment = segment->prev;
+  }
+  segment->top = (char*)frame;
+  frame_stack.segment = segment;
 #ifdef _DEBUG
-  std::wcout << L"caching frame=" << frame << std::endl;
+  std::wcout << L"releasing frame=" << frame << std::endl;
 #endif    
+}
 
-#ifdef _WIN32
-  LeaveCriticalSection(&cached_frames_cs);
-#else
-  pthread_mutex_unlock(&cached_frames_mutex);
-#endif
+FrameSegment* Runtime::StackInterpreter::NextFrameSegment()
+{
+  // segments are kept once allocated
+  FrameSegment* segment = frame_stack.segment;
+  FrameSegment* next = segment ? segment->next : nullptr;
+  if(!next) {
+    next = (FrameSegment*)malloc(FRAME_SEGMENT_SIZE);
+    if(!next) {
+      std::wcerr << L">>> Unable to allocate call frames <<<" << std::endl;
+      exit(1);
+    }
+    next->prev = segment;
+    next->next = nullptr;
+    next->end = (char*)next + FRAME_SEGMENT_SIZE;
+    if(segment) {
+      segment->next = next;
+    }
+  }
+  next->top = (char*)(next + 1);
+  frame_stack.segment = next;
+
+  return next;
+}
+
+void Runtime::FrameStack::Free()
+{
+  if(segment) {
+    // rewind to the first segment
+    while(segment->prev) {
+      segment = segment->prev;
+    }
+
+    while(segment) {
+      FrameSegment* next = segment->next;
+      free(segment);
+      segment = next;
+    }
+  }
 }
 
 void Runtime::StackInterpreter::StackErrorUnwind()
@@ -53,9 +53,30 @@ namespace Runtime {
   class Debugger;
 #endif
   
-#define FRAME_CACHE_SIZE 24
+#define FRAME_SEGMENT_SIZE (64 * 1024)
 #define CALL_STACK_SIZE 1024
 #define OP_STACK_SIZE 128
+#define JIT_CALL_THRESHOLD 1000
+#define JIT_LOOP_THRESHOLD 10000
+
+  //
+  // direct threaded dispatch (computed goto) where the compiler supports
+  // labels as values, define _NO_THREADED to build with the switch only
+  //
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_NO_THREADED) && !defined(_DEBUGGER)
+#define _THREADED
+#endif
+
+#ifdef _THREADED
+#define DISPATCH_CASE(t) case t: t##_LABEL
+#define DISPATCH() \
+  if(halt) break; \
+  instr = instrs + ip++; \
+  goto *dispatch_table[instr->GetType()]
+#else
+#define DISPATCH_CASE(t) case t
+#define DISPATCH() break
+#endif
 
   // holds the calling context for async
   // method calls
@@ -64,6 +85,29 @@ namespace Runtime {
     size_t* self;
     size_t* param;
   };
+
+  // block of call frames, each frame is followed by its locals
+  struct FrameSegment {
+    FrameSegment* prev;
+    FrameSegment* next;
+    char* top;
+    char* end;
+  };
+
+  //
+  // per-thread stack of frame segments. frames are released in the
+  // reverse order they were taken, including by nested interpreters
+  // running callbacks on the same thread.
+  //
+  struct FrameStack {
+    FrameSegment* segment;
+
+    void Free();
+
+    ~FrameStack() {
+      Free();
+    }
+  };
   
   //
   // StackInterpreter
@@ -72,20 +116,27 @@ namespace Runtime {
     // program
     static StackProgram* program;
     static std::set<StackInterpreter*> intpr_threads;
-    static std::stack<StackFrame*> cached_frames;
+    static thread_local FrameStack frame_stack;
 
 #ifdef _WIN32
     static bool is_stdio_binary;
 #endif
 
 #ifdef _WIN32
-    static CRITICAL_SECTION cached_frames_cs;
     static CRITICAL_SECTION intpr_threads_cs;
 #else
-    static pthread_mutex_t cached_frames_mutex;
     static pthread_mutex_t intpr_threads_mutex;
 #endif
 
+    // calls and backward jumps before a method is JIT compiled, zero to disable
+    static long jit_call_threshold;
+    static long jit_loop_threshold;
+#ifdef _WIN32
+    static CRITICAL_SECTION jit_cs;
+#else
+    static pthread_mutex_t jit_mutex;
+#endif
+
     // call stack and current frame pointer
     StackFrame** call_stack;
     long* call_stack_pos;
@@ -109,6 +160,11 @@ namespace Runtime {
     // release stack frame
     //
     static void ReleaseStackFrame(StackFrame* frame);
+
+    //
+    // moves to the next frame segment, allocating it if needed
+    //
+    static FrameSegment* NextFrameSegment();
     
     //
     // push call frame
@@ -266,6 +322,9 @@ namespace Runtime {
     void inline CopyClsInstIntVar(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
     void inline LoadLoclIntVar(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
     void inline LoadClsInstIntVar(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
+    void inline LoadSelfIntVar(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
+    void inline IncLoclIntVar(StackInstr* instr);
+    void inline CmpJmpLoclIntVar(StackInstr* instr, long &ip, size_t* &op_stack, long* &stack_pos);
 
     void inline Str2Int(size_t* &op_stack, long* &stack_pos);
     void inline Str2Float(size_t* &op_stack, long* &stack_pos);
@@ -321,14 +380,19 @@ namespace Runtime {
     inline void ProcessNewCharArray(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
     inline void ProcessNewObjectInstance(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
     inline void ProcessNewFunctionInstance(StackInstr* instr, size_t*& op_stack, long*& stack_pos);
-    inline void ProcessReturn(StackInstr** &instrs, long &ip);
-
-    inline void ProcessMethodCall(StackInstr* instr, StackInstr** &instrs, long &ip, size_t* &op_stack, long* &stack_pos);
-    inline void ProcessDynamicMethodCall(StackInstr* instr, StackInstr** &instrs, long &ip, size_t* &op_stack, long* &stack_pos);
-    inline void ProcessJitMethodCall(StackMethod* called, size_t* instance, StackInstr** &instrs, long &ip, size_t* &op_stack, long* &stack_pos);
+    inline void ProcessReturn(StackInstr* &instrs, long &ip);
+
+    inline void ProcessMethodCall(StackInstr* instr, StackInstr* &instrs, long &ip, size_t* &op_stack, long* &stack_pos);
+    static StackMethod* BindVirtualCall(StackInstr* instr, StackMethod* concrete_call, StackClass* concrete_class);
+    inline void ProcessDynamicMethodCall(StackInstr* instr, StackInstr* &instrs, long &ip, size_t* &op_stack, long* &stack_pos);
+    inline void ProcessJitMethodCall(StackMethod* called, size_t* instance, StackInstr* &instrs, long &ip, size_t* &op_stack, long* &stack_pos);
+    static inline bool IsJitCall(StackInstr* instr, StackMethod* called);
+    static bool JitCompile(StackMethod* called);
+    inline long ProcessLoopJump(long target, size_t* &op_stack, long* &stack_pos);
+    void JitError(StackMethod* called, const long status);
     inline void ProcessAsyncMethodCall(StackMethod* called, size_t* param);
 
-    inline void ProcessInterpretedMethodCall(StackMethod* called, size_t* instance, StackInstr** &instrs, long &ip);
+    inline void ProcessInterpretedMethodCall(StackMethod* called, size_t* instance, StackInstr* &instrs, long &ip);
     inline void ProcessLoadIntArrayElement(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
     inline void ProcessStoreIntArrayElement(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
     inline void ProcessLoadFloatArrayElement(StackInstr* instr, size_t* &op_stack, long* &stack_pos);
@@ -423,14 +487,15 @@ namespace Runtime {
     
     // free static resources
     static void Clear() {
-      while(!cached_frames.empty()) {
-        StackFrame* frame = cached_frames.top();
-        cached_frames.pop();
-        free(frame->mem);
-        delete frame;
-      }
+      frame_stack.Free();
     }
 
+#ifndef _NO_JIT
+    // calls a method from JIT code, false if the callee has no native code
+    static bool JitMethodCall(StackInstr* instr, size_t* op_stack, long* stack_pos, 
+                              StackFrame** call_stack, long* call_stack_pos);
+#endif
+
 #ifdef _WIN32
     static unsigned int WINAPI AsyncMethodCall(LPVOID arg);
 #else
@@ -442,6 +507,7 @@ namespace Runtime {
       call_stack = c;
       call_stack_pos = cp;
       frame = new StackFrame*;
+      *frame = nullptr;
       monitor = nullptr;
       
       MemoryManager::AddPdaMethodRoot(frame);
@@ -453,6 +519,7 @@ namespace Runtime {
       call_stack_pos = new long;
       *call_stack_pos = -1;
       frame = new StackFrame*;
+      *frame = nullptr;
 
       // register monitor
       monitor = new StackFrameMonitor;
@@ -470,6 +537,7 @@ namespace Runtime {
       call_stack_pos = new long;
       *call_stack_pos = -1;
       frame = new StackFrame*;
+      *frame = nullptr;
 
       // register monitor
       monitor = new StackFrameMonitor;
@@ -496,6 +564,7 @@ namespace Runtime {
       call_stack_pos = new long;
       *call_stack_pos = -1;
       frame = new StackFrame*;
+      *frame = nullptr;
 
       // register monitor
       monitor = new StackFrameMonitor;
@@ -34,6 +34,12 @@
 #include "../shared/version.h"
 
 StackProgram* Loader::program;
+Loader* Loader::lazy_loader;
+#ifdef _WIN32
+CRITICAL_SECTION Loader::lazy_cs;
+#else
+pthread_mutex_t Loader::lazy_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 StackProgram* Loader::GetProgram() {
   return program;
@@ -69,12 +75,21 @@ void Loader::Load()
   const int magic_num = ReadInt();
   switch(magic_num) {
   case MAGIC_NUM_LIB:
+  case MAGIC_NUM_LIB_INDEX:
     std::wcerr << L"Unable to use execute shared library '" << filename << L"'." << std::endl;
     exit(1);
 
   case MAGIC_NUM_EXE:
     break;
 
+  case MAGIC_NUM_EXE_MAP:
+    code_buffer = alloc_buffer + ReadUnsigned();
+    lazy_loader = this;
+#ifdef _WIN32
+    InitializeCriticalSection(&lazy_cs);
+#endif
+    break;
+
   default:
     std::wcerr << L"Unknown file type for '" << filename << L"'." << std::endl;
     exit(1);
@@ -182,10 +197,17 @@ void Loader::Load()
   dclrs[0]->name = L"args";
   dclrs[0]->type = OBJ_ARY_PARM;
 
-  init_method = new StackMethod(-1, name, false, false, false, dclrs,  1, 0, 1, NIL_TYPE, nullptr);
+  init_method = new StackMethod(-1, name, false, false, false, dclrs,  1, 0, sizeof(INT64_VALUE), NIL_TYPE, nullptr);
   LoadInitializationCode(init_method);
   program->SetInitializationMethod(init_method);
   program->SetStringObjectId(string_cls_id);
+  if(is_mapped) {
+    // hashed on first use, rather than reading every page at startup
+    program->SetFileImage(alloc_buffer, buffer_size);
+  }
+  else {
+    program->SetFileHash(file_hash);
+  }
 }
 
 char* Loader::LoadFileBuffer(std::wstring filename, size_t& buffer_size)
@@ -199,10 +221,21 @@ char* Loader::LoadFileBuffer(std::wstring filename, size_t& buffer_size)
     in.seekg(0, std::ios::end);
     buffer_size = (size_t)in.tellg();
     in.seekg(0, std::ios::beg);
+
+    // uncompressed executable with method code decoded on first use
+    int32_t header[2] = { 0, 0 };
+    in.read((char*)header, sizeof(header));
+    in.seekg(0, std::ios::beg);
+    if(header[0] == VER_NUM && header[1] == MAGIC_NUM_EXE_MAP) {
+      is_mapped = true;
+      return MapFileBuffer(in, open_filename, buffer_size);
+    }
+
     buffer = (char*)calloc(buffer_size + 1, sizeof(char));
     in.read(buffer, buffer_size);
     // close file
     in.close();
+    file_hash = HashBytes(buffer, buffer_size);
 
     uLong dest_len;
     char* out = OutputStream::UncompressZlib(buffer, (uLong)buffer_size, dest_len);
@@ -226,6 +259,36 @@ char* Loader::LoadFileBuffer(std::wstring filename, size_t& buffer_size)
   return nullptr;
 }
 
+char* Loader::MapFileBuffer(std::ifstream &in, const std::string &open_filename, size_t buffer_size)
+{
+#ifdef _WIN32
+  // read as is, no inflate
+  char* buffer = (char*)calloc(buffer_size + 1, sizeof(char));
+  in.read(buffer, buffer_size);
+  in.close();
+#else
+  in.close();
+
+  const int fd = open(open_filename.c_str(), O_RDONLY);
+  if(fd < 0) {
+    std::wcerr << L"Unable to open file: '" << filename << L"'" << std::endl;
+    exit(1);
+  }
+
+  char* buffer = (char*)mmap(nullptr, buffer_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(buffer == MAP_FAILED) {
+    std::wcerr << L"Unable to map file: '" << filename << L"'" << std::endl;
+    exit(1);
+  }
+#endif
+#ifdef _DEBUG
+  std::wcout << L"--- file in: mapped=" << buffer_size << L" ---" << std::endl;
+#endif
+
+  return buffer;
+}
+
 void Loader::LoadClasses()
 {
   const int num_classes = ReadInt();
@@ -418,7 +481,12 @@ void Loader::LoadMethods(StackClass* cls, bool is_debug)
     << rtrn_name << L"'; params=" << params << L"; bytes=" 
     << mem_size << std::endl;
 #endif    
-    LoadStatements(mthd, is_debug);
+    if(code_buffer) {
+      mthd->SetLazyCode(code_buffer + ReadUnsigned(), is_debug);
+    }
+    else {
+      LoadStatements(mthd, is_debug);
+    }
 
     // add method
 #ifdef _DEBUG
@@ -464,6 +532,27 @@ void Loader::LoadInitializationCode(StackMethod* method)
   method->SetInstructions(mthd_instrs, (int)instrs.size());
 }
 
+void Loader::LoadLazyStatements(StackMethod* method, const char* code, bool is_debug)
+{
+#ifdef _WIN32
+  EnterCriticalSection(&lazy_cs);
+#else
+  pthread_mutex_lock(&lazy_mutex);
+#endif
+  // another thread may have decoded the method while waiting
+  if(method->HasLazyCode()) {
+    char* saved_buffer = lazy_loader->buffer;
+    lazy_loader->buffer = (char*)code;
+    lazy_loader->LoadStatements(method, is_debug);
+    lazy_loader->buffer = saved_buffer;
+  }
+#ifdef _WIN32
+  LeaveCriticalSection(&lazy_cs);
+#else
+  pthread_mutex_unlock(&lazy_mutex);
+#endif
+}
+
 void Loader::LoadStatements(StackMethod* method, bool is_debug)
 {
   int line_num = -1;
@@ -802,6 +891,95 @@ void Loader::LoadStatements(StackMethod* method, bool is_debug)
     }
   }
 
+#ifndef _DEBUGGER
+  FuseInstructions(mthd_instrs, num_instrs);
+#endif
+
   // copy and set instructions
   method->SetInstructions(mthd_instrs, num_instrs);
 }
+
+/********************************
+ * Replaces the first instruction of common
+ * sequences with a superinstruction. The rest
+ * of the sequence is kept in place, so jump
+ * indexes are unchanged; the interpreter steps
+ * over it and the JIT compiles it as before.
+ ********************************/
+void Loader::FuseInstructions(StackInstr** instrs, const unsigned long num_instrs)
+{
+  for(unsigned long i = 0; i + 1 < num_instrs; ++i) {
+    StackInstr* instr = instrs[i];
+    StackInstr* next_instr = instrs[i + 1];
+
+    // load an instance variable of 'self'
+    if(instr->GetType() == LOAD_INST_MEM && next_instr->GetType() == LOAD_CLS_INST_INT_VAR &&
+       next_instr->GetOperand2() == INST) {
+      instrs[i] = new StackInstr(instr->GetLineNumber(), LOAD_SELF_INT_VAR, next_instr->GetOperand(), INST);
+      delete instr;
+      i++;
+      continue;
+    }
+
+    if(i + 3 >= num_instrs) {
+      continue;
+    }
+    StackInstr* oper_instr = instrs[i + 2];
+    StackInstr* last_instr = instrs[i + 3];
+
+    // add a literal to a local, rewritten as 'LOAD x, LOAD k, ADD, STOR x'
+    if(last_instr->GetType() == STOR_LOCL_INT_VAR) {
+      StackInstr* var_instr = nullptr;
+      StackInstr* lit_instr = nullptr;
+      if(instr->GetType() == LOAD_INT_LIT && next_instr->GetType() == LOAD_LOCL_INT_VAR &&
+         (oper_instr->GetType() == ADD_INT || oper_instr->GetType() == SUB_INT)) {
+        lit_instr = instr;
+        var_instr = next_instr;
+      }
+      else if(instr->GetType() == LOAD_LOCL_INT_VAR && next_instr->GetType() == LOAD_INT_LIT &&
+              oper_instr->GetType() == ADD_INT) {
+        var_instr = instr;
+        lit_instr = next_instr;
+      }
+
+      if(var_instr && var_instr->GetOperand() == last_instr->GetOperand()) {
+        INT64_VALUE value = lit_instr->GetInt64Operand();
+        if(oper_instr->GetType() == SUB_INT) {
+          if(value == std::numeric_limits<INT64_VALUE>::min()) {
+            continue;
+          }
+          value = -value;
+        }
+
+        const int line_num = instr->GetLineNumber();
+        instrs[i] = new StackInstr(line_num, INC_LOCL_INT_VAR, var_instr->GetOperand(), LOCL);
+        instrs[i + 1] = new StackInstr(line_num, value);
+        instrs[i + 2] = cached_instrs[ADD_INT];
+        delete instr;
+        delete next_instr;
+        i += 3;
+        continue;
+      }
+    }
+
+    // compare two locals and branch
+    if(instr->GetType() == LOAD_LOCL_INT_VAR && next_instr->GetType() == LOAD_LOCL_INT_VAR &&
+       last_instr->GetType() == JMP && last_instr->GetOperand2() > -1) {
+      switch(oper_instr->GetType()) {
+      case EQL_INT:
+      case NEQL_INT:
+      case LES_INT:
+      case GTR_INT:
+      case LES_EQL_INT:
+      case GTR_EQL_INT:
+        instrs[i] = new StackInstr(instr->GetLineNumber(), CMP_JMP_LOCL_INT_VAR, instr->GetOperand(), LOCL);
+        delete instr;
+        i += 3;
+        break;
+
+      default:
+        break;
+      }
+    }
+  }
+}
@@ -34,9 +34,20 @@
 
 #include "common.h"
 #include <string.h>
+#include <limits>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
 
 class Loader {
   static StackProgram* program;
+  static Loader* lazy_loader;
+#ifdef _WIN32
+  static CRITICAL_SECTION lazy_cs;
+#else
+  static pthread_mutex_t lazy_mutex;
+#endif
   StackInstr** cached_instrs;
   std::vector<std::wstring> arguments;
   int num_float_strings;
@@ -49,6 +60,10 @@ class Loader {
   char* alloc_buffer;
   size_t buffer_size;
   size_t buffer_pos;
+  uint64_t file_hash;
+  // method code section of a mapped executable
+  char* code_buffer;
+  bool is_mapped;
   int start_class_id;
   int start_method_id;
   std::map<const std::wstring, const int> params;
@@ -119,9 +134,13 @@ class Loader {
 
   // loads a file into memory
   char* LoadFileBuffer(std::wstring filename, size_t &buffer_size);
+  // maps an uncompressed executable into memory
+  char* MapFileBuffer(std::ifstream &in, const std::string &open_filename, size_t buffer_size);
 
   void ReadFile() {
     buffer_pos = 0;
+    code_buffer = nullptr;
+    is_mapped = false;
     alloc_buffer = buffer = LoadFileBuffer(filename, buffer_size);
   }
 
@@ -131,6 +150,7 @@ class Loader {
   StackDclr** LoadDeclarations(const int num_dclrs, const bool is_debug);
   void LoadInitializationCode(StackMethod* mthd);
   void LoadStatements(StackMethod* mthd, bool is_debug);
+  void FuseInstructions(StackInstr** instrs, const unsigned long num_instrs);
   void LoadConfiguration();
   
 public:
@@ -141,6 +161,9 @@ public:
 
     string_cls_id = -1;
     buffer_pos = 0;
+    file_hash = 0;
+    code_buffer = nullptr;
+    is_mapped = false;
     alloc_buffer = buffer = b;
     program = new StackProgram;
   }
@@ -175,8 +198,21 @@ public:
   }
 
   ~Loader() {
+    if(lazy_loader == this) {
+      lazy_loader = nullptr;
+    }
+
     if(!from_mem && alloc_buffer) {
+#ifndef _WIN32
+      if(is_mapped) {
+        munmap(alloc_buffer, buffer_size);
+      }
+      else {
+        free(alloc_buffer);
+      }
+#else
       free(alloc_buffer);
+#endif
       alloc_buffer = nullptr;
     }
 
@@ -303,6 +339,9 @@ public:
 
   static StackProgram* GetProgram();
 
+  // decodes the instructions of a method from a mapped executable
+  static void LoadLazyStatements(StackMethod* mthd, const char* code, bool is_debug);
+
   StackMethod* GetStartMethod() {
     StackClass* cls = program->GetClass(start_class_id);
     if(cls) {